@@ -0,0 +1,92 @@
+/*
+ * File:   blockedSegments.cpp
+ * Author: georg157
+ *
+ * Closed street segments the path searches route around (see blockedSegments.h)
+ */
+
+#include "blockedSegments.h"
+#include "StreetsDatabaseAPI.h"
+
+blockedSegments::blockedSegments() {
+    count = 0;
+}
+
+blockedSegments::blockedSegments(const blockedSegments& base, const std::vector<int>& block, const std::vector<int>& unblock) {
+    words = base.words;
+    words.resize((getNumStreetSegments() + 63) / 64, 0);
+
+    for (std::vector<int>::const_iterator it = block.begin(); it != block.end(); ++it){
+        if (*it >= 0 && *it < getNumStreetSegments())
+            words[*it >> 6] |= (std::uint64_t) 1 << (*it & 63);
+    }
+    for (std::vector<int>::const_iterator it = unblock.begin(); it != unblock.end(); ++it){
+        if (*it >= 0 && *it < getNumStreetSegments())
+            words[*it >> 6] &= ~((std::uint64_t) 1 << (*it & 63));
+    }
+
+    count = 0;
+    for (unsigned i = 0; i < words.size(); i++){
+        count += __builtin_popcountll(words[i]);
+    }
+}
+
+blockedSegments::~blockedSegments() {
+}
+
+unsigned blockedSegments::size() const{
+    return count;
+}
+
+std::vector<int> blockedSegments::segments() const{
+    std::vector<int> closed;
+    closed.reserve(count);
+    for (unsigned i = 0; i < words.size(); i++){
+        for (std::uint64_t word = words[i]; word != 0; word &= word - 1){
+            closed.push_back(i*64 + __builtin_ctzll(word));
+        }
+    }
+    return closed;
+}
+
+segmentClosures::segmentClosures() : updates(0) {
+}
+
+segmentClosures::~segmentClosures() {
+}
+
+void segmentClosures::block(const std::vector<int>& segmentIDs){
+    update(segmentIDs, std::vector<int>());
+}
+
+void segmentClosures::unblock(const std::vector<int>& segmentIDs){
+    update(std::vector<int>(), segmentIDs);
+}
+
+void segmentClosures::clear(){
+    std::lock_guard<std::mutex> guard(updateLock);
+    std::atomic_store(&current, std::shared_ptr<const blockedSegments>());
+    updates++;
+}
+
+void segmentClosures::update(const std::vector<int>& block, const std::vector<int>& unblock){
+    std::lock_guard<std::mutex> guard(updateLock);
+
+    std::shared_ptr<const blockedSegments> base = std::atomic_load(&current);
+    std::shared_ptr<const blockedSegments> next = std::make_shared<blockedSegments>(base ? *base : blockedSegments(), block, unblock);
+
+    //searches skip the closure checks entirely when nothing is closed
+    if (next->size() == 0)
+        next.reset();
+
+    std::atomic_store(&current, next);
+    updates++;
+}
+
+std::shared_ptr<const blockedSegments> segmentClosures::snapshot() const{
+    return std::atomic_load(&current);
+}
+
+unsigned long segmentClosures::version() const{
+    return updates;
+}
@@ -0,0 +1,95 @@
+/*
+ * File:   blockedSegments.h
+ * Author: georg157
+ *
+ * Closed street segments (construction, incidents) that the path searches route around, without changing the map
+ * Closures are kept as bitmaps (one bit per segment): global ones, replaced as a whole snapshot so running queries
+ * are unaffected by an update, and optional ones of a single query (see routingContext::setQueryClosures)
+ */
+
+#ifndef BLOCKEDSEGMENTS_H
+#define BLOCKEDSEGMENTS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//One set of closed segments, never changed once built
+class blockedSegments{
+    public:
+        //no segment closed
+        blockedSegments();
+
+        //segments of base, plus those of block, minus those of unblock (IDs outside the map are ignored)
+        blockedSegments(const blockedSegments& base, const std::vector<int>& block, const std::vector<int>& unblock);
+
+        ~blockedSegments();
+
+        //Returns: true if the segment is closed (one bit test, called on every segment a search relaxes)
+        bool contains(int segmentID) const{
+            return ((unsigned) segmentID >> 6) < words.size() && (words[(unsigned) segmentID >> 6] >> (segmentID & 63)) & 1;
+        }
+
+        //Returns: number of segments closed
+        unsigned size() const;
+
+        //Returns: closed segments, ascending
+        std::vector<int> segments() const;
+
+    private:
+        //bit s%64 of words[s/64] is set if segment s is closed
+        std::vector<std::uint64_t> words;
+        unsigned count;
+};
+
+//Closures a search honours: the global ones and those of its query (either may be null, when nothing is closed)
+struct closureView{
+    const blockedSegments* global;
+    const blockedSegments* query;
+
+    closureView() : global(nullptr), query(nullptr) {}
+
+    bool closed(int segmentID) const{
+        return (global != nullptr && global->contains(segmentID)) || (query != nullptr && query->contains(segmentID));
+    }
+
+    bool any() const{
+        return global != nullptr || query != nullptr;
+    }
+};
+
+//The global closures, updated atomically while queries run
+class segmentClosures{
+    public:
+        segmentClosures();
+
+        ~segmentClosures();
+
+        void block(const std::vector<int>& segmentIDs);
+
+        void unblock(const std::vector<int>& segmentIDs);
+
+        //Reopens every segment
+        void clear();
+
+        //Returns: current closures (null if no segment is closed), a query keeps the snapshot it started with
+        std::shared_ptr<const blockedSegments> snapshot() const;
+
+        //Returns: number of updates so far
+        unsigned long version() const;
+
+    private:
+        void update(const std::vector<int>& block, const std::vector<int>& unblock);
+
+        //serializes updates (readers never wait on it)
+        std::mutex updateLock;
+
+        //read and replaced with std::atomic_load / std::atomic_store
+        std::shared_ptr<const blockedSegments> current;
+
+        std::atomic<unsigned long> updates;
+};
+
+#endif /* BLOCKEDSEGMENTS_H */
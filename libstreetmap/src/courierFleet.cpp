@@ -0,0 +1,615 @@
+/*
+ * File:   courierFleet.cpp
+ * Author: georg157
+ *
+ * Multi-truck courier planning (see courierFleet.h)
+ * Stops are numbered per delivery: stop 2*i is the pick up of delivery i, stop 2*i + 1 its drop off
+ * A route is the list of stops a truck makes, its depots are the nearest to its first and from its last stop
+ */
+
+#include "courierFleet.h"
+#include "m3.h"
+#include "m3A.h"
+#include "globals.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+#define FLEET_UNREACHABLE 1e12 //time between two stops with no path (kept finite, so time differences stay numbers)
+#define FLEET_EPSILON 1e-6 //seconds, smaller differences are no improvement
+
+//travel times of the planning problem, read-only once built (shared by every thread)
+struct fleetProblem{
+    unsigned numNodes;
+
+    //Vector --> key: [from node * numNodes + to node] value: [travel time, seconds] (nodes: distinct stop and depot intersections)
+    std::vector<double> times;
+
+    //Vector --> key: [stop] value: [node / load change (pick up: + weight, drop off: - weight)]
+    std::vector<int> stopNode;
+    std::vector<float> stopLoad;
+
+    //Vector --> key: [stop] value: [fastest time from any depot / nearest such depot]
+    std::vector<double> startTime;
+    std::vector<int> startDepot;
+
+    //Vector --> key: [stop] value: [fastest time to any depot / nearest such depot]
+    std::vector<double> endTime;
+    std::vector<int> endDepot;
+
+    float capacity;
+
+    //Returns: time from stop fromStop to stop toStop, -1 is the route's depot (at either end)
+    double arc(int fromStop, int toStop) const{
+        if (fromStop < 0)
+            return (toStop < 0) ? 0 : startTime[toStop];
+        if (toStop < 0)
+            return endTime[fromStop];
+        return times[stopNode[fromStop]*numNodes + stopNode[toStop]];
+    }
+};
+
+//value of a plan, compared primary first
+struct fleetCost{
+    double primary;
+    double secondary;
+
+    bool betterThan(const fleetCost& other) const{
+        if (primary < other.primary - FLEET_EPSILON)
+            return true;
+        return primary <= other.primary + FLEET_EPSILON && secondary < other.secondary - FLEET_EPSILON;
+    }
+};
+
+//a change of one or two routes, see improve_fleet
+struct fleetMove{
+    fleetCost cost; //plan after the move
+    int delivery;
+    int other; //delivery exchanged with, -1 if delivery is only relocated
+    int toRoute;
+    bool valid;
+};
+
+//Dijkstra workspace of one thread, stamped per search
+struct fleetSearch{
+    std::vector<double> time;
+    std::vector<unsigned> stamp;
+    unsigned run;
+};
+
+//Times from sourceID to every node (row[node]), one search stopped once every node is settled
+//Same driving rules as find_path_djikstra (one-ways, turn penalty when the street changes, closures)
+static void one_to_many_times(int sourceID, const std::vector<int>& nodeOf, unsigned numNodes, double turnPenalty,
+                              const closureView& closures, fleetSearch& search, double* row){
+    if (search.stamp.size() != nodeOf.size() || search.run == 0xFFFFFFFF){
+        search.time.assign(nodeOf.size(), 0);
+        search.stamp.assign(nodeOf.size(), 0);
+        search.run = 0;
+    }
+    search.run++;
+
+    //(travel time from the source, (intersection ID, reaching edge)), smallest time first
+    typedef std::pair<double, std::pair<int, int>> fleetWave;
+    std::priority_queue<fleetWave, std::vector<fleetWave>, std::greater<fleetWave>> waveQueue;
+    waveQueue.push(std::make_pair(0.0, std::make_pair(sourceID, -1)));
+
+    unsigned nodesLeft = numNodes;
+    while (!waveQueue.empty() && nodesLeft > 0){
+        double travelTime = waveQueue.top().first;
+        int currID = waveQueue.top().second.first;
+        int reachingEdge = waveQueue.top().second.second;
+        waveQueue.pop();
+
+        if (search.stamp[currID] == search.run)
+            continue;
+        search.stamp[currID] = search.run;
+        search.time[currID] = travelTime;
+
+        if (nodeOf[currID] >= 0){
+            row[nodeOf[currID]] = travelTime;
+            nodesLeft--;
+        }
+
+        int reachingStreetID = (reachingEdge == -1) ? -1 : SegmentStreetID[reachingEdge];
+
+        const std::vector<int>& outEdges = IntersectionStreetSegments[currID];
+        for (std::vector<int>::const_iterator edgeIt = outEdges.begin(); edgeIt != outEdges.end(); edgeIt++){
+            if (closures.closed(*edgeIt))
+                continue;
+            InfoStreetSegment segStruct = getInfoStreetSegment(*edgeIt);
+            int toID;
+            if (segStruct.to == currID){
+                if (segStruct.oneWay)
+                    continue;
+                toID = segStruct.from;
+            }
+            else
+                toID = segStruct.to;
+
+            if (search.stamp[toID] == search.run)
+                continue;
+
+            double addTurnPenalty = (reachingEdge != -1 && segStruct.streetID != reachingStreetID) ? turnPenalty : 0;
+            waveQueue.push(std::make_pair(travelTime + SegmentTravelTime[*edgeIt] + addTurnPenalty, std::make_pair(toID, *edgeIt)));
+        }
+    }
+}
+
+static double route_time(const fleetProblem& problem, const std::vector<int>& route){
+    if (route.empty())
+        return 0;
+
+    double travelTime = problem.arc(-1, route.front());
+    for (unsigned i = 1; i < route.size(); i++){
+        travelTime += problem.arc(route[i - 1], route[i]);
+    }
+    return travelTime + problem.arc(route.back(), -1);
+}
+
+//Returns: true if the truck never carries more than its capacity along route
+static bool route_load_feasible(const fleetProblem& problem, const std::vector<int>& route){
+    float load = 0;
+    for (unsigned i = 0; i < route.size(); i++){
+        load += problem.stopLoad[route[i]];
+        if (load > problem.capacity)
+            return false;
+    }
+    return true;
+}
+
+//Cheapest insertion of delivery into route: its pick up before route[pickUpAt], its drop off before route[dropOffAt]
+//(pickUpAt <= dropOffAt, route.size() is the end), capacity respected
+//Returns: time added (FLEET_UNREACHABLE or more if delivery fits nowhere)
+static double best_insertion(const fleetProblem& problem, const std::vector<int>& route, int delivery, int& pickUpAt, int& dropOffAt){
+    int pickUp = 2*delivery;
+    int dropOff = 2*delivery + 1;
+    float weight = problem.stopLoad[pickUp];
+    int size = route.size();
+
+    //Vector --> key: [position] value: [load before the stop at that position]
+    std::vector<float> loadBefore(size + 1, 0);
+    for (int i = 0; i < size; i++){
+        loadBefore[i + 1] = loadBefore[i] + problem.stopLoad[route[i]];
+    }
+
+    double bestAdded = FLEET_UNREACHABLE;
+    pickUpAt = -1;
+    dropOffAt = -1;
+    for (int i = 0; i <= size; i++){
+        if (loadBefore[i] + weight > problem.capacity)
+            continue;
+
+        int before = (i > 0) ? route[i - 1] : -1;
+        int after = (i < size) ? route[i] : -1;
+
+        //both stops together
+        double added = problem.arc(before, pickUp) + problem.arc(pickUp, dropOff) + problem.arc(dropOff, after) - problem.arc(before, after);
+        if (added < bestAdded){
+            bestAdded = added;
+            pickUpAt = i;
+            dropOffAt = i;
+        }
+
+        //drop off further on, the item is carried past every stop in between
+        double pickUpAdded = problem.arc(before, pickUp) + problem.arc(pickUp, after) - problem.arc(before, after);
+        float maxLoad = loadBefore[i];
+        for (int j = i + 1; j <= size; j++){
+            maxLoad = std::max(maxLoad, loadBefore[j]);
+            if (maxLoad + weight > problem.capacity)
+                break;
+
+            int dropBefore = route[j - 1];
+            int dropAfter = (j < size) ? route[j] : -1;
+            added = pickUpAdded + problem.arc(dropBefore, dropOff) + problem.arc(dropOff, dropAfter) - problem.arc(dropBefore, dropAfter);
+            if (added < bestAdded){
+                bestAdded = added;
+                pickUpAt = i;
+                dropOffAt = j;
+            }
+        }
+    }
+    return bestAdded;
+}
+
+static void insert_delivery(std::vector<int>& route, int delivery, int pickUpAt, int dropOffAt){
+    route.insert(route.begin() + dropOffAt, 2*delivery + 1);
+    route.insert(route.begin() + pickUpAt, 2*delivery);
+}
+
+static void remove_delivery(std::vector<int>& route, int delivery){
+    route.erase(std::remove_if(route.begin(), route.end(), [delivery](int stop){ return stop/2 == delivery; }), route.end());
+}
+
+//Returns: cost of the plan whose route times are routeTimes, except route changedA (changedB) taking timeA (timeB)
+static fleetCost fleet_cost(const std::vector<double>& routeTimes, fleetObjective objective,
+                            int changedA = -1, double timeA = 0, int changedB = -1, double timeB = 0){
+    double total = 0;
+    double makespan = 0;
+    for (int i = 0; i < (int) routeTimes.size(); i++){
+        double routeTime = (i == changedA) ? timeA : (i == changedB) ? timeB : routeTimes[i];
+        total += routeTime;
+        makespan = std::max(makespan, routeTime);
+    }
+    if (objective == makespanObjective)
+        return {makespan, total};
+    return {total, makespan};
+}
+
+//Moves single stops within the route while that makes it faster (pick ups stay before their drop offs)
+static void improve_route(const fleetProblem& problem, std::vector<int>& route){
+    int size = route.size();
+    std::vector<int> without;
+
+    for (int round = 0; round < FLEET_MAX_ROUNDS; round++){
+        bool improved = false;
+
+        for (int a = 0; a < size && !improved; a++){
+            int stop = route[a];
+            int before = (a > 0) ? route[a - 1] : -1;
+            int after = (a + 1 < size) ? route[a + 1] : -1;
+            double removed = problem.arc(before, stop) + problem.arc(stop, after) - problem.arc(before, after);
+
+            without = route;
+            without.erase(without.begin() + a);
+            int partnerAt = std::find(without.begin(), without.end(), stop ^ 1) - without.begin();
+
+            //a pick up goes before its drop off (position <= partnerAt), a drop off after its pick up (position > partnerAt)
+            int first = (stop % 2 == 0) ? 0 : partnerAt + 1;
+            int last = (stop % 2 == 0) ? partnerAt : size - 1;
+            for (int b = first; b <= last; b++){
+                if (b == a)
+                    continue;
+
+                int newBefore = (b > 0) ? without[b - 1] : -1;
+                int newAfter = (b < size - 1) ? without[b] : -1;
+                double added = problem.arc(newBefore, stop) + problem.arc(stop, newAfter) - problem.arc(newBefore, newAfter);
+                if (added >= removed - FLEET_EPSILON)
+                    continue;
+
+                std::vector<int> moved = without;
+                moved.insert(moved.begin() + b, stop);
+                if (!route_load_feasible(problem, moved))
+                    continue;
+
+                route.swap(moved);
+                improved = true;
+                break;
+            }
+        }
+        if (!improved)
+            break;
+    }
+}
+
+//Best move of delivery to another route: relocated (cheapest insertion) or exchanged with a neighbouring delivery of that route
+static fleetMove best_fleet_move(const fleetProblem& problem, const std::vector<std::vector<int>>& routes, const std::vector<double>& routeTimes,
+                                 const std::vector<int>& routeOf, const std::vector<std::vector<int>>& neighbours, int delivery,
+                                 fleetObjective objective){
+    fleetMove best;
+    best.cost = fleet_cost(routeTimes, objective);
+    best.delivery = delivery;
+    best.other = -1;
+    best.toRoute = -1;
+    best.valid = false;
+
+    int fromRoute = routeOf[delivery];
+    std::vector<int> fromWithout = routes[fromRoute];
+    remove_delivery(fromWithout, delivery);
+    double fromTime = route_time(problem, fromWithout);
+
+    int pickUpAt, dropOffAt;
+    for (int toRoute = 0; toRoute < (int) routes.size(); toRoute++){
+        if (toRoute == fromRoute)
+            continue;
+        //every empty truck is the same, only the first is tried
+        if (routes[toRoute].empty() && std::find_if(routes.begin(), routes.begin() + toRoute,
+                                                     [](const std::vector<int>& route){ return route.empty(); }) != routes.begin() + toRoute)
+            continue;
+
+        double added = best_insertion(problem, routes[toRoute], delivery, pickUpAt, dropOffAt);
+        if (added >= FLEET_UNREACHABLE)
+            continue;
+
+        fleetCost cost = fleet_cost(routeTimes, objective, fromRoute, fromTime, toRoute, routeTimes[toRoute] + added);
+        if (cost.betterThan(best.cost)){
+            best.cost = cost;
+            best.toRoute = toRoute;
+            best.other = -1;
+            best.valid = true;
+        }
+    }
+
+    for (std::vector<int>::const_iterator other = neighbours[delivery].begin(); other != neighbours[delivery].end(); ++other){
+        int toRoute = routeOf[*other];
+        if (toRoute == fromRoute)
+            continue;
+
+        std::vector<int> toWithout = routes[toRoute];
+        remove_delivery(toWithout, *other);
+
+        double addedTo = best_insertion(problem, toWithout, delivery, pickUpAt, dropOffAt);
+        double addedFrom = best_insertion(problem, fromWithout, *other, pickUpAt, dropOffAt);
+        if (addedTo >= FLEET_UNREACHABLE || addedFrom >= FLEET_UNREACHABLE)
+            continue;
+
+        fleetCost cost = fleet_cost(routeTimes, objective, fromRoute, fromTime + addedFrom,
+                                    toRoute, route_time(problem, toWithout) + addedTo);
+        if (cost.betterThan(best.cost)){
+            best.cost = cost;
+            best.toRoute = toRoute;
+            best.other = *other;
+            best.valid = true;
+        }
+    }
+    return best;
+}
+
+//Rounds of moves between routes: every delivery's best move is found in parallel, then the best moves touching
+//distinct routes are applied, and the routes changed are improved (in parallel)
+static void improve_fleet(const fleetProblem& problem, std::vector<std::vector<int>>& routes, std::vector<int>& routeOf,
+                          const std::vector<std::vector<int>>& neighbours, fleetObjective objective){
+    int numDeliveries = routeOf.size();
+    std::vector<double> routeTimes(routes.size());
+    for (unsigned i = 0; i < routes.size(); i++){
+        routeTimes[i] = route_time(problem, routes[i]);
+    }
+
+    for (int round = 0; round < FLEET_MAX_ROUNDS; round++){
+        std::vector<fleetMove> moves(numDeliveries);
+
+        #pragma omp parallel for schedule(dynamic, 4)
+        for (int delivery = 0; delivery < numDeliveries; delivery++){
+            moves[delivery] = best_fleet_move(problem, routes, routeTimes, routeOf, neighbours, delivery, objective);
+        }
+
+        moves.erase(std::remove_if(moves.begin(), moves.end(), [](const fleetMove& move){ return !move.valid; }), moves.end());
+        if (moves.empty())
+            break;
+        std::sort(moves.begin(), moves.end(), [](const fleetMove& a, const fleetMove& b){ return a.cost.betterThan(b.cost); });
+
+        std::vector<bool> touched(routes.size(), false);
+        std::vector<int> changedRoutes;
+        for (std::vector<fleetMove>::const_iterator move = moves.begin(); move != moves.end(); ++move){
+            int fromRoute = routeOf[move->delivery];
+            if (touched[fromRoute] || touched[move->toRoute])
+                continue;
+
+            std::vector<int> newFrom = routes[fromRoute];
+            std::vector<int> newTo = routes[move->toRoute];
+            int pickUpAt, dropOffAt;
+            remove_delivery(newFrom, move->delivery);
+            if (move->other >= 0){
+                remove_delivery(newTo, move->other);
+                best_insertion(problem, newFrom, move->other, pickUpAt, dropOffAt);
+                insert_delivery(newFrom, move->other, pickUpAt, dropOffAt);
+            }
+            best_insertion(problem, newTo, move->delivery, pickUpAt, dropOffAt);
+            insert_delivery(newTo, move->delivery, pickUpAt, dropOffAt);
+
+            //the move was costed on the plan before this round, check it still improves the plan now
+            double fromTime = route_time(problem, newFrom);
+            double toTime = route_time(problem, newTo);
+            if (!fleet_cost(routeTimes, objective, fromRoute, fromTime, move->toRoute, toTime).betterThan(fleet_cost(routeTimes, objective)))
+                continue;
+
+            routes[fromRoute].swap(newFrom);
+            routes[move->toRoute].swap(newTo);
+            routeTimes[fromRoute] = fromTime;
+            routeTimes[move->toRoute] = toTime;
+            routeOf[move->delivery] = move->toRoute;
+            if (move->other >= 0)
+                routeOf[move->other] = fromRoute;
+
+            touched[fromRoute] = true;
+            touched[move->toRoute] = true;
+            changedRoutes.push_back(fromRoute);
+            changedRoutes.push_back(move->toRoute);
+        }
+        if (changedRoutes.empty())
+            break;
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int i = 0; i < (int) changedRoutes.size(); i++){
+            improve_route(problem, routes[changedRoutes[i]]);
+            routeTimes[changedRoutes[i]] = route_time(problem, routes[changedRoutes[i]]);
+        }
+    }
+}
+
+std::vector<std::vector<CourierSubpath>> traveling_courier_fleet(const std::vector<DeliveryInfo>& deliveries,
+                                                                 const std::vector<int>& depots,
+                                                                 const unsigned num_trucks,
+                                                                 const float turn_penalty,
+                                                                 const float truck_capacity,
+                                                                 const fleetObjective objective){
+    int numDeliveries = deliveries.size();
+    if (numDeliveries == 0 || depots.empty() || num_trucks == 0)
+        return std::vector<std::vector<CourierSubpath>>();
+
+    fleetProblem problem;
+    problem.capacity = truck_capacity;
+    problem.stopNode.resize(2*numDeliveries);
+    problem.stopLoad.resize(2*numDeliveries);
+
+    //nodes: distinct intersections of the stops and depots
+    //Vector --> key: [intersection ID] value: [node, -1 if none]
+    std::vector<int> nodeOf(getNumIntersections(), -1);
+    std::vector<int> nodeIntersections;
+    for (int delivery = 0; delivery < numDeliveries; delivery++){
+        //an item heavier than a truck can't be delivered
+        if (deliveries[delivery].itemWeight > truck_capacity)
+            return std::vector<std::vector<CourierSubpath>>();
+
+        int ends[2] = {deliveries[delivery].pickUp, deliveries[delivery].dropOff};
+        for (int end = 0; end < 2; end++){
+            if (nodeOf[ends[end]] < 0){
+                nodeOf[ends[end]] = nodeIntersections.size();
+                nodeIntersections.push_back(ends[end]);
+            }
+            problem.stopNode[2*delivery + end] = nodeOf[ends[end]];
+        }
+        problem.stopLoad[2*delivery] = deliveries[delivery].itemWeight;
+        problem.stopLoad[2*delivery + 1] = -deliveries[delivery].itemWeight;
+    }
+    for (std::vector<int>::const_iterator depot = depots.begin(); depot != depots.end(); ++depot){
+        if (nodeOf[*depot] < 0){
+            nodeOf[*depot] = nodeIntersections.size();
+            nodeIntersections.push_back(*depot);
+        }
+    }
+    problem.numNodes = nodeIntersections.size();
+
+    //travel time matrix, one search per node in parallel (every thread with its own workspace)
+    problem.times.assign(problem.numNodes*problem.numNodes, FLEET_UNREACHABLE);
+    std::shared_ptr<const blockedSegments> closed = SegmentClosures.snapshot();
+    closureView closures;
+    closures.global = closed.get();
+
+    #pragma omp parallel
+    {
+        fleetSearch search;
+        search.run = 0;
+
+        #pragma omp for schedule(dynamic, 1)
+        for (int node = 0; node < (int) problem.numNodes; node++){
+            one_to_many_times(nodeIntersections[node], nodeOf, problem.numNodes, turn_penalty, closures, search,
+                              &problem.times[node*problem.numNodes]);
+        }
+    }
+
+    problem.startTime.assign(2*numDeliveries, FLEET_UNREACHABLE);
+    problem.startDepot.assign(2*numDeliveries, depots[0]);
+    problem.endTime.assign(2*numDeliveries, FLEET_UNREACHABLE);
+    problem.endDepot.assign(2*numDeliveries, depots[0]);
+    for (int stop = 0; stop < 2*numDeliveries; stop++){
+        for (std::vector<int>::const_iterator depot = depots.begin(); depot != depots.end(); ++depot){
+            double fromDepot = problem.times[nodeOf[*depot]*problem.numNodes + problem.stopNode[stop]];
+            double toDepot = problem.times[problem.stopNode[stop]*problem.numNodes + nodeOf[*depot]];
+            if (fromDepot < problem.startTime[stop]){
+                problem.startTime[stop] = fromDepot;
+                problem.startDepot[stop] = *depot;
+            }
+            if (toDepot < problem.endTime[stop]){
+                problem.endTime[stop] = toDepot;
+                problem.endDepot[stop] = *depot;
+            }
+        }
+    }
+
+    //Vector --> key: [delivery] value: [deliveries with the nearest pick ups, nearest first] (exchange candidates)
+    std::vector<std::vector<int>> neighbours(numDeliveries);
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (int delivery = 0; delivery < numDeliveries; delivery++){
+        std::vector<std::pair<double, int>> byDistance;
+        for (int other = 0; other < numDeliveries; other++){
+            if (other != delivery)
+                byDistance.push_back(std::make_pair(std::min(problem.arc(2*delivery, 2*other), problem.arc(2*other, 2*delivery)), other));
+        }
+        unsigned kept = std::min((unsigned) byDistance.size(), (unsigned) FLEET_SWAP_NEIGHBOURS);
+        std::partial_sort(byDistance.begin(), byDistance.begin() + kept, byDistance.end());
+        for (unsigned i = 0; i < kept; i++){
+            neighbours[delivery].push_back(byDistance[i].second);
+        }
+    }
+
+    //cheapest insertion, the deliveries furthest from the depots first
+    std::vector<int> order(numDeliveries);
+    for (int delivery = 0; delivery < numDeliveries; delivery++){
+        order[delivery] = delivery;
+    }
+    std::sort(order.begin(), order.end(), [&problem](int a, int b){
+        return problem.arc(-1, 2*a) + problem.arc(2*a, 2*a + 1) + problem.arc(2*a + 1, -1) >
+               problem.arc(-1, 2*b) + problem.arc(2*b, 2*b + 1) + problem.arc(2*b + 1, -1);
+    });
+
+    std::vector<std::vector<int>> routes(num_trucks);
+    std::vector<double> routeTimes(num_trucks, 0);
+    std::vector<int> routeOf(numDeliveries, -1);
+    for (std::vector<int>::const_iterator delivery = order.begin(); delivery != order.end(); ++delivery){
+        int bestRoute = -1, bestPickUpAt = -1, bestDropOffAt = -1;
+        fleetCost bestCost = {FLEET_UNREACHABLE, FLEET_UNREACHABLE};
+        bool triedEmpty = false;
+
+        for (unsigned route = 0; route < num_trucks; route++){
+            if (routes[route].empty()){
+                if (triedEmpty)
+                    continue;
+                triedEmpty = true;
+            }
+
+            int pickUpAt, dropOffAt;
+            double added = best_insertion(problem, routes[route], *delivery, pickUpAt, dropOffAt);
+            if (added >= FLEET_UNREACHABLE)
+                continue;
+
+            fleetCost cost = fleet_cost(routeTimes, objective, route, routeTimes[route] + added);
+            if (bestRoute < 0 || cost.betterThan(bestCost)){
+                bestCost = cost;
+                bestRoute = route;
+                bestPickUpAt = pickUpAt;
+                bestDropOffAt = dropOffAt;
+            }
+        }
+
+        //no truck can reach this delivery (or bring it back to a depot)
+        if (bestRoute < 0)
+            return std::vector<std::vector<CourierSubpath>>();
+
+        insert_delivery(routes[bestRoute], *delivery, bestPickUpAt, bestDropOffAt);
+        routeTimes[bestRoute] = route_time(problem, routes[bestRoute]);
+        routeOf[*delivery] = bestRoute;
+    }
+
+    //each truck on its own thread, then exchanges between trucks
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int route = 0; route < (int) num_trucks; route++){
+        improve_route(problem, routes[route]);
+    }
+    improve_fleet(problem, routes, routeOf, neighbours, objective);
+
+    //subpaths: depot, then one per intersection stopped at (consecutive stops at one intersection merged), then depot
+    std::vector<std::vector<CourierSubpath>> fleetRoutes(num_trucks);
+    std::vector<std::pair<int, int>> legs; //(truck, subpath)
+    for (unsigned truck = 0; truck < num_trucks; truck++){
+        const std::vector<int>& route = routes[truck];
+        if (route.empty())
+            continue;
+
+        CourierSubpath leg;
+        leg.start_intersection = problem.startDepot[route.front()];
+        for (unsigned i = 0; i < route.size(); i++){
+            int stopIntersection = nodeIntersections[problem.stopNode[route[i]]];
+            if (stopIntersection != leg.start_intersection){
+                leg.end_intersection = stopIntersection;
+                fleetRoutes[truck].push_back(leg);
+                leg.start_intersection = stopIntersection;
+                leg.pickUp_indices.clear();
+            }
+            if (route[i] % 2 == 0)
+                leg.pickUp_indices.push_back(route[i]/2);
+        }
+        leg.end_intersection = problem.endDepot[route.back()];
+        fleetRoutes[truck].push_back(leg);
+
+        for (unsigned i = 0; i < fleetRoutes[truck].size(); i++){
+            legs.push_back(std::make_pair(truck, i));
+        }
+    }
+
+    //paths of every leg of every truck, in parallel (each thread searches on its own routing context)
+    bool allFound = true;
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int i = 0; i < (int) legs.size(); i++){
+        CourierSubpath& leg = fleetRoutes[legs[i].first][legs[i].second];
+        leg.subpath = find_path_between_intersections(leg.start_intersection, leg.end_intersection, turn_penalty);
+        if (leg.subpath.empty() && leg.start_intersection != leg.end_intersection){
+            #pragma omp critical
+            allFound = false;
+        }
+    }
+    if (!allFound)
+        return std::vector<std::vector<CourierSubpath>>();
+
+    return fleetRoutes;
+}
@@ -0,0 +1,36 @@
+/*
+ * File:   courierFleet.h
+ * Author: georg157
+ *
+ * Multi-truck courier planning, the fleet version of traveling_courier (m4): deliveries are split across trucks that share
+ * the depots, each truck under the same rules (capacity, pick up before drop off, leave from and return to a depot)
+ */
+
+#ifndef COURIERFLEET_H
+#define COURIERFLEET_H
+
+#include "m4.h"
+#include <vector>
+
+#define FLEET_MAX_ROUNDS 200 //improvement rounds at most, per truck (moves within a route) and for the fleet (moves between routes)
+#define FLEET_SWAP_NEIGHBOURS 8 //deliveries (nearest pick ups first) a delivery may be exchanged with
+
+enum fleetObjective {
+    totalTimeObjective = 0, //sum of the trucks' travel times
+    makespanObjective //travel time of the slowest truck (ties broken by the sum)
+};
+
+//Plans the routes of num_trucks trucks, every delivery made by exactly one of them
+//Times between all pick ups, drop offs and depots are computed once, in parallel; routes are then built by cheapest
+//insertion, improved per truck in parallel, and improved between trucks by relocating and exchanging deliveries
+//Returns: one route per truck (same form as traveling_courier's, empty if the truck isn't needed), none if the deliveries
+//can't all be made
+std::vector<std::vector<CourierSubpath>> traveling_courier_fleet(const std::vector<DeliveryInfo>& deliveries,
+                                                                 const std::vector<int>& depots,
+                                                                 const unsigned num_trucks,
+                                                                 const float turn_penalty,
+                                                                 const float truck_capacity,
+                                                                 const fleetObjective objective = totalTimeObjective);
+
+#endif /* COURIERFLEET_H */
+
@@ -0,0 +1,383 @@
+/*
+ * File:   customizableRouter.cpp
+ * Author: georg157
+ *
+ * Driving paths on live segment travel times, over cells customized in parallel (see customizableRouter.h)
+ */
+
+#include "customizableRouter.h"
+#include "globals.h"
+#include "StreetsDatabaseAPI.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+#define OVERLAY_NO_TIME std::numeric_limits<double>::infinity()
+
+//(time, intersection ID), smallest time first
+typedef std::pair<double, int> overlayWave;
+typedef std::priority_queue<overlayWave, std::vector<overlayWave>, std::greater<overlayWave>> overlayQueue;
+
+customizableRouter::overlaySearch::overlaySearch() {
+    run = 0;
+}
+
+void customizableRouter::overlaySearch::prepare(unsigned numIntersections){
+    if (stamp.size() != numIntersections || run == 0xFFFFFFFF){
+        time.assign(numIntersections, 0);
+        parentNode.assign(numIntersections, -1);
+        parentSegment.assign(numIntersections, -1);
+        stamp.assign(numIntersections, 0);
+        run = 0;
+    }
+    run++;
+}
+
+bool customizableRouter::overlaySearch::reached(int intersectionID) const{
+    return stamp[intersectionID] == run;
+}
+
+customizableRouter::customizableRouter() : built(false) {
+}
+
+customizableRouter::~customizableRouter() {
+}
+
+void customizableRouter::clear(){
+    std::lock_guard<std::mutex> guard(updateLock);
+    arcOffsets.clear();
+    arcHead.clear();
+    arcSegment.clear();
+    cellOf.clear();
+    boundaryOffsets.clear();
+    boundaryNodes.clear();
+    boundaryIndex.clear();
+    cliqueOffsets.clear();
+    std::atomic_store(&metric, std::shared_ptr<const overlayMetric>());
+    built = false;
+}
+
+std::shared_ptr<const overlayMetric> customizableRouter::snapshot(){
+    ensureBuilt();
+    return std::atomic_load(&metric);
+}
+
+void customizableRouter::ensureBuilt(){
+    if (built)
+        return;
+
+    std::lock_guard<std::mutex> guard(updateLock);
+    if (built)
+        return;
+
+    build();
+
+    std::shared_ptr<overlayMetric> first = std::make_shared<overlayMetric>();
+    first->segmentTime = SegmentTravelTime;
+    first->cliqueTime.assign(cliqueOffsets.back(), OVERLAY_NO_TIME);
+    first->version = 0;
+    customize(*first, std::vector<int>());
+
+    std::atomic_store(&metric, std::shared_ptr<const overlayMetric>(first));
+    built = true;
+}
+
+void customizableRouter::build(){
+    unsigned numIntersections = getNumIntersections();
+
+    //arcs, in the directions each segment may be driven
+    arcOffsets.assign(numIntersections + 1, 0);
+    arcHead.clear();
+    arcSegment.clear();
+    for (unsigned intersectionID = 0; intersectionID < numIntersections; intersectionID++){
+        arcOffsets[intersectionID] = arcHead.size();
+
+        const std::vector<int>& segments = IntersectionStreetSegments[intersectionID];
+        for (std::vector<int>::const_iterator segIt = segments.begin(); segIt != segments.end(); segIt++){
+            InfoStreetSegment segStruct = getInfoStreetSegment(*segIt);
+            if (segStruct.from == segStruct.to)
+                continue; //a loop never shortens a path
+            if (segStruct.from == (int) intersectionID){
+                arcHead.push_back(segStruct.to);
+                arcSegment.push_back(*segIt);
+            }
+            else if (!segStruct.oneWay){
+                arcHead.push_back(segStruct.from);
+                arcSegment.push_back(*segIt);
+            }
+        }
+    }
+    arcOffsets[numIntersections] = arcHead.size();
+
+    //square cells of the (x,y) plane, numbered in order of first use
+    //Hashtable --> key: [cell column, cell row] value: [cell]
+    std::unordered_map<long long, int> cellNumbers;
+    cellOf.assign(numIntersections, 0);
+    for (unsigned intersectionID = 0; intersectionID < numIntersections; intersectionID++){
+        long long column = (long long) std::floor(IntersectionXY[intersectionID].x / OVERLAY_CELL_SIZE);
+        long long row = (long long) std::floor(IntersectionXY[intersectionID].y / OVERLAY_CELL_SIZE);
+        long long key = (column << 32) ^ (row & 0xFFFFFFFFLL);
+
+        std::unordered_map<long long, int>::iterator cell = cellNumbers.find(key);
+        if (cell == cellNumbers.end())
+            cell = cellNumbers.insert(std::make_pair(key, (int) cellNumbers.size())).first;
+        cellOf[intersectionID] = cell->second;
+    }
+    unsigned numCells = cellNumbers.size();
+
+    //boundary intersections: an end of an arc between two cells
+    std::vector<bool> onBoundary(numIntersections, false);
+    for (unsigned intersectionID = 0; intersectionID < numIntersections; intersectionID++){
+        for (int arc = arcOffsets[intersectionID]; arc < arcOffsets[intersectionID + 1]; arc++){
+            if (cellOf[arcHead[arc]] != cellOf[intersectionID]){
+                onBoundary[intersectionID] = true;
+                onBoundary[arcHead[arc]] = true;
+            }
+        }
+    }
+
+    std::vector<std::vector<int>> cellBoundaries(numCells);
+    for (unsigned intersectionID = 0; intersectionID < numIntersections; intersectionID++){
+        if (onBoundary[intersectionID])
+            cellBoundaries[cellOf[intersectionID]].push_back(intersectionID);
+    }
+
+    boundaryOffsets.assign(numCells + 1, 0);
+    cliqueOffsets.assign(numCells + 1, 0);
+    boundaryNodes.clear();
+    boundaryIndex.assign(numIntersections, -1);
+    for (unsigned cell = 0; cell < numCells; cell++){
+        boundaryOffsets[cell] = boundaryNodes.size();
+        for (unsigned i = 0; i < cellBoundaries[cell].size(); i++){
+            boundaryIndex[cellBoundaries[cell][i]] = i;
+            boundaryNodes.push_back(cellBoundaries[cell][i]);
+        }
+        cliqueOffsets[cell + 1] = cliqueOffsets[cell] + cellBoundaries[cell].size()*cellBoundaries[cell].size();
+    }
+    boundaryOffsets[numCells] = boundaryNodes.size();
+}
+
+void customizableRouter::customize(overlayMetric& customized, const std::vector<int>& cells) const{
+    int numCells = cells.empty() ? (int) boundaryOffsets.size() - 1 : (int) cells.size();
+
+    //cells are independent, each thread searches with its own workspace
+    #pragma omp parallel
+    {
+        overlaySearch search;
+
+        #pragma omp for schedule(dynamic, 4)
+        for (int i = 0; i < numCells; i++){
+            int cell = cells.empty() ? i : cells[i];
+            int first = boundaryOffsets[cell];
+            int size = boundaryOffsets[cell + 1] - first;
+
+            for (int from = 0; from < size; from++){
+                cellSearch(cell, boundaryNodes[first + from], -1, customized, search);
+                for (int to = 0; to < size; to++){
+                    int toID = boundaryNodes[first + to];
+                    customized.cliqueTime[cliqueOffsets[cell] + from*size + to] = search.reached(toID) ? search.time[toID] : OVERLAY_NO_TIME;
+                }
+            }
+        }
+    }
+}
+
+void customizableRouter::cellSearch(int cell, int sourceID, int stopID, const overlayMetric& current, overlaySearch& search) const{
+    search.prepare(cellOf.size());
+
+    overlayQueue waveQueue;
+    search.time[sourceID] = 0;
+    search.parentNode[sourceID] = -1;
+    search.parentSegment[sourceID] = -1;
+    search.stamp[sourceID] = search.run;
+    waveQueue.push(std::make_pair(0.0, sourceID));
+
+    while (!waveQueue.empty()){
+        double currentTime = waveQueue.top().first;
+        int currentID = waveQueue.top().second;
+        waveQueue.pop();
+
+        if (currentTime > search.time[currentID])
+            continue;
+        if (currentID == stopID)
+            return;
+
+        for (int arc = arcOffsets[currentID]; arc < arcOffsets[currentID + 1]; arc++){
+            int nextID = arcHead[arc];
+            if (cellOf[nextID] != cell)
+                continue;
+
+            double nextTime = currentTime + current.segmentTime[arcSegment[arc]];
+            if (nextTime == OVERLAY_NO_TIME || (search.reached(nextID) && search.time[nextID] <= nextTime))
+                continue; //closed (infinite time), or no faster
+
+            search.time[nextID] = nextTime;
+            search.parentNode[nextID] = currentID;
+            search.parentSegment[nextID] = arcSegment[arc];
+            search.stamp[nextID] = search.run;
+            waveQueue.push(std::make_pair(nextTime, nextID));
+        }
+    }
+}
+
+std::vector<int> customizableRouter::unpackShortcut(int cell, int fromID, int toID, const overlayMetric& current, overlaySearch& search) const{
+    std::vector<int> path;
+    cellSearch(cell, fromID, toID, current, search);
+
+    for (int intersectionID = toID; intersectionID != fromID; intersectionID = search.parentNode[intersectionID]){
+        path.push_back(search.parentSegment[intersectionID]);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+unsigned customizableRouter::updateTravelTimes(const std::vector<std::pair<int, double>>& updates){
+    ensureBuilt();
+
+    std::lock_guard<std::mutex> guard(updateLock);
+    std::shared_ptr<const overlayMetric> current = std::atomic_load(&metric);
+    std::shared_ptr<overlayMetric> next = std::make_shared<overlayMetric>(*current);
+
+    unsigned applied = 0;
+    std::vector<bool> dirty(boundaryOffsets.size() - 1, false);
+    for (std::vector<std::pair<int, double>>::const_iterator update = updates.begin(); update != updates.end(); update++){
+        if (update->first < 0 || update->first >= (int) next->segmentTime.size() || !(update->second >= 0))
+            continue;
+
+        next->segmentTime[update->first] = update->second;
+        applied++;
+
+        //a segment between two cells is only used by queries, not by shortcuts
+        InfoStreetSegment segStruct = getInfoStreetSegment(update->first);
+        if (cellOf[segStruct.from] == cellOf[segStruct.to])
+            dirty[cellOf[segStruct.from]] = true;
+    }
+
+    std::vector<int> dirtyCells;
+    for (unsigned cell = 0; cell < dirty.size(); cell++){
+        if (dirty[cell] && boundaryOffsets[cell + 1] > boundaryOffsets[cell])
+            dirtyCells.push_back(cell);
+    }
+    if (!dirtyCells.empty())
+        customize(*next, dirtyCells);
+
+    next->version = current->version + 1;
+    std::atomic_store(&metric, std::shared_ptr<const overlayMetric>(next));
+    return applied;
+}
+
+void customizableRouter::resetTravelTimes(){
+    ensureBuilt();
+
+    std::lock_guard<std::mutex> guard(updateLock);
+    std::shared_ptr<const overlayMetric> current = std::atomic_load(&metric);
+    std::shared_ptr<overlayMetric> next = std::make_shared<overlayMetric>();
+    next->segmentTime = SegmentTravelTime;
+    next->cliqueTime.assign(cliqueOffsets.back(), OVERLAY_NO_TIME);
+    customize(*next, std::vector<int>());
+
+    next->version = current->version + 1;
+    std::atomic_store(&metric, std::shared_ptr<const overlayMetric>(next));
+}
+
+std::vector<int> customizableRouter::findPath(int startID, int endID, double& travelTime){
+    std::shared_ptr<const overlayMetric> current = snapshot();
+    const overlayMetric& times = *current;
+
+    //workspaces of the calling thread: the query, and the cell searches unpacking its shortcuts
+    thread_local overlaySearch search;
+    thread_local overlaySearch unpackSearch;
+
+    travelTime = 0;
+    std::vector<int> path;
+    if (startID == endID)
+        return path;
+
+    search.prepare(cellOf.size());
+    int startCell = cellOf[startID];
+    int endCell = cellOf[endID];
+
+    overlayQueue waveQueue;
+    search.time[startID] = 0;
+    search.parentNode[startID] = -1;
+    search.parentSegment[startID] = -1;
+    search.stamp[startID] = search.run;
+    waveQueue.push(std::make_pair(0.0, startID));
+
+    bool found = false;
+    while (!waveQueue.empty()){
+        double currentTime = waveQueue.top().first;
+        int currentID = waveQueue.top().second;
+        waveQueue.pop();
+
+        if (currentTime > search.time[currentID])
+            continue;
+        if (currentID == endID){
+            found = true;
+            break;
+        }
+
+        //the start and end cells are searched segment by segment, other cells are crossed by shortcuts
+        int cell = cellOf[currentID];
+        bool throughCell = (cell != startCell && cell != endCell);
+
+        for (int arc = arcOffsets[currentID]; arc < arcOffsets[currentID + 1]; arc++){
+            int nextID = arcHead[arc];
+            if (throughCell && cellOf[nextID] == cell)
+                continue;
+
+            double nextTime = currentTime + times.segmentTime[arcSegment[arc]];
+            if (nextTime == OVERLAY_NO_TIME || (search.reached(nextID) && search.time[nextID] <= nextTime))
+                continue; //closed (infinite time), or no faster
+
+            search.time[nextID] = nextTime;
+            search.parentNode[nextID] = currentID;
+            search.parentSegment[nextID] = arcSegment[arc];
+            search.stamp[nextID] = search.run;
+            waveQueue.push(std::make_pair(nextTime, nextID));
+        }
+
+        if (throughCell){
+            int first = boundaryOffsets[cell];
+            int size = boundaryOffsets[cell + 1] - first;
+            const double* shortcuts = &times.cliqueTime[cliqueOffsets[cell] + boundaryIndex[currentID]*size];
+
+            for (int to = 0; to < size; to++){
+                int nextID = boundaryNodes[first + to];
+                if (nextID == currentID || shortcuts[to] == OVERLAY_NO_TIME)
+                    continue;
+
+                double nextTime = currentTime + shortcuts[to];
+                if (search.reached(nextID) && search.time[nextID] <= nextTime)
+                    continue;
+
+                search.time[nextID] = nextTime;
+                search.parentNode[nextID] = currentID;
+                search.parentSegment[nextID] = -1;
+                search.stamp[nextID] = search.run;
+                waveQueue.push(std::make_pair(nextTime, nextID));
+            }
+        }
+    }
+    if (!found)
+        return path;
+
+    travelTime = search.time[endID];
+
+    //trace back from the end (segments in reverse), unpacking shortcuts on the way
+    for (int intersectionID = endID; intersectionID != startID; intersectionID = search.parentNode[intersectionID]){
+        if (search.parentSegment[intersectionID] >= 0){
+            path.push_back(search.parentSegment[intersectionID]);
+            continue;
+        }
+
+        int fromID = search.parentNode[intersectionID];
+        std::vector<int> shortcut = unpackShortcut(cellOf[fromID], fromID, intersectionID, times, unpackSearch);
+        path.insert(path.end(), shortcut.rbegin(), shortcut.rend());
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
@@ -0,0 +1,127 @@
+/*
+ * File:   customizableRouter.h
+ * Author: georg157
+ *
+ * Driving paths on live segment travel times (e.g. from a traffic feed), with preprocessing split in two:
+ *   - metric independent, once per map: the road graph as flat arrays, cut into square cells, and each cell's boundary
+ *     intersections (ends of segments leaving the cell)
+ *   - customization, per set of travel times: the fastest time between every two boundary intersections of a cell,
+ *     inside the cell (cells in parallel); an update only re-customizes the cells its segments lie in
+ * A query searches its start and end cells segment by segment, and every other cell through its boundary shortcuts
+ *
+ * Travel times are replaced as one snapshot: queries keep the snapshot they started with while an update builds the
+ * next, which is then swapped in atomically. SegmentTravelTime (speed limits) is never changed, the other searches keep it
+ * Turn penalties are not modelled here (a shortcut doesn't keep the street it arrives by), nor are closures (SegmentClosures):
+ * a closure is given as an infinite travel time instead
+ */
+
+#ifndef CUSTOMIZABLEROUTER_H
+#define CUSTOMIZABLEROUTER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#define OVERLAY_CELL_SIZE 2000 //metres, side of a cell of the partition
+
+//one set of travel times and the cell shortcuts customized for it, never changed once published
+struct overlayMetric{
+    //Vector --> key: [segment ID] value: [travel time, seconds]
+    std::vector<double> segmentTime;
+
+    //Vector --> key: [cliqueOffsets[cell] + i * (boundary size of cell) + j] value: [fastest time inside the cell from its
+    //i-th to its j-th boundary intersection, seconds (infinity if there is no path inside the cell)]
+    std::vector<double> cliqueTime;
+
+    unsigned long version; //bumped by every update
+};
+
+class customizableRouter{
+    public:
+        customizableRouter();
+
+        ~customizableRouter();
+
+        //Replaces the travel time of each (segment ID, seconds) pair, atomically for running queries
+        //Updates are applied one at a time (a second update waits for the first)
+        //Returns: number of pairs applied (unknown segments and negative times are skipped)
+        unsigned updateTravelTimes(const std::vector<std::pair<int, double>>& updates);
+
+        //Puts every segment back to its speed limit travel time (SegmentTravelTime)
+        void resetTravelTimes();
+
+        //Fastest driving path on the current travel times, thread safe
+        //Returns: the path (empty if start == end or none exists), travelTime is set (seconds)
+        std::vector<int> findPath(int startID, int endID, double& travelTime);
+
+        //Returns: current travel times (the preprocessing is run on the first call after load_map)
+        std::shared_ptr<const overlayMetric> snapshot();
+
+        //Forgets the graph and travel times (the map was closed), no query may be running
+        void clear();
+
+    private:
+        //search state over the intersections, stamped per search instead of being reset
+        struct overlaySearch{
+            //Vector --> key: [intersection ID] value: [best time found, seconds / intersection before / segment taken from it]
+            //segment -1: reached through a shortcut of the intersection before's cell
+            std::vector<double> time;
+            std::vector<int> parentNode;
+            std::vector<int> parentSegment;
+            std::vector<unsigned> stamp;
+            unsigned run;
+
+            overlaySearch();
+
+            //Starts a new search (resizing the workspace to numIntersections)
+            void prepare(unsigned numIntersections);
+
+            bool reached(int intersectionID) const;
+        };
+
+        //Builds the metric independent arrays, then customizes every cell on SegmentTravelTime (called once per map)
+        void ensureBuilt();
+        void build();
+
+        //Recomputes the shortcuts of the cells marked (all if cells is empty) on metric's segment times
+        void customize(overlayMetric& metric, const std::vector<int>& cells) const;
+
+        //Dijkstra from sourceID that stays in cell, stops once stopID is settled (-1: whole cell)
+        void cellSearch(int cell, int sourceID, int stopID, const overlayMetric& metric, overlaySearch& search) const;
+
+        //Returns: segments of the fastest path from fromID to toID inside cell (a shortcut unpacked)
+        std::vector<int> unpackShortcut(int cell, int fromID, int toID, const overlayMetric& metric, overlaySearch& search) const;
+
+        //Vector --> key: [intersection ID] value: [index of intersection's first arc]
+        //size is number of intersections + 1, arcs leaving intersection i are [arcOffsets[i], arcOffsets[i+1])
+        std::vector<int> arcOffsets;
+        //Vector --> key: [arc] value: [intersection the arc leads to / segment it follows]
+        std::vector<int> arcHead;
+        std::vector<int> arcSegment;
+
+        //Vector --> key: [intersection ID] value: [cell]
+        std::vector<int> cellOf;
+
+        //Vector --> key: [cell] value: [index of cell's first boundary intersection in boundaryNodes], size is number of cells + 1
+        std::vector<int> boundaryOffsets;
+        std::vector<int> boundaryNodes;
+
+        //Vector --> key: [intersection ID] value: [position among its cell's boundary intersections, -1 if inside]
+        std::vector<int> boundaryIndex;
+
+        //Vector --> key: [cell] value: [index of cell's first shortcut in overlayMetric::cliqueTime], size is number of cells + 1
+        std::vector<int> cliqueOffsets;
+
+        std::atomic<bool> built;
+
+        //held while building and while an update prepares the next snapshot
+        std::mutex updateLock;
+
+        //current travel times, read and replaced with std::atomic_load / std::atomic_store
+        std::shared_ptr<const overlayMetric> metric;
+};
+
+#endif /* CUSTOMIZABLEROUTER_H */
+
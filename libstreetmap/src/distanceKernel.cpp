@@ -0,0 +1,216 @@
+/*
+ * File:   distanceKernel.cpp
+ * Author: georg157
+ *
+ * Batch versions of find_distance_between_two_points over structure-of-arrays positions
+ */
+
+#include "distanceKernel.h"
+#include "m1.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DISTANCE_KERNEL_X86
+#endif
+
+//highest kernel the batch functions may use (see setDistanceKernelLimit)
+static distanceKernelLevel KernelLimit = avx2Kernel;
+
+latLonArrays::latLonArrays() {
+}
+
+latLonArrays::~latLonArrays() {
+}
+
+void latLonArrays::push_back(LatLon point){
+    double latRad = point.lat() * DEGREE_TO_RADIAN;
+    lat.push_back(latRad);
+    lon.push_back(point.lon() * DEGREE_TO_RADIAN);
+    cosHalfLat.push_back(cos(latRad * 0.5));
+    sinHalfLat.push_back(sin(latRad * 0.5));
+}
+
+void latLonArrays::reserve(unsigned numPoints){
+    lat.reserve(numPoints);
+    lon.reserve(numPoints);
+    cosHalfLat.reserve(numPoints);
+    sinHalfLat.reserve(numPoints);
+}
+
+void latLonArrays::clear(){
+    lat.clear();
+    lon.clear();
+    cosHalfLat.clear();
+    sinHalfLat.clear();
+}
+
+unsigned latLonArrays::size() const{
+    return lat.size();
+}
+
+double distanceBetweenPoints(const latLonArrays& points, unsigned a, unsigned b){
+    double cosLatAvg = points.cosHalfLat[a] * points.cosHalfLat[b] - points.sinHalfLat[a] * points.sinHalfLat[b];
+    double dx = (points.lon[b] - points.lon[a]) * cosLatAvg;
+    double dy = points.lat[b] - points.lat[a];
+    return EARTH_RADIUS_METERS * sqrt(dx * dx + dy * dy);
+}
+
+//-----Kernels------------------------------------------------------
+//Each kernel handles points [begin, end) and returns the index it stopped at,
+//the scalar kernel finishes whatever is left over
+
+//Consecutive: out[i] = distance(i, i+1)
+static unsigned consecutiveScalar(const latLonArrays& p, unsigned begin, unsigned end, double* out){
+    for (unsigned i = begin; i < end; i++){
+        out[i] = distanceBetweenPoints(p, i, i + 1);
+    }
+    return end;
+}
+
+//To point: out[i - begin] = distance(position, i)
+static unsigned toPointScalar(const latLonArrays& p, unsigned begin, unsigned end,
+                              double lat, double lon, double cosHalf, double sinHalf, double* out){
+    for (unsigned i = begin; i < end; i++){
+        double cosLatAvg = cosHalf * p.cosHalfLat[i] - sinHalf * p.sinHalfLat[i];
+        double dx = (p.lon[i] - lon) * cosLatAvg;
+        double dy = p.lat[i] - lat;
+        out[i - begin] = EARTH_RADIUS_METERS * sqrt(dx * dx + dy * dy);
+    }
+    return end;
+}
+
+#ifdef DISTANCE_KERNEL_X86
+
+__attribute__((target("avx2")))
+static unsigned consecutiveAVX2(const latLonArrays& p, unsigned begin, unsigned end, double* out){
+    const __m256d radius = _mm256_set1_pd(EARTH_RADIUS_METERS);
+    unsigned i = begin;
+    for (; i + 4 <= end; i += 4){
+        __m256d cosLatAvg = _mm256_sub_pd(
+                _mm256_mul_pd(_mm256_loadu_pd(&p.cosHalfLat[i]), _mm256_loadu_pd(&p.cosHalfLat[i + 1])),
+                _mm256_mul_pd(_mm256_loadu_pd(&p.sinHalfLat[i]), _mm256_loadu_pd(&p.sinHalfLat[i + 1])));
+        __m256d dx = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(&p.lon[i + 1]), _mm256_loadu_pd(&p.lon[i])), cosLatAvg);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&p.lat[i + 1]), _mm256_loadu_pd(&p.lat[i]));
+        __m256d sum = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        _mm256_storeu_pd(&out[i], _mm256_mul_pd(radius, _mm256_sqrt_pd(sum)));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static unsigned toPointAVX2(const latLonArrays& p, unsigned begin, unsigned end,
+                            double lat, double lon, double cosHalf, double sinHalf, double* out){
+    const __m256d radius = _mm256_set1_pd(EARTH_RADIUS_METERS);
+    const __m256d latQ = _mm256_set1_pd(lat);
+    const __m256d lonQ = _mm256_set1_pd(lon);
+    const __m256d cosQ = _mm256_set1_pd(cosHalf);
+    const __m256d sinQ = _mm256_set1_pd(sinHalf);
+    unsigned i = begin;
+    for (; i + 4 <= end; i += 4){
+        __m256d cosLatAvg = _mm256_sub_pd(_mm256_mul_pd(cosQ, _mm256_loadu_pd(&p.cosHalfLat[i])),
+                                          _mm256_mul_pd(sinQ, _mm256_loadu_pd(&p.sinHalfLat[i])));
+        __m256d dx = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(&p.lon[i]), lonQ), cosLatAvg);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&p.lat[i]), latQ);
+        __m256d sum = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        _mm256_storeu_pd(&out[i - begin], _mm256_mul_pd(radius, _mm256_sqrt_pd(sum)));
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static unsigned consecutiveSSE2(const latLonArrays& p, unsigned begin, unsigned end, double* out){
+    const __m128d radius = _mm_set1_pd(EARTH_RADIUS_METERS);
+    unsigned i = begin;
+    for (; i + 2 <= end; i += 2){
+        __m128d cosLatAvg = _mm_sub_pd(
+                _mm_mul_pd(_mm_loadu_pd(&p.cosHalfLat[i]), _mm_loadu_pd(&p.cosHalfLat[i + 1])),
+                _mm_mul_pd(_mm_loadu_pd(&p.sinHalfLat[i]), _mm_loadu_pd(&p.sinHalfLat[i + 1])));
+        __m128d dx = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(&p.lon[i + 1]), _mm_loadu_pd(&p.lon[i])), cosLatAvg);
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(&p.lat[i + 1]), _mm_loadu_pd(&p.lat[i]));
+        __m128d sum = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+        _mm_storeu_pd(&out[i], _mm_mul_pd(radius, _mm_sqrt_pd(sum)));
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static unsigned toPointSSE2(const latLonArrays& p, unsigned begin, unsigned end,
+                            double lat, double lon, double cosHalf, double sinHalf, double* out){
+    const __m128d radius = _mm_set1_pd(EARTH_RADIUS_METERS);
+    const __m128d latQ = _mm_set1_pd(lat);
+    const __m128d lonQ = _mm_set1_pd(lon);
+    const __m128d cosQ = _mm_set1_pd(cosHalf);
+    const __m128d sinQ = _mm_set1_pd(sinHalf);
+    unsigned i = begin;
+    for (; i + 2 <= end; i += 2){
+        __m128d cosLatAvg = _mm_sub_pd(_mm_mul_pd(cosQ, _mm_loadu_pd(&p.cosHalfLat[i])),
+                                       _mm_mul_pd(sinQ, _mm_loadu_pd(&p.sinHalfLat[i])));
+        __m128d dx = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(&p.lon[i]), lonQ), cosLatAvg);
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(&p.lat[i]), latQ);
+        __m128d sum = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+        _mm_storeu_pd(&out[i - begin], _mm_mul_pd(radius, _mm_sqrt_pd(sum)));
+    }
+    return i;
+}
+
+static bool cpuHasAVX2(){
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+    return hasAVX2;
+}
+
+static bool cpuHasSSE2(){
+    static const bool hasSSE2 = __builtin_cpu_supports("sse2");
+    return hasSSE2;
+}
+
+#endif
+
+//------------------------------------------------------------------
+
+void setDistanceKernelLimit(distanceKernelLevel level){
+    KernelLimit = level;
+}
+
+distanceKernelLevel activeDistanceKernel(){
+#ifdef DISTANCE_KERNEL_X86
+    if (KernelLimit >= avx2Kernel && cpuHasAVX2())
+        return avx2Kernel;
+    if (KernelLimit >= sse2Kernel && cpuHasSSE2())
+        return sse2Kernel;
+#endif
+    return scalarKernel;
+}
+
+void distancesBetweenConsecutivePoints(const latLonArrays& points, std::vector<double>& distances){
+    unsigned numPairs = points.size() > 0 ? points.size() - 1 : 0;
+    distances.resize(numPairs);
+
+    unsigned done = 0;
+#ifdef DISTANCE_KERNEL_X86
+    distanceKernelLevel kernel = activeDistanceKernel();
+    if (kernel == avx2Kernel)
+        done = consecutiveAVX2(points, 0, numPairs, distances.data());
+    else if (kernel == sse2Kernel)
+        done = consecutiveSSE2(points, 0, numPairs, distances.data());
+#endif
+    consecutiveScalar(points, done, numPairs, distances.data());
+}
+
+void distancesToPoint(const latLonArrays& points, unsigned begin, unsigned end, LatLon position, double* distances){
+    double lat = position.lat() * DEGREE_TO_RADIAN;
+    double lon = position.lon() * DEGREE_TO_RADIAN;
+    double cosHalf = cos(lat * 0.5);
+    double sinHalf = sin(lat * 0.5);
+
+    unsigned done = begin;
+#ifdef DISTANCE_KERNEL_X86
+    distanceKernelLevel kernel = activeDistanceKernel();
+    if (kernel == avx2Kernel)
+        done = toPointAVX2(points, begin, end, lat, lon, cosHalf, sinHalf, distances);
+    else if (kernel == sse2Kernel)
+        done = toPointSSE2(points, begin, end, lat, lon, cosHalf, sinHalf, distances);
+#endif
+    //the scalar kernel writes from index 0, so it starts at the first point the vector kernel left
+    toPointScalar(points, done, end, lat, lon, cosHalf, sinHalf, distances + (done - begin));
+}
@@ -0,0 +1,66 @@
+/*
+ * File:   distanceKernel.h
+ * Author: georg157
+ *
+ * Batch versions of find_distance_between_two_points over structure-of-arrays positions
+ * Uses AVX2 or SSE2 when the CPU supports it, otherwise a scalar loop
+ */
+
+#ifndef DISTANCEKERNEL_H
+#define DISTANCEKERNEL_H
+
+#include "LatLon.h"
+#include <vector>
+
+//Positions stored as separate arrays (radians)
+//cos and sin of half the latitude are kept so the average-latitude cosine of any pair is
+//cos((a+b)/2) = cos(a/2)cos(b/2) - sin(a/2)sin(b/2), with no cos() call per distance
+class latLonArrays{
+    public:
+        latLonArrays();
+
+        ~latLonArrays();
+
+        void push_back(LatLon point);
+
+        void reserve(unsigned numPoints);
+
+        void clear();
+
+        unsigned size() const;
+
+        std::vector<double> lat;
+
+        std::vector<double> lon;
+
+        std::vector<double> cosHalfLat;
+
+        std::vector<double> sinHalfLat;
+};
+
+//Instruction sets the batch functions may use, each falls back to the one below it if the CPU lacks it
+enum distanceKernelLevel {
+    scalarKernel = 0,
+    sse2Kernel,
+    avx2Kernel
+};
+
+//Limits the batch functions to level and below (default: avx2Kernel), so every kernel can be tested and timed
+//Not thread safe: set it before any batch function runs
+void setDistanceKernelLimit(distanceKernelLevel level);
+
+//Returns: the kernel the batch functions use, given the limit and what the CPU supports
+distanceKernelLevel activeDistanceKernel();
+
+//Return: distance (metres) between points a and b of the arrays
+double distanceBetweenPoints(const latLonArrays& points, unsigned a, unsigned b);
+
+//distances[i] = distance (metres) between points i and i+1, for i in [0, size-1)
+void distancesBetweenConsecutivePoints(const latLonArrays& points, std::vector<double>& distances);
+
+//distances[i] = distance (metres) between position and points i, for i in [begin, end)
+//distances is written from index 0 (distances[0] is for point begin)
+void distancesToPoint(const latLonArrays& points, unsigned begin, unsigned end, LatLon position, double* distances);
+
+#endif /* DISTANCEKERNEL_H */
+
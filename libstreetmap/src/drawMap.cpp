@@ -2,16 +2,6 @@
 
 ///************  GLOBAL VARIABLES  *****************/
 
-enum RoadType {
-    unclassified = 0,
-    motorway, 
-    trunk ,
-    primary,
-    secondary, 
-    tertiary, 
-    residential
-};
-
 enum Mode {
     base = 0,
     directions,
@@ -47,8 +37,60 @@ ezgl::color Colour_residential(114, 111, 85, 255); // yellow (1 = darkest)
 //Vector --> key: [intersection ID] value: [intersection_data struct]
 std::vector<intersection_data> intersections;
 
-//Hashtable --> key: [OSMway] value: [Road Type (e.g. 0 = Unknown, 1 = motorway...)]
-std::unordered_map<OSMID, RoadType> WaybyRoadType;
+//Vector --> key: [segment ID] value: [Road Type of the segment's way (e.g. 0 = Unknown, 1 = motorway...)]
+std::vector<unsigned char> SegmentRoadType;
+
+//Grid over segment bounding boxes, bucketed by Road Type (used to find visible segments)
+segmentGrid StreetSegmentGrid;
+
+//road types in the order they are drawn (major roads end up on top of minor roads)
+const RoadType StreetDrawOrder[NUM_ROAD_TYPES] = {unclassified, residential, tertiary, secondary, primary, trunk, motorway};
+
+//Prerendered tiles of the base map (background, features, streets), drawn by worker threads
+tileCache MapTiles;
+
+//screen width (pixels) the current map tiles were drawn for
+int TileScreenWidth = 0;
+
+//application redrawn when a map tile is finished (NULL when no window is open)
+ezgl::application* MapApplication = NULL;
+
+//true while a redraw for finished map tiles is queued on the GTK thread
+std::atomic<bool> TileRedrawQueued(false);
+
+//Image of the base map (map tiles and intersections) and of the names for the current view
+//Drawn again only when the view changes or their version is bumped (path highlights are an overlay drawn live on top)
+viewLayer BaseLayer;
+viewLayer LabelLayer;
+unsigned BaseLayerVersion = 0;
+unsigned LabelLayerVersion = 0;
+
+//Vector --> outline of the area within walking distance of the start of the path (empty if none), drawn under the path
+std::vector<ezgl::point2d> WalkingAreaHull;
+
+//Computes the routes asked for with the Go button, results come back to the GTK thread through route_ready
+routeWorker RouteWorker;
+
+//Places names without overlaps (one per thread, the headless tile renderer draws names on several threads)
+thread_local labelPlacer MapLabels;
+
+//Time and primitives drawn per layer, and recent frame times (reset when a map is loaded)
+renderStats RenderStats;
+
+//true while the render statistics are drawn over the map (toggled with F2)
+bool ShowRenderStats = false;
+
+//Simplification tolerance (metres) of each level of detail, level 0 is the original geometry
+const double LODTolerances[NUM_LOD_LEVELS] = {0, 1.5, 6, 24, 96};
+
+//Vector --> key: [level of detail] value: [every segment's simplified (x,y) points, back to back] (level 0 left empty, SegmentPointsXY is used)
+std::vector<std::vector<ezgl::point2d>> SegmentPointsXY_LOD;
+
+//Vector --> key: [level of detail] value: [vector --> key: [segment ID] value: [index of segment's first point in SegmentPointsXY_LOD]]
+std::vector<std::vector<int>> SegmentPointOffsets_LOD;
+
+//Vector --> key: [level of detail] value: [Featurepoints_xy simplified] (level 0 left empty, Featurepoints_xy is used)
+std::vector<std::vector<std::vector<ezgl::point2d>>> Featurepoints_xy_LOD;
 
 //Hashtable --> key: [feature id] value: [centroid (x,y)]
 std::unordered_map< int, ezgl::point2d > FeatureCentroids;
@@ -56,6 +98,9 @@ std::unordered_map< int, ezgl::point2d > FeatureCentroids;
 //Vector --> key: [feature id] value: [vector of featurepoints in (x,y) coordinates --> std::vector<ezgl::point2d>]
 std::vector<std::vector<ezgl::point2d>> Featurepoints_xy;
 
+//Vector --> key: [feature id] value: [bounding box of its feature points]
+std::vector<ezgl::rectangle> FeatureBounds;
+
 //Vector --> key: [type], value = vector: [point of interest structs]
 std::vector<std::vector<poiStruct>> PointsOfInterest (3);
 
@@ -66,10 +111,9 @@ std::vector<std::vector<int>> FeatureIds_byType;
 std::vector<int> Highlighted_intersections;
 
 //variable used to determine drawing thresholds
-double scale_factor = 1;
+//(one per thread: map tiles are drawn on worker threads, each at its own scale)
+thread_local double scale_factor = 1;
 
-//average latitude of map, value set in draw_map_blank_canvas
-float latAvg; 
 //corners of the map, values set in draw_map
 double max_lat;
 double min_lat;
@@ -111,10 +155,8 @@ void find_map_bounds(){
     int numIntersections = getNumIntersections();
     intersections.resize(numIntersections);
     
-    //variable used in (long,lat) -> (x,y) conversion,  required for finding latAvg
-    double sumLat = 0;
-    
-    //populate the intersections vector, calculates min and max lat/lon positions, and determines total sum of lats for latAvg
+    //populate the intersections vector, calculates min and max lat/lon positions
+    //(the average latitude used in (long,lat) -> (x,y) conversion is MapLatAvg, set in load_map)
     for(int i = 0; i < numIntersections; i++){
 
         //get position from streetsdatabaseAPI function
@@ -128,16 +170,7 @@ void find_map_bounds(){
         min_lat = std::min(min_lat, intersections[i].position.lat());
         max_lon = std::max(max_lon, intersections[i].position.lon());
         min_lon = std::min(min_lon, intersections[i].position.lon());
-        
-        //update the sum of latitude
-        sumLat = sumLat + intersections[i].position.lat();
     }
-        
-    //convert latsum to radians
-    sumLat = sumLat * DEGREE_TO_RADIAN;
-    
-    //update the global variable with calculated lat average
-    latAvg = sumLat/(numIntersections);
     
     //convert min & max lat/lons
     min_lon = x_from_lon(min_lon);
@@ -146,21 +179,32 @@ void find_map_bounds(){
     max_lat = y_from_lat(max_lat);
 }
 
-void draw_map(){
-
-    find_map_bounds();
+//Finds the map bounds and populates every global variable needed for drawing (the map must be loaded)
+//Needs no window, so it is also used by the headless tile renderer
+void populateDrawingData(){
     
-    //get the current weekday
-    std::time_t now = std::time(0);
-    std::stringstream date(ctime(&now));
-//    date >> Weekday;
+    //updates min_lon, min_lat, max_lon, max_lat Global Variables (needed to populate global variables)
+    //also populates intersections vector
+    find_map_bounds();
     
     //populate all global variables
-    populateWaybyRoadType();
+    populateSegmentRoadType();
+    populateStreetSegmentGrid();
     populateFeatureIds_byType();
     populatePointsOfInterest();
     populateFeaturepoints_xy();
+    populateLevelsOfDetail();
     populateFeatureCentroids();
+}
+
+void draw_map(){
+
+    //get the current weekday
+    std::time_t now = std::time(0);
+    std::stringstream date(ctime(&now));
+//    date >> Weekday;
+    
+    populateDrawingData();
     
     draw_map_blank_canvas();
 }
@@ -179,19 +223,34 @@ void draw_map_blank_canvas (){
     ezgl::rectangle initial_world({min_lon, min_lat},{max_lon, max_lat}); 
     
     application.add_canvas("MainCanvas", draw_main_canvas, initial_world);
-    application.run(initial_setup,act_on_mouse_click,NULL,NULL);
+    
+    //map tiles are drawn on worker threads, leaving a core for the GTK thread
+    unsigned numCores = std::thread::hardware_concurrency();
+    MapApplication = &application;
+    MapTiles.start(numCores > 1 ? numCores - 1 : 1, map_tile_ready);
+    RouteWorker.start(route_computed);
+    
+    application.run(initial_setup,act_on_mouse_click,NULL,act_on_key_press);
+    
+    RouteWorker.stop();
+    MapTiles.stop();
+    MapTiles.clear();
+    BaseLayer.clear();
+    LabelLayer.clear();
+    MapApplication = NULL;
 }
 
 /*
  * Draws each major map components in the following order:
- * (1) Features
- * (2) Streets
- * (3) Points of Interest
- * (4) Intersections
- * 
+ * (1) Base layer: Features and Streets (prerendered map tiles, see draw_base_map), then Intersections
+ * (2) Overlay: path highlights and highlighted intersections (see draw_path_overlay)
+ * (3) Label layer: Street, Feature and Point of Interest Names (placed by priority without overlaps, see draw_map_labels)
+ * The base and label layers are kept as images of the view, so a new path or click only draws the overlay again
  */
 void draw_main_canvas (ezgl::renderer *g){
     
+    auto frameStart = std::chrono::steady_clock::now();
+    
     //Determine the amount that screen is zoomed in 
     ezgl::rectangle zoom_rect = g->get_visible_world(); //retrieves in xy, the coordinates of the visible screen
     double zoom = zoom_rect.width(); //width of zoom rectangle
@@ -207,38 +266,246 @@ void draw_main_canvas (ezgl::renderer *g){
 //    std::cout<<"\nscale_factor: "<<scale_factor;
 //    std::cout<<"\nzoom: "<<zoom;
     
+    //map tiles are drawn for the screen's width (it sets which roads show at each zoom level)
+    if (g->get_visible_screen().width() != TileScreenWidth){
+        TileScreenWidth = g->get_visible_screen().width();
+        invalidate_map_tiles();
+    }
+    
+    //Drawing Background, Features, Streets and Intersections (missing tiles are drawn by the workers, then the canvas is redrawn)
+    BaseLayer.draw(g, BaseLayerVersion, draw_base_layer);
+    
+    auto start = std::chrono::steady_clock::now();
+    int numDrawn = draw_path_overlay(g);
+    RenderStats.record(overlayLayer, start, numDrawn);
+    
+    LabelLayer.draw(g, LabelLayerVersion, [](ezgl::renderer *layerG){
+        draw_map_labels(layerG);
+        return true;
+    });
+    
+    RenderStats.recordFrame(frameStart);
+    if (ShowRenderStats)
+        RenderStats.drawOverlay(g);
+}
+
+//Draws the content of BaseLayer: the map tiles covering g's view, then intersections
+//Returns: false if some tiles are not drawn yet (the workers redraw the canvas once they are)
+bool draw_base_layer(ezgl::renderer *g){
+    
+    int numMissing = MapTiles.draw(g);
+    
+    //Drawing Intersections
+    auto start = std::chrono::steady_clock::now();
+    int numDrawn = draw_intersections(g);
+    RenderStats.record(intersectionsLayer, start, numDrawn);
+    
+    return numMissing == 0;
+}
+
+//Draws everything on top of the base map: intersections, then names and points of interest (used by the headless tile renderer)
+void draw_map_details(ezgl::renderer *g){
+    
+    //Drawing Intersections
+    auto start = std::chrono::steady_clock::now();
+    int numDrawn = draw_intersections(g);
+    RenderStats.record(intersectionsLayer, start, numDrawn);
+    
+    draw_map_labels(g);
+}
+
+//Draws street, feature and point of interest names
+//Names are candidate labels, placed by priority so none of them overlap
+//Each layer is timed into RenderStats (label layers count the candidates they add)
+void draw_map_labels(ezgl::renderer *g){
+    
+    MapLabels.begin(g);
+    
+    //Street Names
+    auto start = std::chrono::steady_clock::now();
+    add_street_name_labels(g, MapLabels);
+    int numCandidates = MapLabels.numCandidates();
+    RenderStats.record(streetNamesLayer, start, numCandidates);
+
+    //Feature Names
+    start = std::chrono::steady_clock::now();
+    add_feature_name_labels(MapLabels);
+    RenderStats.record(featureNamesLayer, start, MapLabels.numCandidates() - numCandidates);
+    numCandidates = MapLabels.numCandidates();
+     
+    //POIs
+    start = std::chrono::steady_clock::now();
+    add_poi_labels(MapLabels);
+    RenderStats.record(poiLayer, start, MapLabels.numCandidates() - numCandidates);
+    
+    start = std::chrono::steady_clock::now();
+    int numDrawn = MapLabels.place();
+    RenderStats.record(labelPlacementLayer, start, numDrawn);
+}
+
+//Draws what changes without the view changing: path highlights, then highlighted (clicked or found) intersections
+//Drawn live on every frame, between the base and label layers
+//Returns: number of segments and intersections drawn
+int draw_path_overlay(ezgl::renderer *g){
+    
+    int numDrawn = 0;
+    
+    //area the walk to the pick up could reach
+    if (WalkingAreaHull.size() >= 3){
+        g->set_color(Colour_walking_highlight.red, Colour_walking_highlight.green, Colour_walking_highlight.blue, 50);
+        g->fill_poly(WalkingAreaHull);
+        numDrawn++;
+    }
+    
+    numDrawn += draw_path_highlight(g);
+    
+    //highlighted intersections are drawn at the same size as in draw_intersections
+    if (scale_factor <= 0.01){
+        double width = (scale_factor > 0.005) ? 2 : ((scale_factor > 0.001) ? 1 : 0.5);
+        
+        g->set_color(ezgl::LIME_GREEN);
+        for (std::vector<int>::const_iterator it = Highlighted_intersections.begin(); it != Highlighted_intersections.end(); ++it){
+            if (!intersections[*it].highlight)
+                continue;
+            
+            g->fill_rectangle({IntersectionXY[*it].x - width / 2, IntersectionXY[*it].y - width / 2}, 
+                              {IntersectionXY[*it].x + width / 2, IntersectionXY[*it].y + width / 2});
+            numDrawn++;
+        }
+    }
+    
+    return numDrawn;
+}
+
+//Draws everything below the labels: background, features and streets (the content of a map tile)
+//Only reads data fixed once the map is loaded, so it runs on the worker threads drawing map tiles
+void draw_base_map(ezgl::renderer *g){
+    
     //Drawing Background
-    //***********************************************************************************
     g->set_color (32, 32, 32, 255);
     g->fill_rectangle({min_lon,min_lat}, {max_lon, max_lat});
     
 //  Draw all types of features  
-    drawFeatures(g);
+    auto start = std::chrono::steady_clock::now();
+    int numDrawn = drawFeatures(g);
+    RenderStats.record(featuresLayer, start, numDrawn);
     
 //   Drawing Streets
-    draw_streets(g);
+    start = std::chrono::steady_clock::now();
+    numDrawn = draw_streets(g);
+    RenderStats.record(streetsLayer, start, numDrawn);
+}
 
-    //Draw Feature Names
-    draw_feature_names(g);
-     
-    //Draw POIs
-    draw_points_of_interest(g);
+//Drops the prerendered map tiles and the layer images, called whenever what they show changes (map, screen width)
+void invalidate_map_tiles(){
     
-    //Drawing Intersections
-    draw_intersections(g);
+    double screenWidth = std::max(TileScreenWidth, 1);
+    
+    MapTiles.invalidate(ezgl::rectangle({min_lon, min_lat}, {max_lon, max_lat}), 
+            [screenWidth](ezgl::renderer *g){
+                set_tile_scale_factor(g, screenWidth);
+                draw_base_map(g);
+            });
+    
+    BaseLayerVersion++;
+    LabelLayerVersion++;
+}
+
+//Called whenever the path highlights change (the overlay is drawn live)
+//Only the names are drawn again: names of the path are placed ahead of every other label
+void path_highlight_changed(){
+    LabelLayerVersion++;
+}
+
+//Sets this thread's scale_factor for drawing a tile, so the same roads and widths show as on a screen screenWidth pixels wide
+//(share of the map width such a screen would show at the tile's scale)
+void set_tile_scale_factor(ezgl::renderer *g, double screenWidth){
+    scale_factor = g->get_visible_world().width() / g->get_visible_screen().width() * screenWidth / (max_lon - min_lon);
+}
+
+//Removes the highlights of the current path
+void clear_path_highlight(){
+    
+    while(!(segmentsHighlighted.empty())){
+        int segUnhighlightID = segmentsHighlighted.back();
+        segmentHighlight[segUnhighlightID].walking = false;
+        segmentHighlight[segUnhighlightID].driving = false;
+        segmentsHighlighted.pop_back();
+    }
+    WalkingAreaHull.clear();
+    path_highlight_changed();
+}
+
+//Highlights the segments of a path (walking or driving part), on the GTK thread
+void highlight_path(const std::vector<int>& path, bool walking){
+    
+    for (std::vector<int>::const_iterator it = path.begin(); it != path.end(); ++it){
+        if (walking)
+            segmentHighlight[*it].walking = true;
+        else
+            segmentHighlight[*it].driving = true;
+        segmentsHighlighted.push_back(*it);
+    }
+    path_highlight_changed();
+}
+
+//Called on the route worker's thread with each route found, hands it to the GTK thread
+void route_computed(std::shared_ptr<const routeResult> result){
+    g_idle_add(route_ready, new std::shared_ptr<const routeResult>(result));
+}
+
+//Runs on the GTK thread (queued by route_computed): highlights the path and shows its directions
+//A route superseded (or cancelled) since it was posted is dropped
+gboolean route_ready(gpointer data){
+    
+    std::unique_ptr<std::shared_ptr<const routeResult>> resultPtr(static_cast<std::shared_ptr<const routeResult>*>(data));
+    const routeResult& result = **resultPtr;
+    
+    if (MapApplication == NULL || result.requestID != RouteWorker.latestRequest())
+        return FALSE;
+    
+    clear_path_highlight();
+    highlight_path(result.walkingPath, true);
+    highlight_path(result.drivingPath, false);
+    WalkingAreaHull = result.walkingArea;
+    
+    GtkTextView* textViewPtr = GTK_TEXT_VIEW((GtkWidget *) MapApplication->get_object("SearchStreetsResults"));
+    gtk_text_buffer_set_text(gtk_text_view_get_buffer(textViewPtr), result.directions.c_str(), -1);
+    
+    MapApplication->refresh_drawing();
+    
+    //run once
+    return FALSE;
+}
+
+//Called on a worker thread each time a map tile is finished
+void map_tile_ready(){
+    //tiles finishing together only queue one redraw
+    if (!TileRedrawQueued.exchange(true))
+        g_idle_add(redraw_map_tiles, NULL);
+}
+
+//Runs on the GTK thread (queued by map_tile_ready)
+gboolean redraw_map_tiles(gpointer /*unused*/){
+    TileRedrawQueued = false;
+    
+    if (MapApplication != NULL)
+        MapApplication->refresh_drawing();
+    
+    return FALSE; //only run once
 }
 
 std::pair < double, double > latLonToCartesian (LatLon latLonPoint){
     //convert LatLon points into x y coordinates
     double y = latLonPoint.lat()*DEGREE_TO_RADIAN *EARTH_RADIUS_METERS;
-    double x = latLonPoint.lon()*DEGREE_TO_RADIAN *EARTH_RADIUS_METERS*cos(latAvg);
+    double x = latLonPoint.lon()*DEGREE_TO_RADIAN *EARTH_RADIUS_METERS*MapCosLatAvg;
     std::pair < double, double> cartesian (x, y);
     return cartesian;
 }
 
 double x_from_lon (double lon){
     //convert Lon into x coordinate, return x 
-    return lon*DEGREE_TO_RADIAN *EARTH_RADIUS_METERS*cos(latAvg);
+    return lon*DEGREE_TO_RADIAN *EARTH_RADIUS_METERS*MapCosLatAvg;
 }
 
 double y_from_lat (double lat){
@@ -246,9 +513,14 @@ double y_from_lat (double lat){
     return lat*DEGREE_TO_RADIAN *EARTH_RADIUS_METERS;
 }
 
+std::pair < double, double > intersectionToCartesian (int intersectionID){
+    //position was projected once at load (IntersectionXY)
+    return std::make_pair(IntersectionXY[intersectionID].x, IntersectionXY[intersectionID].y);
+}
+
 double lon_from_x (double x){
     //convert Lon into x coordinate, return x 
-    return x / (DEGREE_TO_RADIAN * EARTH_RADIUS_METERS * cos(latAvg));
+    return x / (DEGREE_TO_RADIAN * EARTH_RADIUS_METERS * MapCosLatAvg);
 }
 
 double lat_from_y (double y){
@@ -281,190 +553,125 @@ double getRotationAngle(std::pair <double, double> xyFrom, std::pair <double, do
 void populatePointsOfInterest(){
     //clear any remnant data
     PointsOfInterest.clear();
+    PointsOfInterest.resize(3);
     
-    //store value of POI
-    std::string value;
+    //POI types drawn, in the order of PointsOfInterest
+    const std::vector<std::string> poiTypes = {"library", "cafe", "fast_food"};
     
     poiStruct poiData;
     LatLon latlon;
-    std::pair<double, double> xy;
     double x, y;
-    std::vector<poiStruct> library, cafes, fast_food;
     
     OSMID poi_OSMID;
     const OSMNode* poi_OSMentity;
     
-    //iterate through points of interest using layer 1
-    for (unsigned poiIterator = 0; poiIterator < getNumPointsOfInterest(); poiIterator++){
+    //only visit POIs of the drawn types, using the per-type spatial index
+    for (unsigned type = 0; type < poiTypes.size(); type++){
         
-        value = getPointOfInterestType(poiIterator);
-    
-        if (value == "library"){
-            poiData.Name = getPointOfInterestName(poiIterator);
-            poi_OSMID = getPointOfInterestOSMNodeID(poiIterator);
+        std::unordered_map<std::string, poiIndex>::const_iterator it = POIIndexByType.find(poiTypes[type]);
+        if (it == POIIndexByType.end())
+            continue;
+        
+        std::vector<int> poiIDs = it->second.members();
+        
+        for (unsigned i = 0; i < poiIDs.size(); i++){
+            poiData.Name = getPointOfInterestName(poiIDs[i]);
+            poi_OSMID = getPointOfInterestOSMNodeID(poiIDs[i]);
             poi_OSMentity = getNodeByIndex(OSMID_to_node.at(poi_OSMID));
             
-            latlon = getPointOfInterestPosition(poiIterator);
+            latlon = getPointOfInterestPosition(poiIDs[i]);
             
             //conversion to cartesian
             x = x_from_lon (latlon.lon());
             y = y_from_lat (latlon.lat());
-            xy = std::make_pair(x,y);
-            poiData.xyCoordinates = xy;
+            poiData.xyCoordinates = std::make_pair(x,y);
             
             poiData.hours = get_operationHours(poi_OSMentity);
             
-            library.push_back(poiData);
-        }
-        else if (value == "cafe"){
-            poiData.Name = getPointOfInterestName(poiIterator);
-            poi_OSMID = getPointOfInterestOSMNodeID(poiIterator);
-            poi_OSMentity = getNodeByIndex(OSMID_to_node.at(poi_OSMID));
-            
-            latlon = getPointOfInterestPosition(poiIterator);
-            
-            x = x_from_lon (latlon.lon());
-            y = y_from_lat (latlon.lat());
-            xy = std::make_pair(x,y);
-            poiData.xyCoordinates = xy;
-            
-            poiData.hours = get_operationHours(poi_OSMentity);
-            
-            cafes.push_back(poiData);
-        }
-        else if (value == "fast_food"){
-            poiData.Name = getPointOfInterestName(poiIterator);
-            poi_OSMID = getPointOfInterestOSMNodeID(poiIterator);
-            poi_OSMentity = getNodeByIndex(OSMID_to_node.at(poi_OSMID));
-            
-            latlon = getPointOfInterestPosition(poiIterator);
-            
-            x = x_from_lon (latlon.lon());
-            y = y_from_lat (latlon.lat());
-            xy = std::make_pair(x,y);
-            poiData.xyCoordinates = xy;
-            
-            poiData.hours = get_operationHours(poi_OSMentity);
-            
-            fast_food.push_back(poiData);
+            PointsOfInterest[type].push_back(poiData);
         }
     }
+}
+
+/*
+ * Builds StreetSegmentGrid over the projected segment points
+ * Must be called after populateSegmentRoadType
+ */
+void populateStreetSegmentGrid(){
     
-    PointsOfInterest[0] = library;
-    PointsOfInterest[1] = cafes;
-    PointsOfInterest[2] = fast_food;
+    StreetSegmentGrid.build(SegmentPointsXY, SegmentPointOffsets, SegmentRoadType, NUM_ROAD_TYPES);
 }
 
 /*
- * Searches through all OSM Entities and their tags to match OSMIDs with RoadType (e.g. motorway, primary roads, residential, etc.)
- * Populates global variable WaybyRoadType
- * The "highway" OSM key is used to access the road type
+ * Return: RoadType of a "highway" tag value (e.g. "primary" --> primary), unclassified for any other value
+ * Switches on the compile-time hash of the known values, a match is confirmed with one string compare
  */
-void populateWaybyRoadType(){
-    //clear any remnant data that is there now
-    WaybyRoadType.clear();
+RoadType road_type_from_highway_tag(const std::string& value){
+    switch (tag_hash(value.c_str())){
+        case tag_hash("motorway"):
+            return value == "motorway" ? motorway : unclassified;
+        case tag_hash("trunk"):
+            return value == "trunk" ? trunk : unclassified;
+        case tag_hash("primary"):
+            return value == "primary" ? primary : unclassified;
+        case tag_hash("secondary"):
+            return value == "secondary" ? secondary : unclassified;
+        case tag_hash("tertiary"):
+            return value == "tertiary" ? tertiary : unclassified;
+        case tag_hash("residential"):
+            return value == "residential" ? residential : unclassified;
+        default:
+            return unclassified;
+    }
+}
+
+/*
+ * Populates global variable SegmentRoadType: the RoadType (e.g. motorway, primary roads, residential, etc.) of each segment's way
+ * The "highway" OSM key of the way is used to access the road type
+ * Only ways are scanned, segments never refer to an OSM relation or node
+ */
+void populateSegmentRoadType(){
     
-    std::string key,value;
-    RoadType road_type;
+    int numWays = getNumberOfWays();
     
+    //Vector --> (way OSMID, Road Type) of every way with a "highway" tag, sorted by OSMID
+    std::vector<std::pair<OSMID, unsigned char>> wayRoadTypes;
     
-    //Searches through all OSM Ways and their keys to determine road types
-    for (unsigned i = 0; i < getNumberOfWays(); i++){
-        //creates a pointer that enables accessing the way's OSMID
-        const OSMWay* wayPtr = getWayByIndex(i);
-        key="N/A"; //in case the way has no keys
-        for(int j = 0; j<getTagCount(wayPtr); ++j){
-            std::tie(key,value) = getTagPair(wayPtr,j);
-            
-            if (key == "highway"){
-                
-                if(value == "motorway")
-                    road_type = motorway;
-                else if (value == "trunk")
-                    road_type = trunk;
-                else if (value == "primary")
-                    road_type = primary;
-                else if (value == "secondary")
-                    road_type = secondary;
-                else if (value == "tertiary")
-                    road_type = tertiary;
-                else if (value == "residential")
-                    road_type = residential;
-                else road_type = unclassified;
-
-                WaybyRoadType.insert({wayPtr->id(), road_type}); //take the value of key and store it in global variable with OSMID
-                break;
-            }
-        }
+    //each thread scans a share of the ways, then appends what it found
+    #pragma omp parallel
+    {
+        std::vector<std::pair<OSMID, unsigned char>> found;
         
-    }
-    
-    //Searches through all OSM Relations and their keys to determine road types
-    //Repeats same process as above with Ways, except searches through relations
-    for (unsigned i = 0; i < getNumberOfRelations(); i++){
-        //creates a pointer that enables accessing the relation's OSMID
-        const OSMRelation* relationPtr = getRelationByIndex(i);
-        key="N/A"; //in case the way has no keys
-        for(int j=0;j<getTagCount(relationPtr); ++j){
-            std::tie(key,value) = getTagPair(relationPtr,j);
+        #pragma omp for schedule(static) nowait
+        for (int i = 0; i < numWays; i++){
+            const OSMWay* wayPtr = getWayByIndex(i);
             
-            if (key == "highway"){
+            for (int j = 0; j < getTagCount(wayPtr); ++j){
+                std::pair<std::string, std::string> tag = getTagPair(wayPtr, j);
                 
-                if(value == "motorway")
-                    road_type = motorway;
-                else if (value == "trunk")
-                    road_type = trunk;
-                else if (value == "primary")
-                    road_type = primary;
-                else if (value == "secondary")
-                    road_type = secondary;
-                else if (value == "tertiary")
-                    road_type = tertiary;
-                else if (value == "residential")
-                    road_type = residential;
-                else road_type = unclassified;
-
-                WaybyRoadType.insert({relationPtr->id(), road_type}); //take the value of key and store it in global variable with OSMID
-                break;
+                if (tag.first == "highway"){
+                    found.push_back(std::make_pair(wayPtr->id(), (unsigned char) road_type_from_highway_tag(tag.second)));
+                    break;
+                }
             }
         }
         
+        #pragma omp critical
+        wayRoadTypes.insert(wayRoadTypes.end(), found.begin(), found.end());
     }
     
-    //Searches through all OSM Nodes and their keys to determine road types
-    //also looks for POI tags
-    //Repeats same process as above, for node 
-    for (unsigned i = 0; i < getNumberOfNodes(); i++){
-        
-        //creates a pointer that enables accessing the node's OSMID
-        const OSMNode* nodePtr = getNodeByIndex(i);
+    std::sort(wayRoadTypes.begin(), wayRoadTypes.end());
+    
+    int numSegments = getNumStreetSegments();
+    SegmentRoadType.assign(numSegments, unclassified);
+    
+    #pragma omp parallel for schedule(static)
+    for (int segmentID = 0; segmentID < numSegments; segmentID++){
+        OSMID wayID = getInfoStreetSegment(segmentID).wayOSMID;
         
-        key="N/A"; //in case the way has no keys
-        for(int j=0;j<getTagCount(nodePtr); ++j){
-            
-            std::tie(key,value) = getTagPair(nodePtr,j);
-            
-            if (key == "highway"){
-                if(value == "motorway")
-                    road_type = motorway;
-                else if (value == "trunk")
-                    road_type = trunk;
-                else if (value == "primary")
-                    road_type = primary;
-                else if (value == "secondary")
-                    road_type = secondary;
-                else if (value == "tertiary")
-                    road_type = tertiary;
-                else if (value == "residential")
-                    road_type = residential;
-                else road_type = unclassified;
-
-                WaybyRoadType.insert({nodePtr->id(), road_type}); //take the value of key and store it in global variable with OSMID
-                //breaks out of the inner tag loop, increments to next node
-                break;
-            }
-
-        }
+        std::vector<std::pair<OSMID, unsigned char>>::const_iterator it = std::lower_bound(wayRoadTypes.begin(), wayRoadTypes.end(), std::make_pair(wayID, (unsigned char) 0));
+        if (it != wayRoadTypes.end() && it->first == wayID)
+            SegmentRoadType[segmentID] = it->second;
     }
 }
 
@@ -486,7 +693,8 @@ void populateFeatureIds_byType(){
 
 //Helper function called by DrawFeatures()
 //Draws all features of a specifc type (e.g Park, Beach, Lake, etc.)
-void drawFeature_byType(int feature_type, ezgl::renderer *g){  
+//Returns: number of features drawn
+int drawFeature_byType(int feature_type, ezgl::renderer *g){  
     
     g->set_line_width(3);
     //before drawing, sets colour appropriate to the feature
@@ -516,13 +724,28 @@ void drawFeature_byType(int feature_type, ezgl::renderer *g){
             default: g->set_color (64,64,64, 255);
         }
     int featureId, numOfFeaturePoints;
+    int numDrawn = 0;
+    
+    //fewer feature points are needed the further out the map is zoomed
+    int level = level_of_detail(g);
+    ezgl::rectangle visible = visible_world_with_strokes(g);
+    
     //goes through FeatureIds_byType vector, retrieves all featureIds of a certain type
     //draws features as either polylines or polygons
-    //uses Featurepoints_xy vector
+    //uses Featurepoints_xy vector (or its simplified version for the level of detail)
     for(size_t idx = 0; idx < FeatureIds_byType[feature_type].size(); ++idx){
 
         featureId = FeatureIds_byType[feature_type][idx];
-        numOfFeaturePoints = getFeaturePointCount(featureId);
+        
+        //skip features entirely outside the visible world (or whose outline can't reach into it)
+        const ezgl::rectangle& bounds = FeatureBounds[featureId];
+        if (bounds.right() < visible.left() || bounds.left() > visible.right() ||
+            bounds.top() < visible.bottom() || bounds.bottom() > visible.top())
+            continue;
+        
+        const std::vector<ezgl::point2d>& featurePoints = (level == 0) ? Featurepoints_xy[featureId] : Featurepoints_xy_LOD[level][featureId];
+        numOfFeaturePoints = featurePoints.size();
+        numDrawn++;
         //point2d has no default constructor
         ezgl::point2d xyPrevious(0,0);
         ezgl::point2d xyNext(0,0);
@@ -531,10 +754,10 @@ void drawFeature_byType(int feature_type, ezgl::renderer *g){
         if (FeatureAreaVector[featureId] == 0) {
             
             //iterate through feature points to get (x,y) coordinates  in order to draw the polyline)
-            for (unsigned featurePointId = 0; featurePointId < (numOfFeaturePoints - 1); featurePointId++){
+            for (int featurePointId = 0; featurePointId < (numOfFeaturePoints - 1); featurePointId++){
 
-                xyPrevious = Featurepoints_xy[featureId][featurePointId];
-                xyNext = Featurepoints_xy[featureId][featurePointId + 1];
+                xyPrevious = featurePoints[featurePointId];
+                xyNext = featurePoints[featurePointId + 1];
 
                 //draw line between feature points
                 g->draw_line({xyPrevious.x , xyPrevious.y}, {xyNext.x, xyNext.y});
@@ -543,9 +766,11 @@ void drawFeature_byType(int feature_type, ezgl::renderer *g){
         //otherwise, it is a polygon area
         else{
             //ezgl function which takes a vector<point2d> (i.e (x,y) coordinates for each point that defines the feature outline)
-            g->fill_poly(Featurepoints_xy[featureId]);
+            g->fill_poly(featurePoints);
         }
     }
+    
+    return numDrawn;
 }
 
 bool extract_streets_from_text(const char* text, std::string& street1, std::string& street2){
@@ -629,6 +854,23 @@ void act_on_mouse_click( ezgl:: application* app, GdkEventButton* /*unused*/, do
             
 }
 
+//F2 shows or hides the render statistics overlay, F3 appends the render statistics to RENDER_STATS_FILE
+void act_on_key_press(ezgl::application* app, GdkEventKey* /*unused*/, char* key_name){
+    
+    std::string key(key_name);
+    
+    if (key == "F2"){
+        ShowRenderStats = !ShowRenderStats;
+        app->refresh_drawing();
+    }
+    else if (key == "F3"){
+        if (RenderStats.dump(RENDER_STATS_FILE, MapName))
+            app->update_message ("Render statistics written to " RENDER_STATS_FILE);
+        else
+            app->update_message ("Failed to write " RENDER_STATS_FILE);
+    }
+}
+
 void initial_setup(ezgl::application *application, bool /*unused*/)
 {
 
@@ -699,12 +941,7 @@ void find_button(GtkWidget* /*unused*/, ezgl::application *application){
 
     
     //regardless of what mode it is, reset the segment highlights
-  while(!(segmentsHighlighted.empty())){
-        int segUnhighlightID = segmentsHighlighted.back();
-        segmentHighlight[segUnhighlightID].walking = false;
-        segmentHighlight[segUnhighlightID].driving = false;
-        segmentsHighlighted.pop_back();
-    }
+    clear_path_highlight();
 
     //two string variables needed to interpret input
     std::string street1, street2, suggested_streets;
@@ -815,45 +1052,49 @@ ezgl::point2d compute2DPolygonCentroid(int& featureId, std::vector< ezgl::point2
     }
 }
 
-void draw_feature_names(ezgl::renderer *g){
+void add_feature_name_labels(labelPlacer& labels){
+    
+    //feature names only show when zoomed in
+    if (scale_factor >= 0.05)
+        return;
     
     int feature_type;
-
-    g->set_text_rotation(0);
     
     //loops through FeatureCentroids hashtable, consisting of feature centroid locations with unique names
     for( std::unordered_map< int, ezgl::point2d >::iterator it = FeatureCentroids.begin();  it != FeatureCentroids.end(); it++){
         
         feature_type = getFeatureType((*it).first);
         
-        if( (scale_factor < 0.05) && (feature_type != Unknown) && (feature_type != Building) && (getFeatureName((*it).first) != "<noname>") ){
-               
+        if( (feature_type != Unknown) && (feature_type != Building) && (getFeatureName((*it).first) != "<noname>") ){
+            
+            ezgl::color colour(224,224,224, 255);
             switch(feature_type){
 
-                case     Park      : g->set_color (76,153,0, 255);
+                case     Park      : colour = ezgl::color(76,153,0, 255);
                                      break;
-                case     Beach     : g->set_color (160,160,160, 255);
+                case     Beach     : colour = ezgl::color(160,160,160, 255);
                                      break;       
-                case     Lake      : g->set_color (0,128,255, 255);
+                case     Lake      : colour = ezgl::color(0,128,255, 255);
                                      break;
-                case     River     : g->set_color (0,128,255, 255);
+                case     River     : colour = ezgl::color(0,128,255, 255);
                                      break;
-                case     Island    : g->set_color (255,255,255, 255);
+                case     Island    : colour = ezgl::color(255,255,255, 255);
                                      break;
-                case     Building  : g->set_color (255,255,255, 255);
+                case     Building  : colour = ezgl::color(255,255,255, 255);
                                      break;
-                case     Greenspace: g->set_color (76,153,0, 255);
+                case     Greenspace: colour = ezgl::color(76,153,0, 255);
                                      break;
-                case     Golfcourse: g->set_color (76,153,0, 255);
+                case     Golfcourse: colour = ezgl::color(76,153,0, 255);
                                      break;
-                case     Stream    : g->set_color (0,128,255, 255);
+                case     Stream    : colour = ezgl::color(0,128,255, 255);
                                      break;
 
-                default: g->set_color (224,224,224, 255);
+                default: colour = ezgl::color(224,224,224, 255);
             } 
             
-            //draw feature name in centre of polygon
-            g->draw_text((*it).second, getFeatureName((*it).first));
+            //feature name in centre of polygon, larger features placed first
+            double priority = 12 + std::min(FeatureAreaVector[(*it).first] / 1e7, 0.5);
+            labels.add((*it).second, getFeatureName((*it).first), 0, priority, colour);
             
         }
     }
@@ -879,28 +1120,32 @@ ezgl::point2d find_PolyLine_Middle(int featureId){
 }
 
 //function called in darw_main_canvas(), which draws all features in pre-determined order using helper function: drawFeatrues_byType)
-void drawFeatures(ezgl::renderer *g){
+//Returns: number of features drawn
+int drawFeatures(ezgl::renderer *g){
 
     g->set_line_dash(ezgl::line_dash::none);
     
     //color set in sub_function
-    drawFeature_byType(Park, g);
-    drawFeature_byType(Greenspace, g);
-    drawFeature_byType(Lake, g);
-    drawFeature_byType(Island, g);
-    drawFeature_byType(Beach, g);
-    drawFeature_byType(Golfcourse, g);
-    drawFeature_byType(River, g);
-    drawFeature_byType(Stream, g);
+    int numDrawn = 0;
+    numDrawn += drawFeature_byType(Park, g);
+    numDrawn += drawFeature_byType(Greenspace, g);
+    numDrawn += drawFeature_byType(Lake, g);
+    numDrawn += drawFeature_byType(Island, g);
+    numDrawn += drawFeature_byType(Beach, g);
+    numDrawn += drawFeature_byType(Golfcourse, g);
+    numDrawn += drawFeature_byType(River, g);
+    numDrawn += drawFeature_byType(Stream, g);
     
     if(scale_factor <  0.1){    
-        drawFeature_byType(Building, g);
-        drawFeature_byType(Unknown, g);
+        numDrawn += drawFeature_byType(Building, g);
+        numDrawn += drawFeature_byType(Unknown, g);
     }
+    
+    return numDrawn;
 }
 
-//function draws points of interest names on map
-void draw_points_of_interest(ezgl::renderer *g){
+//function adds points of interest names as candidate labels
+void add_poi_labels(labelPlacer& labels){
     //use two different enables because there are many more restaurants than libraries
     bool enable_poi_eat = true;
     bool enable_poi_lib = true;
@@ -912,330 +1157,329 @@ void draw_points_of_interest(ezgl::renderer *g){
     else if (scale_factor > 0.02)
         enable_poi_eat = false;
     
-    //Extract vectors from PointsOfInterest vector to make it easier to parse through each type separately
-    std::vector<poiStruct> library = PointsOfInterest[0];
-    std::vector<poiStruct> cafes = PointsOfInterest[1];
-    std::vector<poiStruct> fast_food = PointsOfInterest[2];
+    //PointsOfInterest types: 0 = library, 1 = cafe, 2 = fast_food
+    const ezgl::color poiColours[] = {ezgl::color(178,141,196, 255), ezgl::color(189,164, 143, 255), ezgl::color(233,128,96,255)};
     
-    //Declare iterator to go through each vector
-    std::vector<poiStruct>::iterator it = library.begin();
+    //libraries are placed before places to eat (there are far fewer of them)
+    const double poiPriorities[] = {14, 13, 13};
     
-    //Variables to extract data from poi struct
-    std::pair<double,double> xyCoordinates;
-    std::string poiName;
+    for (unsigned type = 0; type < PointsOfInterest.size(); type++){
+        
+        if ((type == 0 && !enable_poi_lib) || (type != 0 && !enable_poi_eat))
+            continue;
+        
+        for (std::vector<poiStruct>::const_iterator it = PointsOfInterest[type].begin(); it != PointsOfInterest[type].end(); ++it){
+            std::pair<double,double> xyCoordinates = (*it).xyCoordinates;
+            
+            //if 24/7, text is bold and placed first
+            bool allDay = ((*it).hours == "24/7");
+            
+            labels.add({xyCoordinates.first, xyCoordinates.second}, (*it).Name, 0, poiPriorities[type] + (allDay ? 0.5 : 0),
+                    poiColours[type], allDay ? boldFont : normalFont);
+        }
+    }
+}
+
+//function draws all streets on map (lines only, names are labels, see add_street_name_labels)
+//uses StreetSegmentGrid so only segments inside the visible world are visited (widened by a stroke, so a road just
+//outside a map tile still draws the part of its line inside it)
+//segments sharing a road type are drawn as one path, with a single stroke
+//path highlights are drawn separately (see draw_path_highlight), so this can run on the worker threads drawing map tiles
+//Returns: number of segments drawn
+
+int draw_streets(ezgl::renderer *g){
+    
+    //visible segments, grouped by road type (road types not drawn at this zoom level are never walked)
+    std::vector<bool> visibleRoadTypes = visible_road_types(g);
+    std::vector<std::vector<int>> visibleSegments;
+    StreetSegmentGrid.query(visible_world_with_strokes(g), visibleSegments, visibleRoadTypes);
+    
+    //fewer curve points are needed the further out the map is zoomed
+    //every segment's (x,y) points at this level of detail (level 0 is the original geometry)
+    int level = level_of_detail(g);
+    const std::vector<ezgl::point2d>& points = (level == 0) ? SegmentPointsXY : SegmentPointsXY_LOD[level];
+    const std::vector<int>& offsets = (level == 0) ? SegmentPointOffsets : SegmentPointOffsets_LOD[level];
     
-    //loop through library vector, extract data and draw names of libraries on map
-    while(it != library.end()){
-        xyCoordinates = (*it).xyCoordinates;
-        poiName = (*it).Name;
+    g->set_line_cap(ezgl::line_cap::round);
+    g->set_line_dash(ezgl::line_dash::none);
+    
+    //points of every segment in the group being drawn
+    std::vector<std::pair<int, int>> ranges;
+    int numDrawn = 0;
+    
+    for (RoadType roadType : StreetDrawOrder){
+        
+        //skip the whole road type if it is not drawn at this zoom level
+        if (!visibleRoadTypes[roadType] || roadType >= visibleSegments.size())
+            continue;
         
-        if (enable_poi_lib){
-            g->set_color (178,141,196, 255);
-            //if 24/7, draw text in bold
-            if((*it).hours == "24/7")
-                g->format_font("cairo", ezgl::font_slant::normal, ezgl::font_weight::bold);
-            else
-                g->format_font("cairo", ezgl::font_slant::normal, ezgl::font_weight::normal);
-
-            g->draw_text({xyCoordinates.first, xyCoordinates.second}, poiName);
+        set_street_style(g, roadType);
+        std::vector<int>& segments = visibleSegments[roadType];
+        ranges.clear();
+        
+        for (unsigned i = 0; i < segments.size(); i++){
+            ranges.push_back(std::make_pair(offsets[segments[i]], offsets[segments[i] + 1]));
         }
-        it++;
+        
+        g->draw_polylines(points, ranges);
+        numDrawn += ranges.size();
     }
     
-    //loop through cafes vector, extract data and draw names of cafes on map
-    it = cafes.begin();
-    while(it != cafes.end()){
-        xyCoordinates = (*it).xyCoordinates;
-        poiName = (*it).Name;
+    return numDrawn;
+}
+
+//function draws the segments of the path over the streets, regardless of zoom level
+//segments sharing a style are drawn as one path, with a single stroke
+//Returns: number of segments drawn
+int draw_path_highlight(ezgl::renderer *g){
+    
+    if (segmentsHighlighted.empty())
+        return 0;
+    
+    int level = level_of_detail(g);
+    const std::vector<ezgl::point2d>& points = (level == 0) ? SegmentPointsXY : SegmentPointsXY_LOD[level];
+    const std::vector<int>& offsets = (level == 0) ? SegmentPointOffsets : SegmentPointOffsets_LOD[level];
+    
+    g->set_line_cap(ezgl::line_cap::round);
+    g->set_line_dash(ezgl::line_dash::none);
+    
+    std::vector<std::pair<int, int>> ranges;
+    int numDrawn = 0;
+    
+    //segments of a path are drawn regardless of zoom level
+    //walking keeps the road type's width, so it is drawn per road type, driving is drawn all at once
+    for (RoadType roadType : StreetDrawOrder){
         
-        if (enable_poi_eat){
-            g->set_color (189,164, 143, 255);
-            //if 24/7, draw text in bold
-            if((*it).hours == "24/7")
-                g->format_font("cairo", ezgl::font_slant::normal, ezgl::font_weight::bold);
-            else
-                g->format_font("cairo", ezgl::font_slant::normal, ezgl::font_weight::normal);
+        ranges.clear();
+        for (std::list<int>::const_iterator it = segmentsHighlighted.begin(); it != segmentsHighlighted.end(); ++it){
+            if (SegmentRoadType[*it] == roadType && !segmentHighlight[*it].driving && segmentHighlight[*it].walking)
+                ranges.push_back(std::make_pair(offsets[*it], offsets[*it + 1]));
+        }
         
-            g->draw_text({xyCoordinates.first, xyCoordinates.second}, poiName);
+        if (!ranges.empty()){
+            set_street_style(g, roadType);
+            g->set_color (Colour_walking_highlight);
+            g->draw_polylines(points, ranges);
+            numDrawn += ranges.size();
         }
-        it++;
     }
     
-    //loop through fast_food vector, extract data and draw names of fast_foods on map
-    it = fast_food.begin();
-    while(it != fast_food.end()){
-        xyCoordinates = (*it).xyCoordinates;
-        poiName = (*it).Name;
+    ranges.clear();
+    for (std::list<int>::const_iterator it = segmentsHighlighted.begin(); it != segmentsHighlighted.end(); ++it){
+        if (segmentHighlight[*it].driving)
+            ranges.push_back(std::make_pair(offsets[*it], offsets[*it + 1]));
+    }
+    
+    if (!ranges.empty()){
+        g->set_line_width (3);
+        g->set_color (Colour_driving_highlight);
+        g->draw_polylines(points, ranges);
+        numDrawn += ranges.size();
+    }
+    
+    return numDrawn;
+}
+
+//function adds the names of all visible streets as candidate labels
+//(drawn live rather than in map tiles, so names are never cut at tile edges)
+void add_street_name_labels(ezgl::renderer *g, labelPlacer& labels){
+    
+    //names only show for road types drawn at this zoom level
+    std::vector<bool> visibleRoadTypes = visible_road_types(g);
+    std::vector<std::vector<int>> visibleSegments;
+    StreetSegmentGrid.query(g->get_visible_world(), visibleSegments, visibleRoadTypes);
+    
+    for (RoadType roadType : StreetDrawOrder){
+        
+        if (!visibleRoadTypes[roadType] || roadType >= visibleSegments.size())
+            continue;
         
-        if (enable_poi_eat){
-            g->set_color (233,128,96,255);
-            //if 24/7, draw text in bold
-            if((*it).hours == "24/7")
-                g->format_font("cairo", ezgl::font_slant::normal, ezgl::font_weight::bold);
-            else
-                g->format_font("cairo", ezgl::font_slant::normal, ezgl::font_weight::normal);
+        std::vector<int>& segments = visibleSegments[roadType];
+        
+        for (unsigned i = 0; i < segments.size(); i++){
+            
+            //names of a path are added below
+            if (segmentHighlight[segments[i]].driving || segmentHighlight[segments[i]].walking)
+                continue;
             
-            g->draw_text({xyCoordinates.first, xyCoordinates.second}, poiName);
+            add_street_segment_label(labels, segments[i], roadType, street_label_priority(segments[i], roadType));
         }
-        
-        it++;
     }
-    //set font back to default
-    g->format_font("cairo", ezgl::font_slant::normal, ezgl::font_weight::normal);
+    
+    //names of a path show regardless of zoom level, ahead of every other label
+    for (std::list<int>::iterator it = segmentsHighlighted.begin(); it != segmentsHighlighted.end(); ++it){
+        RoadType roadType = (RoadType) SegmentRoadType[*it];
+        add_street_segment_label(labels, *it, roadType, 20 + street_label_priority(*it, roadType));
+    }
 }
 
-//function draws all streets on map
-//uses StreetVector from m1.cpp
+//Returns: label priority of a street segment's name (major roads first, then longer segments first)
+double street_label_priority(int segmentID, RoadType roadType){
+    
+    //position in StreetDrawOrder (motorways last, so highest)
+    int rank = std::find(StreetDrawOrder, StreetDrawOrder + NUM_ROAD_TYPES, roadType) - StreetDrawOrder;
+    
+    return 1 + rank + std::min(SegmentLengths[segmentID] / 10000, 0.5);
+}
 
-void draw_streets(ezgl::renderer *g){
+//Sets colour and line width of a street of the given road type (depends on scale_factor)
+//Returns: false if streets of this road type are not drawn at this zoom level
+bool set_street_style(ezgl::renderer *g, RoadType roadType){
     
-    //variables needed to draw streets
-    int segmentID;
-    RoadType roadType;
-    //enabler based on zoom
     bool enableDraw = true;
-    std::vector<int> segments;
-    int numCurvePoints;
-    struct InfoStreetSegment segmentInfo;
+    
+    //scale_factor used to set a variety of line widths and displays of roads    
+    switch(roadType){
+
+      //Motorways are always drawn, regardless of zoom level
+        case motorway     : g->set_line_width (2.9);
+                            if (scale_factor <  0.2)
+                                g->set_line_width (3.5);//change thickness of road drawn depending on zoom level
+                            g->set_color(Colour_motorway);
+                            break;
+    
+        case trunk        : g->set_color (Colour_trunk);
+                            g->set_line_width (2.8);
+                            if (scale_factor <  0.2)
+                                g->set_line_width (3.5);//change thickness of road drawn depending on zoom level
+                            break;
+     
+        case primary      : g->set_color (Colour_primary);
+                            if (scale_factor > 0.60) //only enable drawing these streets if zoomed in enough
+                                enableDraw = false;
+                            g->set_line_width (2.75);
+                            if (scale_factor <  0.2)
+                                g->set_line_width (3.5);//change thickness of road drawn depending on zoom level
+                            break;
+                            
+        case secondary    : g->set_color (Colour_secondary);
+                            g->set_line_width (2.6);
+                            if (scale_factor > 0.40) //only enable drawing these streets if zoomed in enough
+                                enableDraw = false;
+                            if (scale_factor <  0.02)
+                                g->set_line_width (3);//change thickness of road drawn depending on zoom level
+                            break;
+                            
+        case tertiary     : if (scale_factor > 0.30) //only enable drawing these streets if zoomed in enough
+                                enableDraw = false;
+                            g->set_color (Colour_tertiary);
+                            g->set_line_width (2.25);
+                            if (scale_factor <  0.02)
+                              g->set_line_width (3);//change thickness of road drawn depending on zoom level
+                            break;
+    
+        case residential  : if (scale_factor > 0.05)//only enable drawing these streets if zoomed in enough
+                                enableDraw = false;
+                            g->set_color (Colour_residential);
+                            g->set_line_width (2);
+                            if (scale_factor <  0.02)
+                                g->set_line_width (3);//change thickness of road drawn depending on zoom level
+                            break;
+                            
+        case unclassified : if (scale_factor > 0.05)//only enable drawing these streets if zoomed in enough
+                                enableDraw = false;
+                            g->set_color (Colour_unclassified);
+                            g->set_line_width (2);
+                            if (scale_factor <  0.02)
+                                g->set_line_width (3);//change thickness of road drawn depending on zoom level
+                            break;
+                            
+        default           : if (scale_factor > 0.30)
+                                enableDraw = false;//only enable drawing these streets if zoomed in enough
+                            g->set_line_width (2);
+                            g->set_color (Colour_unclassified);
+    }
+    
+    return enableDraw;
+}
+
+//Returns: key [road type] value: [true if streets of that road type are drawn at this zoom level] (see set_street_style)
+std::vector<bool> visible_road_types(ezgl::renderer *g){
+    
+    std::vector<bool> visibleRoadTypes(NUM_ROAD_TYPES);
+    for (int roadType = 0; roadType < NUM_ROAD_TYPES; roadType++){
+        visibleRoadTypes[roadType] = set_street_style(g, (RoadType) roadType);
+    }
+    
+    return visibleRoadTypes;
+}
+
+//Adds one street segment's name as candidate labels (always from the full geometry)
+void add_street_segment_label(labelPlacer& labels, int segmentID, RoadType roadType, double priority){
+    
+    InfoStreetSegment segmentInfo = getInfoStreetSegment(segmentID); //retrieve all info of segment
+    int numCurvePoints = segmentInfo.curvePointCount;
     
     //variables needed to draw street names
-    std::string streetName;
-    double segmentLength;
+    std::string streetName = StreetVector[segmentInfo.streetID].streetName;
+    double segmentLength = SegmentLengths[segmentID];
     std::pair <double, double> xyFrom;
     std::pair <double, double> xyTo;
     
+    int firstPoint = SegmentPointOffsets[segmentID];
+    int lastPoint = SegmentPointOffsets[segmentID + 1] - 1;
     
-    g->set_line_cap(ezgl::line_cap::round);
-    //loops through StreetVector to retrieve street segments of each street
-    for (int streetIdx = 0; streetIdx < StreetVector.size(); streetIdx++ ){ 
-        //retrieve streetSegements vector from StreetVector struct (defined in m1)
-        segments = StreetVector[streetIdx].streetSegments;
+    xyFrom = std::make_pair(SegmentPointsXY[firstPoint].x, SegmentPointsXY[firstPoint].y);
+    xyTo = std::make_pair(SegmentPointsXY[lastPoint].x, SegmentPointsXY[lastPoint].y);
 
-        streetName = getStreetName(streetIdx);
-        
-        //Draw each segment of each street
-        for (int i = 0; i < segments.size(); i++ ){
-            
-            enableDraw = true;
-            
-            //retrieve segmentId from segments vector
-            segmentID = segments[i];
-   
-            segmentLength = SegmentLengths[segmentID]; 
-            
-            segmentInfo = getInfoStreetSegment(segmentID); //retrieve all info of segment
-            
-            numCurvePoints = segmentInfo.curvePointCount;
-            
-            //retrieve segment road type from WaybyRoadType hashtable
-            roadType = WaybyRoadType.at(segmentInfo.wayOSMID); 
-            
-            //scale_factor used to set a variety of line widths and displays of roads    
-            switch(roadType){
-
-              //Motorways are always drawn, regardless of zoom level
-                case motorway     : g->set_line_width (2.9);
-                                    if (scale_factor <  0.2)
-                                        g->set_line_width (3.5);//change thickness of road drawn depending on zoom level
-                                    g->set_color(Colour_motorway);
-                                    break;
-            
-                case trunk        : g->set_color (Colour_trunk);
-                                    g->set_line_width (2.8);
-                                    if (scale_factor <  0.2)
-                                        g->set_line_width (3.5);//change thickness of road drawn depending on zoom level
-                                    break;
-     
-                case primary      : g->set_color (Colour_primary);
-                                    if (scale_factor > 0.60) //only enable drawing these streets if zoomed in enough
-                                        enableDraw = false;
-                                    g->set_line_width (2.75);
-                                    if (scale_factor <  0.2)
-                                        g->set_line_width (3.5);//change thickness of road drawn depending on zoom level
-                                    break;
-                                    
-                case secondary    : g->set_color (Colour_secondary);
-                                    g->set_line_width (2.6);
-                                    if (scale_factor > 0.40) //only enable drawing these streets if zoomed in enough
-                                        enableDraw = false;
-                                    if (scale_factor <  0.02)
-                                        g->set_line_width (3);//change thickness of road drawn depending on zoom level
-                                    break;
-                                    
-                case tertiary     : if (scale_factor > 0.30) //only enable drawing these streets if zoomed in enough
-                                        enableDraw = false;
-                                    g->set_color (Colour_tertiary);
-                                    g->set_line_width (2.25);
-                                    if (scale_factor <  0.02)
-                                      g->set_line_width (3);//change thickness of road drawn depending on zoom level
-                                    break;
-            
-                case residential  : if (scale_factor > 0.05)//only enable drawing these streets if zoomed in enough
-                                        enableDraw = false;
-                                    g->set_color (Colour_residential);
-                                    g->set_line_width (2);
-                                    if (scale_factor <  0.02)
-                                        g->set_line_width (3);//change thickness of road drawn depending on zoom level
-                                    break;
-                                    
-                case unclassified : if (scale_factor > 0.05)//only enable drawing these streets if zoomed in enough
-                                        enableDraw = false;
-                                    g->set_color (Colour_unclassified);
-                                    g->set_line_width (2);
-                                    if (scale_factor <  0.02)
-                                        g->set_line_width (3);//change thickness of road drawn depending on zoom level
-                                    break;
-                                    
-                default           : if (scale_factor > 0.30)
-                                        enableDraw = false;//only enable drawing these streets if zoomed in enough
-                                    g->set_line_width (2);
-                                    g->set_color (Colour_unclassified);
-            }     
-            
-            if (segmentHighlight[segmentID].driving){
-                    g->set_line_width (3);
-                    g->set_color (Colour_driving_highlight);
-                    enableDraw = true;
-            }
-            else if (segmentHighlight[segmentID].walking){
-//                    g->set_line_width (2);
-                    enableDraw = true;
-                    g->set_color (Colour_walking_highlight);
+     //if segment is a straight line
+    if (numCurvePoints == 0){
+
+            if(streetName != "<unknown>"){// "<unknown>" street name not drawn
+                    if (!(roadType ==motorway&& scale_factor > 0.6)){ //motorway names will not show unless zoomed in a little (makes the default display look cleaner)
+                    add_straight_street_labels(labels, xyFrom, xyTo, segmentLength, streetName, segmentInfo.oneWay, priority);
+                }
             }
+    }
             
-            if (enableDraw){
-                
-//                if (segmentHighlight[segmentID].driving){
-////                    g->set_line_width (5);
-//                    g->set_color (Colour_driving_highlight);
-//                }
-//                else if (segmentHighlight[segmentID].walking){
-////                    g->set_line_width (2);
-//                    g->set_color (Colour_walking_highlight);
-//                }
-//                
-                xyFrom = latLonToCartesian(intersections[segmentInfo.from].position);
-                xyTo = latLonToCartesian(intersections[segmentInfo.to].position);
-
-                 //if segment is a straight line
-                if (numCurvePoints == 0){
-
-                        g->set_line_dash(ezgl::line_dash::none);
-                        g->draw_line({xyFrom.first, xyFrom.second}, {xyTo.first, xyTo.second});
-
-                        if(streetName != "<unknown>"){// "<unknown>" street name not drawn
-                                if (!(roadType ==motorway&& scale_factor > 0.6)){ //motorway names will not show unless zoomed in a little (makes the default display look cleaner)
-                                draw_street_name(g, xyFrom, xyTo, segmentLength, streetName, segmentInfo.oneWay);
-                            }
-                        }
-                }
-                        
-                else{ //segment is curved
+    else{ //segment is curved
 
-                    //First draw street's line, then the text
-                    //first deal with all curves from segment's "from" intersection to the last curve point
-
-                    //first curve of the segment
-                    LatLon pointsLeft  = getIntersectionPosition(segmentInfo.from);
-                    LatLon pointsRight = getStreetSegmentCurvePoint(0, segmentID);
-
-                    //also determine curve segment that is the longest
-                    double maxCurveLength = 0;
-                    //track the place where the max curve length exists
-                    int maxCurvePosition = 0; // 0 means the max is between segment's from and the first curve point. 1 means the max is between the 1st and 2nd curve points
-                    maxCurveLength = find_distance_between_two_points(std::pair <LatLon, LatLon>(pointsLeft, pointsRight));
-                    
-                    std::pair <double, double> xyLeft = latLonToCartesian(pointsLeft);
-                    std::pair <double, double> xyRight = latLonToCartesian(pointsRight);
-
-                    g->draw_line({xyLeft.first, xyLeft.second}, {xyRight.first, xyRight.second});
-
-                    for (int curvePointIndex = 0; curvePointIndex < numCurvePoints - 1; curvePointIndex++){
-                        pointsLeft = pointsRight;
-                        pointsRight = getStreetSegmentCurvePoint(curvePointIndex + 1, segmentID);
-                        
-                        double curveLength = find_distance_between_two_points(std::pair <LatLon, LatLon>(pointsLeft, pointsRight));
-                        if (curveLength > maxCurveLength){
-                            maxCurveLength = curveLength;
-                            maxCurvePosition = curvePointIndex + 1;
-                        }
-                        
-                        xyLeft = latLonToCartesian(pointsLeft);
-                        xyRight = latLonToCartesian(pointsRight);
-
-                        g->draw_line({xyLeft.first, xyLeft.second}, {xyRight.first, xyRight.second});
-                    }
-
-                    //then, deal with the last curve point to the segment's "to" intersection
-                    pointsLeft = pointsRight;
-                    pointsRight = getIntersectionPosition(segmentInfo.to);
-
-                    double curveLength = find_distance_between_two_points(std::pair <LatLon, LatLon>(pointsLeft, pointsRight));
-                        if (curveLength > maxCurveLength){
-                            maxCurveLength = curveLength;
-                            maxCurvePosition = numCurvePoints;
-                        }
-
-                    xyLeft = latLonToCartesian(pointsLeft);
-                    xyRight = latLonToCartesian(pointsRight); 
+        //Draw street name
+        
+        //if zoomed out too far, do not draw street name of major roads (many cities have several motorways adjacent, which causes street names to look squished)
+        if (!((roadType ==motorway ||roadType ==trunk)&& scale_factor > 0.075)){
 
-                    g->draw_line({xyLeft.first, xyLeft.second}, {xyRight.first, xyRight.second});
-                    
-                    //Draw street name
-                    
-                    //if zoomed out too far, do not draw street name of major roads (many cities have several motorways adjacent, which causes street names to look squished)
-                    if (!((roadType ==motorway ||roadType ==trunk)&& scale_factor > 0.075)){
-
-                        if(streetName != "<unknown>"){// "<unknown>" street name not drawn
-                            std::pair <double, double> xyLeftMax;// =  latLonToCartesian(getStreetSegmentCurvePoint(maxCurvePosition, segmentID));
-                            std::pair <double, double> xyRightMax;// =  latLonToCartesian(getStreetSegmentCurvePoint(maxCurvePosition + 1, segmentID));
-    //                        
-                            if (maxCurvePosition==0){
-                                xyLeftMax = latLonToCartesian(getIntersectionPosition(segmentInfo.from));
-                            }
-                            else
-                                xyLeftMax = latLonToCartesian(getStreetSegmentCurvePoint(maxCurvePosition - 1, segmentID));
-
-                            if (maxCurvePosition==numCurvePoints){
-                                xyRightMax = latLonToCartesian(getIntersectionPosition(segmentInfo.to));
-                            }
-                            else
-                                 xyRightMax =  latLonToCartesian(getStreetSegmentCurvePoint(maxCurvePosition, segmentID));
-    //                        
-                            double xMiddleOfSegment = (xyLeftMax.first + xyRightMax.first)/2;
-                            double yMiddleOfSegment = (xyLeftMax.second + xyRightMax.second)/2;
-                            std::string streetSegName = streetName; //saves copy of street name
-                            if (segmentInfo.oneWay){
-                                std::string direction_symbol = ">"; //symbol for one way street
-                                if (xyFrom.first > xyTo.first) {
-                                         direction_symbol = "<"; //reverse direction
-                                    }
-                                streetSegName = direction_symbol + "    " + streetSegName + "    " + direction_symbol;
-                            }
-
-                            g->set_text_rotation(getRotationAngleForText(xyLeftMax, xyRightMax));
-                            g->set_color(ezgl::WHITE);
-                            g->draw_text({xMiddleOfSegment, yMiddleOfSegment}, streetSegName, segmentLength, segmentLength);
+            if(streetName != "<unknown>"){// "<unknown>" street name not drawn
+                //the longest curve segment (precomputed at load) is where the street name goes
+                // 0 means the max is between segment's from and the first curve point. 1 means the max is between the 1st and 2nd curve points
+                int maxCurvePosition = SegmentLongestPiece[segmentID];
+                
+                ezgl::point2d leftMax = SegmentPointsXY[firstPoint + maxCurvePosition];
+                ezgl::point2d rightMax = SegmentPointsXY[firstPoint + maxCurvePosition + 1];
+                std::pair <double, double> xyLeftMax(leftMax.x, leftMax.y);
+                std::pair <double, double> xyRightMax(rightMax.x, rightMax.y);
+                
+                double xMiddleOfSegment = (xyLeftMax.first + xyRightMax.first)/2;
+                double yMiddleOfSegment = (xyLeftMax.second + xyRightMax.second)/2;
+                std::string streetSegName = streetName; //saves copy of street name
+                if (segmentInfo.oneWay){
+                    std::string direction_symbol = ">"; //symbol for one way street
+                    if (xyFrom.first > xyTo.first) {
+                             direction_symbol = "<"; //reverse direction
                         }
-                    }
+                    streetSegName = direction_symbol + "    " + streetSegName + "    " + direction_symbol;
                 }
+
+                labels.add({xMiddleOfSegment, yMiddleOfSegment}, streetSegName, getRotationAngleForText(xyLeftMax, xyRightMax), 
+                        priority, ezgl::WHITE, normalFont, segmentLength);
             }
         }
     }
 }
 
 
-void draw_street_name(ezgl::renderer* g, std::pair<double, double>& xyFrom, std::pair<double, double>& xyTo, double& segmentLength, std::string& streetName, bool oneWay)
+void add_straight_street_labels(labelPlacer& labels, std::pair<double, double>& xyFrom, std::pair<double, double>& xyTo, double& segmentLength, std::string& streetName, bool oneWay, double priority)
 {
     /**
-    * Draws street name for only a STRAIGHT street segment. If segment is curved, drawing of street name happens in draw_streets
-    * @param g
+    * Adds street name labels for only a STRAIGHT street segment. If segment is curved, its label is added in add_street_segment_label
+    * @param labels
     * @param xyFrom
     * @param xyTo
     * @param numCurvePoints
     * @param segmentLength
     * @param streetName
     * @param oneWay
+    * @param priority
     */
 
     //Variables for drawing text of street segments
@@ -1244,13 +1488,13 @@ void draw_street_name(ezgl::renderer* g, std::pair<double, double>& xyFrom, std:
 
     //Greater screen_ratio = more reprinting of street name and arrows: < (for oneway streets)
     double screen_ratio = segmentLength / scale_factor; //screen_ratio is the available length of the street segment on screen.
-    g ->set_color(224, 224, 224, 255);
+    ezgl::color colour(224, 224, 224, 255);
 
         xMiddleOfSegment = 0.5 * (xyFrom.first + xyTo.first);
         yMiddleOfSegment = 0.5 * (xyFrom.second + xyTo.second);
         
-        //set rotation for text to draw
-        g->set_text_rotation(getRotationAngleForText(xyFrom, xyTo));
+        //rotation of the text to draw
+        double rotation = getRotationAngleForText(xyFrom, xyTo);
 
         //set default direction for one way street
         std::string direction_symbol = ">"; //symbol for one way street
@@ -1263,100 +1507,98 @@ void draw_street_name(ezgl::renderer* g, std::pair<double, double>& xyFrom, std:
         //if there is only enough space to draw direction
         if (screen_ratio < 5000) {
             if (oneWay) {
-                g->draw_text({ xMiddleOfSegment,
+                labels.add({ xMiddleOfSegment,
                                     yMiddleOfSegment },
-                          direction_symbol, segmentLength, segmentLength);
+                          direction_symbol, rotation, priority, colour, normalFont, segmentLength);
             }
         }
 
         //if only enough space to draw name
         else if (screen_ratio < 20000) {
-            g->draw_text({ xMiddleOfSegment,
+            labels.add({ xMiddleOfSegment,
                                 yMiddleOfSegment },
-                      streetName, segmentLength, segmentLength);
+                      streetName, rotation, priority, colour, normalFont, segmentLength);
         }
 
         //draw:  [direction] [name] [direction]
         else if (screen_ratio < 30000) {
-            g->draw_text({ xMiddleOfSegment,
+            labels.add({ xMiddleOfSegment,
                                 yMiddleOfSegment },
-                      streetName, segmentLength, segmentLength);
+                      streetName, rotation, priority, colour, normalFont, segmentLength);
             if (oneWay) {
-                g->draw_text({ (xMiddleOfSegment + xyFrom.first) / 2,
+                labels.add({ (xMiddleOfSegment + xyFrom.first) / 2,
                                     (yMiddleOfSegment + xyFrom.second) / 2 },
-                          direction_symbol, segmentLength, segmentLength);
-                g->draw_text({ (xMiddleOfSegment + xyTo.first) / 2,
+                          direction_symbol, rotation, priority, colour, normalFont, segmentLength);
+                labels.add({ (xMiddleOfSegment + xyTo.first) / 2,
                                     (yMiddleOfSegment + xyTo.second) / 2 },
-                          direction_symbol, segmentLength, segmentLength);
+                          direction_symbol, rotation, priority, colour, normalFont, segmentLength);
             }
         }
 
         //draw:  [direction] [name] [direction] [name] [direction]
         else if (screen_ratio < 50000) {
-            g->draw_text({ (2 * xMiddleOfSegment + xyFrom.first) / 3,
+            labels.add({ (2 * xMiddleOfSegment + xyFrom.first) / 3,
                                 (2 * yMiddleOfSegment + xyFrom.second) / 3 },
-                      streetName, segmentLength, segmentLength);
-            g->draw_text({ (2 * xMiddleOfSegment + xyTo.first) / 3,
+                      streetName, rotation, priority, colour, normalFont, segmentLength);
+            labels.add({ (2 * xMiddleOfSegment + xyTo.first) / 3,
                                 (2 * yMiddleOfSegment + xyTo.second) / 3 },
-                      streetName, segmentLength, segmentLength);
+                      streetName, rotation, priority, colour, normalFont, segmentLength);
 
             if (oneWay) {
-                g->draw_text({ xMiddleOfSegment,
+                labels.add({ xMiddleOfSegment,
                                     yMiddleOfSegment },
-                          direction_symbol, segmentLength, segmentLength);
-                g->draw_text({ (((2 * xMiddleOfSegment + xyFrom.first) / 3) + xyFrom.first) / 2,
+                          direction_symbol, rotation, priority, colour, normalFont, segmentLength);
+                labels.add({ (((2 * xMiddleOfSegment + xyFrom.first) / 3) + xyFrom.first) / 2,
                                     (((2 * yMiddleOfSegment + xyFrom.second) / 3) + xyFrom.second) / 2 },
-                          direction_symbol, segmentLength, segmentLength);
-                g->draw_text({ (((2 * xMiddleOfSegment + xyTo.first) / 3) + xyTo.first) / 2,
+                          direction_symbol, rotation, priority, colour, normalFont, segmentLength);
+                labels.add({ (((2 * xMiddleOfSegment + xyTo.first) / 3) + xyTo.first) / 2,
                                     (((2 * yMiddleOfSegment + xyTo.second) / 3) + xyTo.second) / 2 },
-                          direction_symbol, segmentLength, segmentLength);
+                          direction_symbol, rotation, priority, colour, normalFont, segmentLength);
             }
         }
 
         //draw:  [direction] [name] [direction] [name] [direction] [name] [direction]
         else {
-            g->draw_text({ xMiddleOfSegment,
+            labels.add({ xMiddleOfSegment,
                                 yMiddleOfSegment },
-                      streetName, segmentLength, segmentLength);
-            g->draw_text({ (xMiddleOfSegment + xyFrom.first) / 2,
+                      streetName, rotation, priority, colour, normalFont, segmentLength);
+            labels.add({ (xMiddleOfSegment + xyFrom.first) / 2,
                                 (yMiddleOfSegment + xyFrom.second) / 2 },
-                      streetName, segmentLength, segmentLength);
-            g->draw_text({ (xMiddleOfSegment + xyTo.first) / 2,
+                      streetName, rotation, priority, colour, normalFont, segmentLength);
+            labels.add({ (xMiddleOfSegment + xyTo.first) / 2,
                                 (yMiddleOfSegment + xyTo.second) / 2 },
-                      streetName, segmentLength, segmentLength);
+                      streetName, rotation, priority, colour, normalFont, segmentLength);
 
             if (oneWay) {
-                g->draw_text({ (((xMiddleOfSegment + xyFrom.first) / 2) + xyFrom.first) / 2,
+                labels.add({ (((xMiddleOfSegment + xyFrom.first) / 2) + xyFrom.first) / 2,
                                     (((yMiddleOfSegment + xyFrom.second) / 2) + xyFrom.second) / 2 },
-                          direction_symbol, segmentLength, segmentLength);
-                g->draw_text({ (((xMiddleOfSegment + xyFrom.first) / 2) + xMiddleOfSegment) / 2,
+                          direction_symbol, rotation, priority, colour, normalFont, segmentLength);
+                labels.add({ (((xMiddleOfSegment + xyFrom.first) / 2) + xMiddleOfSegment) / 2,
                                     (((yMiddleOfSegment + xyFrom.second) / 2) + yMiddleOfSegment) / 2 },
-                          direction_symbol, segmentLength, segmentLength);
-                g->draw_text({ (((xMiddleOfSegment + xyTo.first) / 2) + xMiddleOfSegment) / 2,
+                          direction_symbol, rotation, priority, colour, normalFont, segmentLength);
+                labels.add({ (((xMiddleOfSegment + xyTo.first) / 2) + xMiddleOfSegment) / 2,
                                     (((yMiddleOfSegment + xyTo.second) / 2) + yMiddleOfSegment) / 2 },
-                          direction_symbol, segmentLength, segmentLength);
-                g->draw_text({ (((xMiddleOfSegment + xyTo.first) / 2) + xyTo.first) / 2,
+                          direction_symbol, rotation, priority, colour, normalFont, segmentLength);
+                labels.add({ (((xMiddleOfSegment + xyTo.first) / 2) + xyTo.first) / 2,
                                     (((yMiddleOfSegment + xyTo.second) / 2) + xyTo.second) / 2 },
-                          direction_symbol, segmentLength, segmentLength);
+                          direction_symbol, rotation, priority, colour, normalFont, segmentLength);
             }
         }
-        //for safety, set rotation back to zero
-        g->set_text_rotation(0);
     
 }
 
-void draw_intersections(ezgl::renderer *g){
+//Returns: number of intersections drawn
+int draw_intersections(ezgl::renderer *g){
     
+     int numDrawn = 0;
+     
      if (scale_factor <=0.01) {
          
         for(size_t i = 0; i < intersections.size(); ++i){
 
-          double x = intersections[i].position.lon();
-          double y = intersections[i].position.lat();
-
-          //must convert lat lon values to cartesian (refer to tutorial slides)
-          x = x_from_lon(x);
-          y = y_from_lat(y);
+          //cartesian position was projected at load
+          double x = IntersectionXY[i].x;
+          double y = IntersectionXY[i].y;
 
           float width;
           if (scale_factor > 0.005)
@@ -1370,18 +1612,18 @@ void draw_intersections(ezgl::renderer *g){
 
           float height = width;
 
-          if (intersections[i].highlight)
-              g->set_color(ezgl::LIME_GREEN);
-          else
-              g->set_color(ezgl::BLUE);
+          //highlighted intersections are drawn over these, in the overlay (see draw_path_overlay)
+          g->set_color(ezgl::BLUE);
 
           //for intersection id, get segs. Check seg's lowest threshold value
           //for that threshold value, enable or disable drawing
             g->fill_rectangle({x-(width/2),y-(height/2)}, {x + (width/2), y + (height/2)});
+            numDrawn++;
     
         }
     }
     
+    return numDrawn;
 }
 
 
@@ -1429,6 +1671,98 @@ void populateFeaturepoints_xy(){
             Featurepoints_xy[featureId].push_back(featurePoint_point2d);
         }     
     } 
+    
+    //bounding boxes, so features outside the visible world are skipped when drawing
+    FeatureBounds.clear();
+    FeatureBounds.reserve(Featurepoints_xy.size());
+    for (unsigned featureId = 0; featureId < Featurepoints_xy.size(); ++featureId){
+        ezgl::point2d low(0, 0);
+        ezgl::point2d high(0, 0);
+        if (!Featurepoints_xy[featureId].empty()){
+            low = Featurepoints_xy[featureId][0];
+            high = low;
+        }
+        for (unsigned point = 1; point < Featurepoints_xy[featureId].size(); point++){
+            low.x = std::min(low.x, Featurepoints_xy[featureId][point].x);
+            low.y = std::min(low.y, Featurepoints_xy[featureId][point].y);
+            high.x = std::max(high.x, Featurepoints_xy[featureId][point].x);
+            high.y = std::max(high.y, Featurepoints_xy[featureId][point].y);
+        }
+        FeatureBounds.push_back(ezgl::rectangle(low, high));
+    }
+}
+
+//Populates SegmentPointsXY_LOD, SegmentPointOffsets_LOD and Featurepoints_xy_LOD
+//Every level is simplified (Douglas-Peucker) from the original geometry, so a level is never further than its own
+//tolerance from the real line (simplifying from the level before would add up the tolerances of every level)
+//Must be called after populateFeaturepoints_xy
+void populateLevelsOfDetail(){
+    
+    int numSegments = getNumStreetSegments();
+    
+    SegmentPointsXY_LOD.assign(NUM_LOD_LEVELS, std::vector<ezgl::point2d>());
+    SegmentPointOffsets_LOD.assign(NUM_LOD_LEVELS, std::vector<int>());
+    Featurepoints_xy_LOD.assign(NUM_LOD_LEVELS, std::vector<std::vector<ezgl::point2d>>());
+    
+    for (int level = 1; level < NUM_LOD_LEVELS; level++){
+        
+        SegmentPointOffsets_LOD[level].resize(numSegments + 1);
+        
+        for (int segmentID = 0; segmentID < numSegments; segmentID++){
+            SegmentPointOffsets_LOD[level][segmentID] = SegmentPointsXY_LOD[level].size();
+            
+            int firstPoint = SegmentPointOffsets[segmentID];
+            simplifyPolyline(&SegmentPointsXY[firstPoint], SegmentPointOffsets[segmentID + 1] - firstPoint, 
+                    LODTolerances[level], SegmentPointsXY_LOD[level]);
+        }
+        SegmentPointOffsets_LOD[level][numSegments] = SegmentPointsXY_LOD[level].size();
+        
+        //features: polylines keep their end points, polygons keep at least a triangle
+        Featurepoints_xy_LOD[level].resize(Featurepoints_xy.size());
+        
+        for (unsigned featureId = 0; featureId < Featurepoints_xy.size(); featureId++){
+            if (FeatureAreaVector[featureId] == 0){
+                simplifyPolyline(Featurepoints_xy[featureId].data(), Featurepoints_xy[featureId].size(), 
+                        LODTolerances[level], Featurepoints_xy_LOD[level][featureId]);
+            }
+            else{
+                Featurepoints_xy_LOD[level][featureId] = simplifyPolygon(Featurepoints_xy[featureId], LODTolerances[level]);
+            }
+        }
+    }
+}
+
+/*
+ * Returns: coarsest level of detail whose simplification tolerance is less than half a pixel at the current zoom
+ * (metres per pixel found from the renderer, so it also holds for map tiles)
+ */
+int level_of_detail(ezgl::renderer *g){
+    
+    double screenWidth = g->get_visible_screen().width();
+    if (screenWidth <= 0)
+        return 0;
+    
+    double metresPerPixel = g->get_visible_world().width() / screenWidth;
+    
+    int level = 0;
+    while (level + 1 < NUM_LOD_LEVELS && LODTolerances[level + 1] <= 0.5 * metresPerPixel){
+        level++;
+    }
+    return level;
+}
+
+//Returns: the visible world widened by half the widest stroke (and a pixel for antialiasing) on every side, so
+//culling against it keeps every line that can reach into the visible world, also across map tile edges
+ezgl::rectangle visible_world_with_strokes(ezgl::renderer *g){
+    
+    ezgl::rectangle visible = g->get_visible_world();
+    double screenWidth = g->get_visible_screen().width();
+    if (screenWidth <= 0)
+        return visible;
+    
+    double margin = (MAX_LINE_WIDTH / 2 + 1) * visible.width() / screenWidth;
+    return ezgl::rectangle({visible.left() - margin, visible.bottom() - margin}, 
+                           {visible.right() + margin, visible.top() + margin});
 }
 
 //populates the FeatureCentroids unordered_map
@@ -1523,6 +1857,10 @@ void load_map_button(GtkWidget* /*unused*/, ezgl::application *application)
     }
     
     else{
+        //map tiles and routes read the map, so none may be drawn or searched while it changes
+        MapTiles.clear();
+        RouteWorker.clear();
+        
         //also empties all global variables from m1
         close_map();
         
@@ -1535,16 +1873,12 @@ void load_map_button(GtkWidget* /*unused*/, ezgl::application *application)
         else{
             Highlighted_intersections.clear();
             
-            //updates min_lon, min_lat, max_lon, max_lat Global Variables (needed to populate global variables)
-            //also populates intersections vector
-            find_map_bounds();
-            
             //re-populate all global variables
-            populateWaybyRoadType();
-            populateFeatureIds_byType();
-            populatePointsOfInterest();
-            populateFeaturepoints_xy();
-            populateFeatureCentroids();
+            populateDrawingData();
+            invalidate_map_tiles();
+            
+            //render statistics are kept per map
+            RenderStats.reset();
 
             ezgl::rectangle new_initial_world({min_lon, min_lat}, {max_lon, max_lat}); 
 
@@ -1658,8 +1992,8 @@ std::vector< std::vector<int> >  get_intersection_and_suggestions(std::vector<in
 
 //button returns to base mode, depending on which mode is active at the moment
 void done_button(GtkWidget* /*unused*/, ezgl::application *application){
-    walkingDirectionsText = "";
-    directionsText = ""; //reset text for directions to be empty
+    //a route still being computed is dropped (the directions globals belong to the route worker)
+    RouteWorker.cancel();
 
     if( (CurrentMode == directions) || (CurrentMode == directions_click_select_destination) || (CurrentMode == directions_click_select_start) || (CurrentMode == directions_uber)){        
         hide_direction_entries(application);
@@ -1706,9 +2040,6 @@ void done_button(GtkWidget* /*unused*/, ezgl::application *application){
     GtkTextView * textViewPtr = GTK_TEXT_VIEW(view);
     GtkTextBuffer* buffer = gtk_text_view_get_buffer(textViewPtr);
     gtk_text_buffer_set_text(buffer, "", -1);
-    
-    //clear the directions variable
-    directionsText.clear();
 
     GtkWidget* done_widgetPtr = (GtkWidget*)application->get_object("done");
     gtk_widget_hide(done_widgetPtr);
@@ -1823,17 +2154,9 @@ void go_button(GtkWidget* /*unused*/, ezgl::application *application){
         GtkEntry* text_entry = (GtkEntry *) application->get_object("directions_entry");
         intersectionIds.second = get_intersection_from_text(text_entry);
     }
-        
-    directionsText = ""; //reset text for directions to be empty
-    walkingDirectionsText = "";
 
     //reset segment highlights
-    while(!(segmentsHighlighted.empty())){
-        int segUnhighlightID = segmentsHighlighted.back();
-        segmentHighlight[segUnhighlightID].walking = false;
-        segmentHighlight[segUnhighlightID].driving = false;
-        segmentsHighlighted.pop_back();
-    }
+    clear_path_highlight();
 
     //sting which holds the primary intersection names
     std::string intersectionNames = "";
@@ -1856,10 +2179,8 @@ void go_button(GtkWidget* /*unused*/, ezgl::application *application){
         int startID = intersectionIds.first; 
         int destID = intersectionIds.second;
 
-        LatLon start = IntersectionCoordinates[startID];
-        LatLon dest = IntersectionCoordinates[destID];
-        std::pair <double, double> xyStart = latLonToCartesian(start);
-        std::pair <double, double> xyDest = latLonToCartesian(dest);
+        std::pair <double, double> xyStart = intersectionToCartesian(startID);
+        std::pair <double, double> xyDest = intersectionToCartesian(destID);
         double xDiff = abs(xyStart.first - xyDest.first);
         double yDiff = abs(xyStart.second - xyDest.second);
         double xAvg = (xyStart.first + xyDest.first)/2;
@@ -1876,12 +2197,14 @@ void go_button(GtkWidget* /*unused*/, ezgl::application *application){
 
         navigateScreen = true;
         
+        //the route is computed on the route worker, route_ready shows it
+        routeRequest request = {startID, destID, default_turn_penalty, false, 0, 0};
+        
         //check if directions are to be drive only OR (drive + walk)
         GtkSwitch* uberSwitch = (GtkSwitch*) application->get_object("uber");
         
         if(gtk_switch_get_active(uberSwitch) == false){ //if the uber switch is turned off => drive only
-            std::vector<StreetSegmentIndex> path = find_path_between_intersections(startID, destID, default_turn_penalty);
-            gtk_text_buffer_set_text(buffer, directionsText.c_str(), -1); 
+            RouteWorker.submit(request);
         }
         else{
                 CurrentMode = directions_uber;
@@ -1903,10 +2226,13 @@ void go_button(GtkWidget* /*unused*/, ezgl::application *application){
                 //convert string to int
                 Walking_speed = std::stoi(walking_speed_input);
                 Time_limit = std::stoi(time_limit_input);
-                std::pair<std::vector<StreetSegmentIndex>, std::vector<StreetSegmentIndex>> uber_path = find_path_with_walk_to_pick_up(startID, destID, default_turn_penalty, Walking_speed, Time_limit);
-                std::string fullText = walkingDirectionsText + "\n\n"+ directionsText;
-                gtk_text_buffer_set_text(buffer, fullText.c_str(), -1); 
+                request.walkToPickUp = true;
+                request.walkingSpeed = Walking_speed;
+                request.walkingTimeLimit = Time_limit;
+                RouteWorker.submit(request);
         }
+        
+        gtk_text_buffer_set_text(buffer, "Finding route...", -1); 
     }
 
     application->update_message (intersectionNames); 
@@ -2,6 +2,7 @@
 #define DRAWMAP_H
 
 #include "m1.h"
+#include "m1A.h"
 #include "globals.h"
 #include "StreetsDatabaseAPI.h"
 #include "OSMDatabaseAPI.h"
@@ -12,7 +13,19 @@
 #include "ezgl/point.hpp"
 #include "intersection_data.h"
 #include "poiStruct.h"
+#include "segmentGrid.h"
+#include "polylineSimplify.h"
+#include "tileCache.h"
+#include "labelPlacer.h"
+#include "renderStats.h"
+#include "viewLayer.h"
+#include "routeWorker.h"
+#include <chrono>
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <set>
 #include <unordered_set>
 #include <string>
@@ -26,10 +39,36 @@
 
 #define default_turn_penalty 0.25 // (15s converted to minutes)
 
+enum RoadType {
+    unclassified = 0,
+    motorway, 
+    trunk ,
+    primary,
+    secondary, 
+    tertiary, 
+    residential
+};
+
+#define NUM_ROAD_TYPES 7
+
+#define NUM_LOD_LEVELS 5 //levels of detail precomputed for streets and features
+
+#define MAX_LINE_WIDTH 3.5 //pixels, widest stroke of a street or feature (see set_street_style, drawFeature_byType)
+
+#define RENDER_STATS_FILE "render_stats.txt" //render statistics are appended to this file (F3)
+
 //--------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 /************  FUNCTION DECLARATIONS  ***********/
 void draw_map_blank_canvas ();
 void draw_main_canvas (ezgl::renderer *g);
+void draw_base_map(ezgl::renderer *g);
+bool draw_base_layer(ezgl::renderer *g);
+void draw_map_details(ezgl::renderer *g);
+void draw_map_labels(ezgl::renderer *g);
+int draw_path_overlay(ezgl::renderer *g);
+void invalidate_map_tiles();
+void path_highlight_changed();
+void set_tile_scale_factor(ezgl::renderer *g, double screenWidth);
 
 //  CONVERSIONS //
 double lon_from_x (double x);
@@ -37,6 +76,7 @@ double lat_from_y (double x);
 double y_from_lat (double lat);
 double x_from_lon (double lon);
 std::pair < double, double > latLonToCartesian (LatLon latLonPoint);
+std::pair < double, double > intersectionToCartesian (int intersectionID);
 double getRotationAngleForText(std::pair <double, double> xyFrom, std::pair <double, double> xyTo);
 double getRotationAngle(std::pair <double, double> xyFrom, std::pair <double, double> xyTo);
 
@@ -44,25 +84,41 @@ double getRotationAngle(std::pair <double, double> xyFrom, std::pair <double, do
 //  DRAWING //
 //also populates intersections vector
 void find_map_bounds();
-void drawFeature_byType(int feature_type, ezgl::renderer *g);
-void drawFeatures(ezgl::renderer *g);
-void draw_feature_names(ezgl::renderer *g);
-void draw_streets(ezgl::renderer *g);
-void draw_street_name(ezgl::renderer *g, std::pair<double, double> & xyFrom, std::pair<double, double> & xyTo, double& segmentLength, std::string& streetName, bool oneWay);
-void draw_intersections(ezgl::renderer *g);  
-void draw_points_of_interest(ezgl::renderer *g);
+int drawFeature_byType(int feature_type, ezgl::renderer *g);
+int drawFeatures(ezgl::renderer *g);
+void add_feature_name_labels(labelPlacer& labels);
+int draw_streets(ezgl::renderer *g);
+int draw_path_highlight(ezgl::renderer *g);
+void add_street_name_labels(ezgl::renderer *g, labelPlacer& labels);
+double street_label_priority(int segmentID, RoadType roadType);
+bool set_street_style(ezgl::renderer *g, RoadType roadType);
+std::vector<bool> visible_road_types(ezgl::renderer *g);
+void add_street_segment_label(labelPlacer& labels, int segmentID, RoadType roadType, double priority);
+int level_of_detail(ezgl::renderer *g);
+ezgl::rectangle visible_world_with_strokes(ezgl::renderer *g);
+void add_straight_street_labels(labelPlacer& labels, std::pair<double, double> & xyFrom, std::pair<double, double> & xyTo, double& segmentLength, std::string& streetName, bool oneWay, double priority);
+int draw_intersections(ezgl::renderer *g);  
+void add_poi_labels(labelPlacer& labels);
 void clearIntersection_highlights();
 
 //------------------------------------------------------------------------------
 // POPULATING GLOBAL VARIABLES //
+void populateDrawingData();
 void populatePointsOfInterest();
-void populateWaybyRoadType();
+void populateSegmentRoadType();
+void populateStreetSegmentGrid();
 void populateFeatureIds_byType();
 void populateFeaturepoints_xy();
+void populateLevelsOfDetail();
 void populateFeatureCentroids();
 
 //------------------------------------------------------------------------------
 // MISCELLANEOUS
+//FNV-1a hash of a string, usable at compile time (e.g. as a case label)
+constexpr unsigned tag_hash(const char* text, unsigned hash = 2166136261u){
+    return *text == '\0' ? hash : tag_hash(text + 1, (hash ^ (unsigned char) *text) * 16777619u);
+}
+RoadType road_type_from_highway_tag(const std::string& value);
 ezgl::point2d compute2DPolygonCentroid(int& featureId, std::vector<ezgl::point2d> &vertices, double& area);
 ezgl::point2d find_PolyLine_Middle(int featureId);
 std::string get_operationHours(const OSMNode* poi_OSMentity);
@@ -74,6 +130,7 @@ int get_intersection_from_text(GtkEntry* text_entry);
 //------------------------------------------------------------------------------
 // APPLICATION
 void act_on_mouse_click( ezgl:: application* app, GdkEventButton* /*unused*/, double x_click, double y_click);
+void act_on_key_press(ezgl::application* app, GdkEventKey* /*unused*/, char* key_name);
 void find_button(GtkWidget* /*unused*/, ezgl::application *application);
 void load_map_button(GtkWidget* /*unused*/, ezgl::application *application);
 void initial_setup(ezgl::application *application, bool /*new_window*/);
@@ -85,6 +142,12 @@ void on_dialog_response(GtkDialog *dialog, gint response_id, gpointer /*unused*/
 void hide_direction_entries(ezgl::application *application);
 void show_direction_entries(ezgl::application *application);
 void click_button(GtkWidget* /*unused*/, ezgl::application *application);
+void map_tile_ready();
+gboolean redraw_map_tiles(gpointer /*unused*/);
+void clear_path_highlight();
+void highlight_path(const std::vector<int>& path, bool walking);
+void route_computed(std::shared_ptr<const routeResult> result);
+gboolean route_ready(gpointer data);
 
 #endif /* DRAWMAP_H */
 
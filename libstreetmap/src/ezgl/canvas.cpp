@@ -176,6 +176,35 @@ bool canvas::print_png(const char *file_name, int output_width, int output_heigh
   return true;
 }
 
+surface *canvas::render_offscreen(rectangle world,
+    int width,
+    int height,
+    std::function<void(renderer *)> const &draw_callback)
+{
+  cairo_surface_t *image_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+
+  if(cairo_surface_status(image_surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(image_surface);
+    return nullptr; // failed to create due to errors such as out of memory
+  }
+  cairo_t *context = create_context(image_surface);
+
+  // the camera shows exactly the world rectangle on the whole surface
+  using namespace std::placeholders;
+  camera image_cam(world);
+  image_cam.update_widget(width, height);
+  {
+    renderer g(context, std::bind(&camera::world_to_screen, image_cam, _1), &image_cam, image_surface);
+    draw_callback(&g);
+  }
+
+  // free the context only, the surface is handed to the caller
+  cairo_destroy(context);
+  cairo_surface_flush(image_surface);
+
+  return image_surface;
+}
+
 gboolean canvas::configure_event(GtkWidget *widget, GdkEventConfigure *, gpointer data)
 {
   // User data should have been set during the signal connection.
@@ -29,6 +29,7 @@
 #include <cairo-svg.h>
 #include <gtk/gtk.h>
 
+#include <functional>
 #include <string>
 
 namespace ezgl {
@@ -115,6 +116,25 @@ public:
   bool print_pdf(const char *file_name, int width = 0, int height = 0);
   bool print_svg(const char *file_name, int width = 0, int height = 0);
   bool print_png(const char *file_name, int width = 0, int height = 0);
+
+  /**
+   * Draw into a new image surface, without a window or a canvas object.
+   *
+   * The world rectangle is mapped onto the whole surface, so it should have the same aspect ratio as the surface. Each
+   * call uses its own camera and renderer, so several threads may render at the same time as long as draw_callback
+   * only reads shared data.
+   *
+   * @param world           the part of the world to draw
+   * @param width           width of the surface in pixels
+   * @param height          height of the surface in pixels
+   * @param draw_callback   draws the content (as the draw callback of a canvas would)
+   * @return                an ARGB32 image surface, transparent wherever nothing was drawn, or nullptr if it could
+   *                        not be created. Should be freed using renderer::free_surface()
+   */
+  static surface *render_offscreen(rectangle world,
+      int width,
+      int height,
+      std::function<void(renderer *)> const &draw_callback);
   
   
 protected:
@@ -329,6 +329,49 @@ void renderer::draw_line(point2d start, point2d end)
   cairo_stroke(m_cairo);
 }
 
+void renderer::draw_polylines(std::vector<point2d> const &points, std::vector<std::pair<int, int>> const &ranges)
+{
+#ifdef EZGL_USE_X11
+  if(!transparency_flag && x11_display != nullptr) {
+    // one request for every piece of every polyline
+    std::vector<XSegment> x11_segments;
+    for(std::size_t i = 0; i < ranges.size(); ++i) {
+      for(int p = ranges[i].first; p + 1 < ranges[i].second; ++p) {
+        point2d start = points[p];
+        point2d end = points[p + 1];
+        if(current_coordinate_system == WORLD) {
+          start = m_transform(start);
+          end = m_transform(end);
+        }
+        x11_segments.push_back({static_cast<short>(start.x), static_cast<short>(start.y),
+            static_cast<short>(end.x), static_cast<short>(end.y)});
+      }
+    }
+    XDrawSegments(x11_display, x11_drawable, x11_context, x11_segments.data(), x11_segments.size());
+    return;
+  }
+#endif
+
+  for(std::size_t i = 0; i < ranges.size(); ++i) {
+    if(ranges[i].second - ranges[i].first < 2)
+      continue;
+
+    point2d next = points[ranges[i].first];
+    if(current_coordinate_system == WORLD)
+      next = m_transform(next);
+    cairo_move_to(m_cairo, next.x, next.y);
+
+    for(int p = ranges[i].first + 1; p < ranges[i].second; ++p) {
+      next = points[p];
+      if(current_coordinate_system == WORLD)
+        next = m_transform(next);
+      cairo_line_to(m_cairo, next.x, next.y);
+    }
+  }
+
+  cairo_stroke(m_cairo);
+}
+
 void renderer::draw_rectangle(point2d start, point2d end)
 {
   if(rectangle_off_screen({start, end}))
@@ -702,6 +745,14 @@ void renderer::draw_arc_path(point2d center,
     cairo_stroke(m_cairo);
 }
 
+point2d renderer::get_text_size(std::string const &text)
+{
+  cairo_text_extents_t text_extents{0,0,0,0,0,0};
+  cairo_text_extents(m_cairo, text.c_str(), &text_extents);
+
+  return {text_extents.width, text_extents.height};
+}
+
 void renderer::draw_surface(surface *p_surface, point2d top_left)
 {
   // Check if the surface is properly created
@@ -726,6 +777,49 @@ void renderer::draw_surface(surface *p_surface, point2d top_left)
   cairo_paint(m_cairo);
 }
 
+void renderer::draw_surface(surface *p_surface, rectangle bounds)
+{
+  // Check if the surface is properly created
+  if(cairo_surface_status(p_surface) != CAIRO_STATUS_SUCCESS)
+    return;
+
+  double s_width = (double)cairo_image_surface_get_width(p_surface);
+  double s_height = (double)cairo_image_surface_get_height(p_surface);
+
+  if(s_width <= 0 || s_height <= 0)
+    return;
+
+  // pre-clipping
+  if(rectangle_off_screen(bounds))
+    return;
+
+  // transform the corners of the given rectangle
+  point2d corner_a = bounds.bottom_left();
+  point2d corner_b = bounds.top_right();
+
+  if(current_coordinate_system == WORLD) {
+    corner_a = m_transform(corner_a);
+    corner_b = m_transform(corner_b);
+  }
+
+  double left = std::min(corner_a.x, corner_b.x);
+  double top = std::min(corner_a.y, corner_b.y);
+
+  cairo_save(m_cairo);
+  cairo_translate(m_cairo, left, top);
+  cairo_scale(m_cairo, std::fabs(corner_b.x - corner_a.x) / s_width, std::fabs(corner_b.y - corner_a.y) / s_height);
+
+  // Create a source for painting from the surface
+  // Edge pixels are repeated (rather than fading out) so surfaces drawn side by side leave no seams
+  cairo_set_source_surface(m_cairo, p_surface, 0, 0);
+  cairo_pattern_set_extend(cairo_get_source(m_cairo), CAIRO_EXTEND_PAD);
+
+  // Actual drawing
+  cairo_rectangle(m_cairo, 0, 0, s_width, s_height);
+  cairo_fill(m_cairo);
+  cairo_restore(m_cairo);
+}
+
 surface *renderer::load_png(const char *file_path)
 {
   // Create an image surface from a PNG image
@@ -38,6 +38,7 @@
 
 #include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 #include <cfloat>
 #include <cmath>
@@ -302,6 +303,17 @@ public:
    */
   void draw_line(point2d start, point2d end);
 
+  /**
+   * Draw several polylines as a single path, with one stroke for all of them.
+   *
+   * Much faster than a draw_line call per piece when many lines share the same colour and width. There is no
+   * pre-clipping, so the caller should pass only polylines that may be visible.
+   *
+   * @param points The points of every polyline.
+   * @param ranges Each polyline, as the range [first, second) of its points in points.
+   */
+  void draw_polylines(std::vector<point2d> const &points, std::vector<std::pair<int, int>> const &ranges);
+
   /**
    * Draw the outline a rectangle.
    *
@@ -421,6 +433,18 @@ public:
    */
   void draw_text(point2d point, std::string const &text, double bound_x, double bound_y);
 
+  /**
+   * Get the size of text in the current font, in pixels.
+   *
+   * Rotation is not taken into account. Measuring shapes the text, so callers measuring the same text often should
+   * cache the result.
+   *
+   * @param text The text to measure.
+   *
+   * @return The width (x) and height (y) of the text.
+   */
+  point2d get_text_size(std::string const &text);
+
   /**
    * Draw a surface
    *
@@ -429,6 +453,14 @@ public:
    */
   void draw_surface(surface *surface, point2d top_left);
 
+  /**
+   * Draw a surface stretched over a rectangle
+   *
+   * @param surface The surface to draw
+   * @param bounds The rectangle the whole surface is drawn into
+   */
+  void draw_surface(surface *surface, rectangle bounds);
+
   /**
    * load a png image
    *
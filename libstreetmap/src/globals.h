@@ -11,9 +11,16 @@
 #include <unordered_map> 
 #include "streetStruct.h"
 #include "poiStruct.h"
+#include "poiIndex.h"
+#include "distanceKernel.h"
+#include "ezgl/point.hpp"
 #include "wave.h"
 #include "Node.h"
 #include "segmentStruct.h"
+#include "routeCache.h"
+#include "customizableRouter.h"
+#include "blockedSegments.h"
+#include "speedProfiles.h"
 #include <bits/stdc++.h>
 #include <iostream>
 #include <vector>
@@ -68,6 +75,10 @@ extern std::vector<std::vector<int>> FeatureTypes;
 //Vector --> key: [feature ID] value: [Area]
 extern std::vector<double> FeatureAreaVector;
 
+//Hashtable --> key: [POI type] value: [poiIndex over POIs of that type]
+//key "" holds every POI
+extern std::unordered_map<std::string, poiIndex> POIIndexByType;
+
 
 //4. Segments & Intersections
 
@@ -77,18 +88,45 @@ extern std::vector<double> SegmentLengths;
 //Vector --> key: [segment ID] value: [travel_time]
 extern std::vector<double> SegmentTravelTime;
 
+//Vector --> key: [segment ID] value: [street ID]
+extern std::vector<int> SegmentStreetID;
+
+//time of day travel times of segments (see load_speed_profiles), empty unless loaded
+extern speedProfiles SegmentSpeedProfiles;
+
 //Vector --> key: [intersection ID] value: [LatLon Coordinates]
 extern std::vector<LatLon> IntersectionCoordinates;
 
-//Vector --> key: [segment ID] value: [segmentStruct]
-extern std::vector<segmentStruct> segmentHighlight;
+//Arrays --> key: [intersection ID] value: [lat, lon, cos & sin of half lat] (used by distance kernels)
+extern latLonArrays IntersectionLatLonArrays;
+
+//Arrays --> key: [point index] value: [lat, lon, cos & sin of half lat]
+//Every segment's points (from, curve points, to) stored back to back
+extern latLonArrays SegmentPoints;
+
+//Vector --> key: [segment ID] value: [index of segment's first point in SegmentPoints]
+//size is number of segments + 1, so points of segment s are [SegmentPointOffsets[s], SegmentPointOffsets[s+1])
+extern std::vector<int> SegmentPointOffsets;
 
-//Vector --> key: [arbitrary] value: [intersectionID and string pair]
-extern std::vector<std::pair<int, std::string>> intersectionsReached;
+//Vector --> key: [point index] value: [distance from this point to the next point in SegmentPoints]
+extern std::vector<double> SegmentPieceLengths;
 
-//5. Directions & M3-related
-extern std::string directionsText; //for driving only
-extern std::string walkingDirectionsText; //for walking
+//Vector --> key: [segment ID] value: [position of longest straight piece (0 = from -> 1st curve point)]
+extern std::vector<int> SegmentLongestPiece;
+
+//Average latitude of map's intersections (radians) and its cosine, used in (lon,lat) -> (x,y) conversion
+extern float MapLatAvg;
+extern double MapCosLatAvg;
+
+//Vector --> key: [intersection ID] value: [(x,y) position, metres]
+extern std::vector<ezgl::point2d> IntersectionXY;
+
+//Vector --> key: [point index] value: [(x,y) position, metres]
+//same indexing as SegmentPoints (points of segment s are [SegmentPointOffsets[s], SegmentPointOffsets[s+1]))
+extern std::vector<ezgl::point2d> SegmentPointsXY;
+
+//Vector --> key: [segment ID] value: [segmentStruct]
+extern std::vector<segmentStruct> segmentHighlight;
 
 extern std::list<int> segmentsHighlighted; //for keeping track of which segment
 
@@ -96,15 +134,14 @@ extern float MaxSpeedLimit;
 
 extern int Clicked_int_id;
 
-//Vector --> key: [nodeId] value: [Node]
-extern std::vector<Node> NodeVector;
-
+//driving paths already found (see find_path_between_intersections), must be cleared whenever the map changes
+extern routeCache RouteCache;
 
+//segments closed to every path search (see blockedSegments.h), must be cleared whenever the map changes
+extern segmentClosures SegmentClosures;
 
-//**********  M4 *************
-//bool which returns true if path found
-//corner case: if path found, and source == dest node then path will be empty, but find_path_djikstra_bool will be true
-extern bool find_path_djikstra_bool;
+//driving paths on live traffic travel times (see customizableRouter.h), must be cleared whenever the map changes
+extern customizableRouter TrafficRouter;
 
 #endif /* GLOBALS_H */
 
@@ -0,0 +1,163 @@
+/*
+ * File:   labelPlacer.cpp
+ * Author: georg157
+ *
+ * Label placement: candidate labels are collected for a frame, then placed greedily by priority
+ */
+
+#include "labelPlacer.h"
+#include <algorithm>
+#include <cmath>
+
+labelPlacer::labelPlacer() : visibleWorld({0, 0}, {0, 0}) {
+    g = nullptr;
+    currentFont = NUM_LABEL_FONTS;
+    screenWidth = 0;
+    screenHeight = 0;
+    worldPerPixel = 1;
+    numCols = 0;
+    numRows = 0;
+}
+
+labelPlacer::~labelPlacer() {
+}
+
+void labelPlacer::begin(ezgl::renderer* renderer){
+    g = renderer;
+    currentFont = NUM_LABEL_FONTS;
+    candidates.clear();
+    placed.clear();
+
+    visibleWorld = g->get_visible_world();
+    ezgl::rectangle screen = g->get_visible_screen();
+    screenWidth = std::max(screen.width(), 1.0);
+    screenHeight = std::max(screen.height(), 1.0);
+    worldPerPixel = visibleWorld.width() / screenWidth;
+
+    numCols = (int) std::ceil(screenWidth / LABEL_GRID_CELL);
+    numRows = (int) std::ceil(screenHeight / LABEL_GRID_CELL);
+    cells.resize(numCols * numRows);
+    for (unsigned i = 0; i < cells.size(); i++){
+        cells[i].clear();
+    }
+}
+
+void labelPlacer::add(ezgl::point2d position, const std::string& text, double rotation, double priority,
+                      ezgl::color colour, labelFont font, double maxSize){
+    //labels whose anchor is off screen are not considered at all
+    if (position.x < visibleWorld.left() || position.x > visibleWorld.right() ||
+        position.y < visibleWorld.bottom() || position.y > visibleWorld.top() || text.empty())
+        return;
+
+    candidates.push_back({position, text, rotation, priority, colour, font, maxSize});
+}
+
+int labelPlacer::numCandidates() const{
+    return candidates.size();
+}
+
+void labelPlacer::setFont(labelFont font){
+    if (font == currentFont)
+        return;
+
+    ezgl::font_weight weight = (font == boldFont) ? ezgl::font_weight::bold : ezgl::font_weight::normal;
+    g->format_font("cairo", ezgl::font_slant::normal, weight, LABEL_FONT_SIZE);
+    currentFont = font;
+}
+
+ezgl::point2d labelPlacer::textSize(const std::string& text, labelFont font){
+    std::string key = (char) ('0' + font) + text;
+
+    auto it = textSizes.find(key);
+    if (it != textSizes.end())
+        return it->second;
+
+    if (textSizes.size() >= MAX_CACHED_TEXT_SIZES)
+        textSizes.clear();
+
+    setFont(font);
+    ezgl::point2d size = g->get_text_size(text);
+    textSizes.insert(std::make_pair(key, size));
+    return size;
+}
+
+bool labelPlacer::occupied(const screenBox& box) const{
+    int colLow = std::max(0, (int) (box.left / LABEL_GRID_CELL));
+    int colHigh = std::min(numCols - 1, (int) (box.right / LABEL_GRID_CELL));
+    int rowLow = std::max(0, (int) (box.top / LABEL_GRID_CELL));
+    int rowHigh = std::min(numRows - 1, (int) (box.bottom / LABEL_GRID_CELL));
+
+    for (int row = rowLow; row <= rowHigh; row++){
+        for (int col = colLow; col <= colHigh; col++){
+            const std::vector<int>& cell = cells[row * numCols + col];
+            for (unsigned i = 0; i < cell.size(); i++){
+                const screenBox& other = placed[cell[i]];
+                if (box.left < other.right && other.left < box.right &&
+                    box.top < other.bottom && other.top < box.bottom)
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+void labelPlacer::occupy(const screenBox& box){
+    int index = placed.size();
+    placed.push_back(box);
+
+    int colLow = std::max(0, (int) (box.left / LABEL_GRID_CELL));
+    int colHigh = std::min(numCols - 1, (int) (box.right / LABEL_GRID_CELL));
+    int rowLow = std::max(0, (int) (box.top / LABEL_GRID_CELL));
+    int rowHigh = std::min(numRows - 1, (int) (box.bottom / LABEL_GRID_CELL));
+
+    for (int row = rowLow; row <= rowHigh; row++){
+        for (int col = colLow; col <= colHigh; col++){
+            cells[row * numCols + col].push_back(index);
+        }
+    }
+}
+
+int labelPlacer::place(){
+    if (g == nullptr)
+        return 0;
+
+    //highest priority first, ties keep the order they were added in
+    std::stable_sort(candidates.begin(), candidates.end(), [](const labelCandidate& a, const labelCandidate& b){
+        return a.priority > b.priority;
+    });
+
+    int numDrawn = 0;
+
+    for (unsigned i = 0; i < candidates.size(); i++){
+        const labelCandidate& label = candidates[i];
+        ezgl::point2d size = textSize(label.text, label.font);
+
+        //same rule as ezgl's bounded draw_text: the text must fit in maxSize both ways (rotation ignored)
+        if (label.maxSize > 0 && (size.x * worldPerPixel > label.maxSize || size.y * worldPerPixel > label.maxSize))
+            continue;
+
+        //axis-aligned box around the rotated text, in pixels (y down)
+        double angle = label.rotation * M_PI / 180;
+        double halfWidth = 0.5 * (std::fabs(size.x * cos(angle)) + std::fabs(size.y * sin(angle))) + LABEL_PADDING;
+        double halfHeight = 0.5 * (std::fabs(size.x * sin(angle)) + std::fabs(size.y * cos(angle))) + LABEL_PADDING;
+        double x = (label.position.x - visibleWorld.left()) / worldPerPixel;
+        double y = (visibleWorld.top() - label.position.y) / worldPerPixel;
+        screenBox box = {x - halfWidth, y - halfHeight, x + halfWidth, y + halfHeight};
+
+        if (occupied(box))
+            continue;
+        occupy(box);
+
+        setFont(label.font);
+        g->set_color(label.colour);
+        g->set_text_rotation(label.rotation);
+        g->draw_text(label.position, label.text);
+        numDrawn++;
+    }
+
+    g->set_text_rotation(0);
+    setFont(normalFont);
+    candidates.clear();
+
+    return numDrawn;
+}
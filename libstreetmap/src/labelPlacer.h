@@ -0,0 +1,105 @@
+/*
+ * File:   labelPlacer.h
+ * Author: georg157
+ *
+ * Label placement: candidate labels are collected for a frame, then placed greedily by priority
+ * Labels overlapping an already placed label (screen-space occupancy grid) are dropped
+ */
+
+#ifndef LABELPLACER_H
+#define LABELPLACER_H
+
+#include "ezgl/graphics.hpp"
+#include "ezgl/color.hpp"
+#include "ezgl/point.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define LABEL_FONT_SIZE 10 //size of every label (cairo's default)
+#define LABEL_GRID_CELL 32 //side of an occupancy grid cell, pixels
+#define LABEL_PADDING 2 //gap kept between labels, pixels
+#define MAX_CACHED_TEXT_SIZES 100000 //text size cache is emptied past this
+
+enum labelFont {
+    normalFont = 0,
+    boldFont,
+    NUM_LABEL_FONTS
+};
+
+class labelPlacer{
+    public:
+        labelPlacer();
+
+        ~labelPlacer();
+
+        //Starts a frame drawn by g: drops the candidates and placed labels of the previous frame
+        void begin(ezgl::renderer* g);
+
+        //Adds a candidate label, text centred on position (world) and rotated (degrees)
+        //Higher priority labels are placed first
+        //maxSize: the label is dropped if its width or height (world units) is larger (0 or less: no limit)
+        void add(ezgl::point2d position, const std::string& text, double rotation, double priority,
+                 ezgl::color colour, labelFont font = normalFont, double maxSize = 0);
+
+        //Returns: number of candidates added since begin
+        int numCandidates() const;
+
+        //Places and draws the candidates (highest priority first), skipping any that overlap a placed label
+        //Returns: number of labels drawn
+        int place();
+
+    private:
+        struct labelCandidate{
+            ezgl::point2d position;
+            std::string text;
+            double rotation;
+            double priority;
+            ezgl::color colour;
+            labelFont font;
+            double maxSize;
+        };
+
+        struct screenBox{
+            double left;
+            double top;
+            double right;
+            double bottom;
+        };
+
+        //Return: size (pixels) of text in font, measured once and then cached
+        ezgl::point2d textSize(const std::string& text, labelFont font);
+
+        void setFont(labelFont font);
+
+        //Return: true if box overlaps a placed label
+        bool occupied(const screenBox& box) const;
+
+        void occupy(const screenBox& box);
+
+        ezgl::renderer* g;
+
+        std::vector<labelCandidate> candidates;
+
+        //font currently set on g (NUM_LABEL_FONTS if unknown)
+        labelFont currentFont;
+
+        //Hashtable --> key: [font, then text] value: [size in pixels]
+        std::unordered_map<std::string, ezgl::point2d> textSizes;
+
+        //screen covered by the grid and world units per pixel of this frame
+        ezgl::rectangle visibleWorld;
+        double screenWidth;
+        double screenHeight;
+        double worldPerPixel;
+
+        //Vector --> key: [cell (row * numCols + col)] value: [indices of placed boxes overlapping the cell]
+        std::vector<std::vector<int>> cells;
+        int numCols;
+        int numRows;
+
+        std::vector<screenBox> placed;
+};
+
+#endif /* LABELPLACER_H */
+
@@ -19,6 +19,7 @@
  * SOFTWARE.
  */
 #include "m1.h"
+#include "m1A.h"
 #include "globals.h"
 #include "StreetsDatabaseAPI.h"
 #include "OSMDatabaseAPI.h"
@@ -51,15 +52,49 @@ std::unordered_map<OSMID, double> OSMWay_lengths;
 //Vector --> key: [feature ID] value: [Area]
 std::vector<double> FeatureAreaVector;
 
+//Hashtable --> key: [POI type] value: [poiIndex over POIs of that type]
+std::unordered_map<std::string, poiIndex> POIIndexByType;
+
 //Vector --> key: [segment ID] value: [length]
 std::vector<double> SegmentLengths;
 
 //Vector --> key: [segment ID] value: [travel_time]
 std::vector<double> SegmentTravelTime;
 
+//Vector --> key: [segment ID] value: [street ID]
+std::vector<int> SegmentStreetID;
+
+//time of day travel times of segments, loaded on request (load_speed_profiles)
+speedProfiles SegmentSpeedProfiles;
+
 //Vector --> key: [intersection ID] value: [LatLon Coordinates]
 std::vector<LatLon> IntersectionCoordinates;
 
+//Arrays --> key: [intersection ID] value: [lat, lon, cos & sin of half lat]
+latLonArrays IntersectionLatLonArrays;
+
+//Arrays --> key: [point index] value: [lat, lon, cos & sin of half lat]
+latLonArrays SegmentPoints;
+
+//Vector --> key: [segment ID] value: [index of segment's first point in SegmentPoints]
+std::vector<int> SegmentPointOffsets;
+
+//Vector --> key: [point index] value: [distance from this point to the next point in SegmentPoints]
+std::vector<double> SegmentPieceLengths;
+
+//Vector --> key: [segment ID] value: [position of longest straight piece]
+std::vector<int> SegmentLongestPiece;
+
+//Average latitude of map (radians) and its cosine
+float MapLatAvg;
+double MapCosLatAvg;
+
+//Vector --> key: [intersection ID] value: [(x,y) position]
+std::vector<ezgl::point2d> IntersectionXY;
+
+//Vector --> key: [point index] value: [(x,y) position]
+std::vector<ezgl::point2d> SegmentPointsXY;
+
 //Multimap --> key: [Street Name] value: [Street Index]
 std::multimap<std::string, int> StreetNames;
 
@@ -72,8 +107,6 @@ std::string MapName;
 
 float MaxSpeedLimit;
 
-//Vector --> key: [nodeId] value: [Node]
-std::vector<Node> NodeVector;
 //----------------------------------------------------------------
 
 //---Function Declarations----------------------------------------
@@ -89,6 +122,8 @@ void populateOSMWay_lengths();
 void populateIntersectionStreetSegments();
 //Populating SegmentLengths
 void populateSegmentLengths();
+//Populating MapLatAvg, IntersectionXY and SegmentPointsXY
+void populateProjectedCoordinates();
 //Populating segment_travel_time
 void populateSegmentTravelTime();
 //Populating intersection Coordinates vector
@@ -101,8 +136,8 @@ void populateSegmentHighlight();
 bool isStreetName(std::string streetName, std::string prefix, int prefixLength);
 //Used to extract map name as City Country, used in graphics (M3)
 std::string getMapName(std::string fullpath);
-//used in path-finding fxns
-void populateNodeVector();
+//projects LatLon into (x,y) used by POIIndexByType
+std::pair<double, double> poiIndexXY(LatLon position);
 //------------------------------------------------------------------
 
 // load_map will be called with the name of the file that stores the "layer-2"
@@ -121,6 +156,11 @@ void populateNodeVector();
 bool load_map(std::string map_streets_database_filename) {
     
     bool load_successful;
+    
+    //cached paths and traffic cells belong to the previous map
+    RouteCache.clear();
+    TrafficRouter.clear();
+    SegmentClosures.clear();
 
     //Check if streets database bin file loads successfully
     load_successful = loadStreetsDatabaseBIN(map_streets_database_filename);
@@ -171,15 +211,18 @@ bool load_map(std::string map_streets_database_filename) {
         //Populate segment lengths
         populateSegmentLengths();
     
+        //Project intersections and segment points into (x,y)
+        populateProjectedCoordinates();
+    
         //Populate segment travel times;
         populateSegmentTravelTime();
         
         //Populate segment highlights
         populateSegmentHighlight();
         
-        //Populate NodeVector used in path-finding
-        NodeVector.resize(getNumIntersections());
-        populateNodeVector();
+        //Populate spatial index of points of interest
+        populatePOIIndex();
+
          
     }
     return load_successful;
@@ -205,9 +248,32 @@ void close_map() {
     
     SegmentTravelTime.clear();
     
+    SegmentStreetID.clear();
+    SegmentSpeedProfiles.clear();
+    
     IntersectionCoordinates.clear();
     
-    NodeVector.clear();
+    IntersectionLatLonArrays.clear();
+    
+    SegmentPoints.clear();
+    
+    SegmentPointOffsets.clear();
+    
+    SegmentPieceLengths.clear();
+    
+    SegmentLongestPiece.clear();
+    
+    IntersectionXY.clear();
+    
+    SegmentPointsXY.clear();
+    
+    POIIndexByType.clear();
+    
+    RouteCache.clear();
+    
+    TrafficRouter.clear();
+    
+    SegmentClosures.clear();
     
     //Call close functions from StreetsDatabase API
     closeStreetDatabase(); 
@@ -232,7 +298,7 @@ double find_distance_between_two_points(std::pair<LatLon, LatLon> points){
     
     
     //Use distance formula to find distance and then scale to size of Earth
-    distanceBetweenTwoPoints = EARTH_RADIUS_METERS * sqrt(pow(p2_y - p1_y , 2)+ pow(p2_x - p1_x , 2));
+    distanceBetweenTwoPoints = EARTH_RADIUS_METERS * sqrt((p2_y - p1_y)*(p2_y - p1_y) + (p2_x - p1_x)*(p2_x - p1_x));
   
     return distanceBetweenTwoPoints;
 }
@@ -263,35 +329,94 @@ double find_street_segment_travel_time(int street_segment_id){
     }
 }
 
+//Return: false if the file can't be read
+//Profiles change driving times at some times of day only, so cached (speed limit) routes stay valid
+bool load_speed_profiles(std::string csv_filename){
+    
+    if (!SegmentSpeedProfiles.load(csv_filename)){
+        std::cerr << "Failed to read speed profiles '" << csv_filename << "'\n";
+        return false;
+    }
+    if (SegmentSpeedProfiles.numSkippedLines() > 0)
+        std::cerr << "Skipped " << SegmentSpeedProfiles.numSkippedLines() << " unreadable lines of '" << csv_filename << "'\n";
+    return true;
+}
+
 int find_closest_intersection(LatLon my_position){
-//Function iterates through each intersection and compares its distance to my_position
+//Function computes the distance from my_position to every intersection, a block at a time, using the batch distance kernel
 //The closest ID is returned as closestIntersection 
-//Ids are accessed from the IntersectionCoordinates structure
+//Positions are read from the IntersectionLatLonArrays structure
 
-    //calculates distance to intersection 0, to begin comparison
-    std::pair<LatLon, LatLon> path(my_position, IntersectionCoordinates[0]);     
-    int shortestDistance = find_distance_between_two_points(path);
+    //number of distances computed per kernel call
+    const unsigned blockSize = 1024;
+    double distances[blockSize];
     
-    int distance;
+    double shortestDistance = std::numeric_limits<double>::max();
     int closestIntersection = 0;
     
-    //start iterating distance to intersection 1, since we start with distance to intersection 0
-    for (unsigned i = 1; i < getNumIntersections(); i++){
-        //store next intersection into the path pair
-        path.second = IntersectionCoordinates[i];     
+    unsigned numIntersections = IntersectionLatLonArrays.size();
+    
+    for (unsigned blockStart = 0; blockStart < numIntersections; blockStart += blockSize){
         
-        distance = find_distance_between_two_points(path);
+        unsigned blockEnd = std::min(blockStart + blockSize, numIntersections);
         
-        if (distance < shortestDistance){
-            
-            shortestDistance = distance;
-            closestIntersection = i;
+        distancesToPoint(IntersectionLatLonArrays, blockStart, blockEnd, my_position, distances);
+        
+        for (unsigned i = blockStart; i < blockEnd; i++){
+            if (distances[i - blockStart] < shortestDistance){
+                shortestDistance = distances[i - blockStart];
+                closestIntersection = i;
+            }
         }
     }
     
     return closestIntersection;
 }
 
+//projects a LatLon into the (x,y) metres used by POIIndexByType
+std::pair<double, double> poiIndexXY(LatLon position){
+    double x = position.lon() * DEGREE_TO_RADIAN * EARTH_RADIUS_METERS * MapCosLatAvg;
+    double y = position.lat() * DEGREE_TO_RADIAN * EARTH_RADIUS_METERS;
+    return std::make_pair(x, y);
+}
+
+//Return: index of closest point of interest of type poi_type, -1 if the map has none of that type
+int find_closest_point_of_interest(LatLon my_position, std::string poi_type){
+    
+    std::unordered_map<std::string, poiIndex>::const_iterator it = POIIndexByType.find(poi_type);
+    
+    if (it == POIIndexByType.end())
+        return -1;
+    
+    return it->second.nearest(poiIndexXY(my_position));
+}
+
+//Return: vector of (up to) k closest points of interest of type poi_type, closest first
+std::vector<int> find_closest_points_of_interest(LatLon my_position, std::string poi_type, unsigned k){
+    
+    std::unordered_map<std::string, poiIndex>::const_iterator it = POIIndexByType.find(poi_type);
+    
+    if (it == POIIndexByType.end()){
+        std::vector<int> emptyVector;
+        return emptyVector;
+    }
+    
+    return it->second.kNearest(poiIndexXY(my_position), k);
+}
+
+//Return: vector of points of interest of type poi_type within radius (metres), closest first
+std::vector<int> find_points_of_interest_within_radius(LatLon my_position, std::string poi_type, double radius){
+    
+    std::unordered_map<std::string, poiIndex>::const_iterator it = POIIndexByType.find(poi_type);
+    
+    if (it == POIIndexByType.end()){
+        std::vector<int> emptyVector;
+        return emptyVector;
+    }
+    
+    return it->second.withinRadius(poiIndexXY(my_position), radius);
+}
+
 //Returns: vector of street segments of an intersection
 //Uses intersectionStreetSegments vector with intersection id argument (if it exists)
 std::vector<int> find_street_segments_of_intersection(int intersection_id){
@@ -703,6 +828,10 @@ void populateOSMWay_lengths(){
     
     std::vector<OSMID> nodesInWay;
     
+    //positions of the current way's nodes, and the distances between them (reused for every way)
+    latLonArrays wayPoints;
+    std::vector<double> wayPieceLengths;
+    
     //Retrieves OSMNodes and calculate total distance, for each way
     for (unsigned i = 0; i < getNumberOfWays(); i++){
         //initialize length of way to 0 
@@ -721,18 +850,15 @@ void populateOSMWay_lengths(){
         //otherwise, calculates length of the Way       
         //retrieves coordinates of Way nodes:
         //OSMID -> OSM Node index -> Node pointer -> Lat Lon Coordinates
+        wayPoints.clear();
+        for (unsigned j = 0; j < nodesInWay.size(); j++){
+            wayPoints.push_back(getNodeCoords(getNodeByIndex(OSMID_to_node.at(nodesInWay[j]))));
+        }
         
-        //extracts first Node and retrieves corresponding LatLon (this is the "left-edge" of the way segment) 
-        LatLon LatLon_left = getNodeCoords(getNodeByIndex(OSMID_to_node.at(nodesInWay[0]))); 
-        
-        for (unsigned j = 1; j < nodesInWay.size(); j++){
-             //calculate LatLon for right-edge of way segment
-             //retrieves the next OSMID -> OSM Node index -> Node pointer -> Lat Lon Coordinates
-            LatLon LatLon_right = getNodeCoords(getNodeByIndex(OSMID_to_node.at(nodesInWay[j])));
-            
-            std::pair<LatLon, LatLon> waySegment(LatLon_left, LatLon_right); //pair left-edge LatLon and right-edge LatLon
-            wayLength += find_distance_between_two_points(waySegment); //calculate distance and add it to the total length (wayLength)
-            LatLon_left = LatLon_right; //shift right-edge of current way segment to become the left-edge of the next way segment
+        //distance between each pair of adjacent nodes, then add them to the total length (wayLength)
+        distancesBetweenConsecutivePoints(wayPoints, wayPieceLengths);
+        for (unsigned j = 0; j < wayPieceLengths.size(); j++){
+            wayLength += wayPieceLengths[j];
         }
         
         OSMWay_lengths.insert({wayPtr->id(),wayLength});
@@ -760,60 +886,94 @@ void populateIntersectionStreetSegments(){
     
 }
 //Populating SegmentLengths vector
+//Also populates SegmentPoints, SegmentPointOffsets, SegmentPieceLengths and SegmentLongestPiece
 void populateSegmentLengths(){
     
-    SegmentLengths.resize(getNumStreetSegments());
+    int numSegments = getNumStreetSegments();
+    
+    SegmentLengths.resize(numSegments);
+    SegmentPointOffsets.resize(numSegments + 1);
+    SegmentLongestPiece.resize(numSegments);
+    SegmentPoints.clear();
     
-    double streetSegmentLength;
     //general segment info struct
     InfoStreetSegment segmentInfo;
     
-    for(unsigned id = 0; id < getNumStreetSegments(); id++){
-    
-        streetSegmentLength = 0;
+    //store every segment's points back to back: from, curve points, to
+    for(int id = 0; id < numSegments; id++){
         
         segmentInfo = getInfoStreetSegment(id);
-
-        //get number of curve points in street segment
-        int numCurvePoints = segmentInfo.curvePointCount;
-        //get starting point coordinates
-        LatLon from = getIntersectionPosition(segmentInfo.from);
-
-        //if there are zero curve points then "to" will be set to the end of the street segment
-        if(numCurvePoints > 0){
-
-            //need variable that holds "to" positions
-            LatLon to;
-
-            for(int i = 0; i < numCurvePoints; i++){
-                //get the curvePoint Position (latlon)
-                to = getStreetSegmentCurvePoint(i, id);
-
-                //make a points pair to send to the find_distance_between_two_points function
-                std::pair<LatLon, LatLon> length(from, to);
-
-                //calculate distance
-                streetSegmentLength += find_distance_between_two_points(length);
-
-                //update "from" point
-                from = to;
+        
+        SegmentPointOffsets[id] = SegmentPoints.size();
+        
+        SegmentPoints.push_back(IntersectionCoordinates[segmentInfo.from]);
+        for(int i = 0; i < segmentInfo.curvePointCount; i++){
+            SegmentPoints.push_back(getStreetSegmentCurvePoint(i, id));
+        }
+        SegmentPoints.push_back(IntersectionCoordinates[segmentInfo.to]);
+    }
+    SegmentPointOffsets[numSegments] = SegmentPoints.size();
+    
+    //one kernel call over all points (pieces that join the last point of a segment to the next segment are never read)
+    distancesBetweenConsecutivePoints(SegmentPoints, SegmentPieceLengths);
+    
+    for(int id = 0; id < numSegments; id++){
+        
+        double streetSegmentLength = 0;
+        double longestPieceLength = -1;
+        
+        //a segment with n points has n-1 pieces
+        int firstPoint = SegmentPointOffsets[id];
+        int lastPoint = SegmentPointOffsets[id + 1] - 1;
+        
+        for(int point = firstPoint; point < lastPoint; point++){
+            streetSegmentLength += SegmentPieceLengths[point];
+            
+            //track the piece that is the longest (used to place street names)
+            if(SegmentPieceLengths[point] > longestPieceLength){
+                longestPieceLength = SegmentPieceLengths[point];
+                SegmentLongestPiece[id] = point - firstPoint;
             }
         }
-
-        //for the last "from-to" distance
-        LatLon finalTo = getIntersectionPosition(segmentInfo.to);   
-
-        std::pair<LatLon, LatLon> length(from, finalTo);
-
-        streetSegmentLength += find_distance_between_two_points (length);
         
         SegmentLengths[id] =  streetSegmentLength;
     }   
 }
 
+//Populating MapLatAvg, MapCosLatAvg, IntersectionXY and SegmentPointsXY
+//(x,y) positions are computed once here so drawing and direction math never convert LatLon again
+void populateProjectedCoordinates(){
+    
+    //average latitude of all intersections (0 if the map has none)
+    double sumLat = 0;
+    for(unsigned i = 0; i < IntersectionCoordinates.size(); i++){
+        sumLat = sumLat + IntersectionCoordinates[i].lat();
+    }
+    MapLatAvg = 0;
+    if(!IntersectionCoordinates.empty())
+        MapLatAvg = sumLat * DEGREE_TO_RADIAN / IntersectionCoordinates.size();
+    MapCosLatAvg = cos(MapLatAvg);
+    
+    //lat/lon arrays are already in radians
+    IntersectionXY.clear();
+    IntersectionXY.reserve(IntersectionLatLonArrays.size());
+    for(unsigned i = 0; i < IntersectionLatLonArrays.size(); i++){
+        IntersectionXY.push_back(ezgl::point2d(IntersectionLatLonArrays.lon[i] * EARTH_RADIUS_METERS * MapCosLatAvg,
+                                               IntersectionLatLonArrays.lat[i] * EARTH_RADIUS_METERS));
+    }
+    
+    SegmentPointsXY.clear();
+    SegmentPointsXY.reserve(SegmentPoints.size());
+    for(unsigned i = 0; i < SegmentPoints.size(); i++){
+        SegmentPointsXY.push_back(ezgl::point2d(SegmentPoints.lon[i] * EARTH_RADIUS_METERS * MapCosLatAvg,
+                                                SegmentPoints.lat[i] * EARTH_RADIUS_METERS));
+    }
+}
+
 void populateSegmentTravelTime(){
     
     SegmentTravelTime.resize(getNumStreetSegments());
+    SegmentStreetID.resize(getNumStreetSegments());
     
     double streetSegmentTravelTime, speedLimit_metersPerSec;
     //general segment info struct
@@ -836,6 +996,9 @@ void populateSegmentTravelTime(){
         
         //put travel time into SegmentTravelTime vector
         SegmentTravelTime[street_segment_id] =  streetSegmentTravelTime;
+        
+        //street of each segment, read by the path time functions (m3) without getInfoStreetSegment
+        SegmentStreetID[street_segment_id] = segmentInfo.streetID;
     }   
 }
 
@@ -844,10 +1007,12 @@ void populateSegmentTravelTime(){
 //key: intersectionId value: LatLon coordinates
 void populateIntersectionCoordinates() {
     
+   IntersectionLatLonArrays.reserve(getNumIntersections());
+   
    for(unsigned i = 0; i < getNumIntersections(); i++){
        LatLon intersectionLatLon = getIntersectionPosition(i);
        IntersectionCoordinates.push_back(intersectionLatLon);  
-       
+       IntersectionLatLonArrays.push_back(intersectionLatLon);
    }
 }
 //Populates StreetNames multi-map
@@ -933,10 +1098,22 @@ std::string getMapName(std::string fullpath){
     return fullpath;
 }
 
-//vector used in m4 functions
-void populateNodeVector(){
-
-    for(unsigned i = 0; i < getNumIntersections(); i++){
-        NodeVector[i] = Node(i, NO_EDGE, std::numeric_limits<unsigned int>::max());
+//Populates POIIndexByType
+//Each POI is inserted into the index of its type and into the "" index (all POIs)
+void populatePOIIndex(){
+    
+    POIIndexByType.clear();
+    
+    poiIndex& allPOIs = POIIndexByType[""];
+    
+    for(unsigned poiIdx = 0; poiIdx < getNumPointsOfInterest(); poiIdx++){
+        std::pair<double, double> xy = poiIndexXY(getPointOfInterestPosition(poiIdx));
+        
+        POIIndexByType[getPointOfInterestType(poiIdx)].insert(poiIdx, xy);
+        allPOIs.insert(poiIdx, xy);
     }
-}
\ No newline at end of file
+    
+    for(std::unordered_map<std::string, poiIndex>::iterator it = POIIndexByType.begin(); it != POIIndexByType.end(); ++it){
+        it->second.build();
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef M1A_H
+#define M1A_H
+
+#include "m1.h"
+#include "LatLon.h"
+#include <string>
+#include <vector>
+
+//Points of interest queries (backed by POIIndexByType)
+//poi_type matches getPointOfInterestType() (e.g. "cafe"), an empty poi_type searches all types
+//Distances are in metres
+
+//Returns: index of the closest point of interest of the given type (-1 if there is none)
+int find_closest_point_of_interest(LatLon my_position, std::string poi_type);
+
+//Returns: indices of (up to) the k closest points of interest of the given type, closest first
+std::vector<int> find_closest_points_of_interest(LatLon my_position, std::string poi_type, unsigned k);
+
+//Returns: indices of all points of interest of the given type within radius metres, closest first
+std::vector<int> find_points_of_interest_within_radius(LatLon my_position, std::string poi_type, double radius);
+
+//Reads time of day speed profiles of segments (see speedProfiles.h), the map must be loaded
+//Replaces any profiles loaded before, close_map drops them
+//Returns: false if the file can't be read
+bool load_speed_profiles(std::string csv_filename);
+
+//Populating POIIndexByType
+void populatePOIIndex();
+
+#endif /* M1A_H */
+
@@ -5,22 +5,74 @@
 #define ANGLE_Threshold 30
 #define MAX_DRIVING_TIME 999999999999999999
 
-///************  GLOBAL VARIABLES  *****************/
-
-//key : int intersectionID, value: pointer to node
-std::unordered_map<int, Node*> nodesEncountered;
-std::unordered_map<int, Node*> walkableNodes;
-std::vector<std::pair<int, std::string>> intersectionsReached;
-double bestPathTravelTime;
 typedef std::pair<double, int> weightPair;
 
+//Every query of the free functions below runs on the calling thread's own context, so threads never share search state
+routingContext& thread_routing_context(){
+    thread_local routingContext context;
+    return context;
+}
+
+//paths found by find_path_between_intersections, cleared by load_map and close_map
+routeCache RouteCache;
+
+//segments closed to every search, updated while queries run, cleared by load_map and close_map
+segmentClosures SegmentClosures;
+
+//live traffic travel times and their cell shortcuts, built on first use after load_map, cleared by close_map
+customizableRouter TrafficRouter;
+
+std::vector<StreetSegmentIndex> find_path_between_intersections(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end, const double turn_penalty){
+    double travelTime;
+    return find_path_and_travel_time(intersect_id_start, intersect_id_end, turn_penalty, travelTime);
+}
+
+std::vector<StreetSegmentIndex> find_path_and_travel_time(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end, 
+                                                          const double turn_penalty, double& travelTime){
+    std::vector<StreetSegmentIndex> path;
+    routingContext& context = thread_routing_context();
+    
+    //closing segments only makes paths longer, so a cached path that uses no closed segment is still the shortest
+    context.refreshClosures();
+    if (RouteCache.find(intersect_id_start, intersect_id_end, turn_penalty, path, travelTime) && !context.pathClosed(path))
+        return path;
+    
+    path = context.find_path_between_intersections(intersect_id_start, intersect_id_end, turn_penalty);
+    travelTime = compute_path_travel_time(path, turn_penalty);
+    
+    //a cancelled search found nothing, it must not be cached as "no path"
+    //paths found around closures are not cached, the cache stays valid for the open map
+    if (!context.cancelled() && !context.closuresActive())
+        RouteCache.insert(intersect_id_start, intersect_id_end, turn_penalty, path, travelTime);
+    return path;
+}
+
+std::vector<StreetSegmentIndex> find_path_avoiding(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end,
+                                                   const double turn_penalty, const std::vector<StreetSegmentIndex>& closed_segments, double& travelTime){
+    routingContext& context = thread_routing_context();
+    if (!closed_segments.empty())
+        context.setQueryClosures(std::make_shared<blockedSegments>(blockedSegments(), closed_segments, std::vector<int>()));
+    std::vector<StreetSegmentIndex> path = find_path_and_travel_time(intersect_id_start, intersect_id_end, turn_penalty, travelTime);
+    context.setQueryClosures(std::shared_ptr<const blockedSegments>());
+    return path;
+}
+
+std::pair<std::vector<StreetSegmentIndex>, std::vector<StreetSegmentIndex>> find_path_with_walk_to_pick_up(const IntersectionIndex start_intersection, 
+                                                                             const IntersectionIndex end_intersection,
+                                                                             const double turn_penalty,
+                                                                             const double walking_speed, 
+                                                                             const double walking_time_limit){
+    return thread_routing_context().find_path_with_walk_to_pick_up(start_intersection, end_intersection, turn_penalty, walking_speed, walking_time_limit);
+}
 
-std::string directionsText; //Full text for driving directions only
-std::string walkingDirectionsText; //Full text for walking directions only
+walkingIsochrone find_walking_isochrone(const IntersectionIndex start_intersection, const double turn_penalty,
+                                        const double walking_speed, const double walking_time_limit, bool withHull){
+    return thread_routing_context().find_walking_isochrone(start_intersection, turn_penalty, walking_speed, walking_time_limit, withHull);
+}
 
-//bool which returns true if path found
-//corner case: if path found, and source == dest node then path will be empty, but find_path_djikstra_bool will be true
-bool find_path_djikstra_bool;
+std::vector<StreetSegmentIndex> find_path_djikstra(const IntersectionIndex intersect_id_start, const std::vector<std::pair<int, std::string>>& pickUpDropOffNodes, const double turn_penalty){
+    return thread_routing_context().find_path_djikstra(intersect_id_start, pickUpDropOffNodes, turn_penalty);
+}
 
 // Returns the time required to travel along the path specified, in seconds.
 // The path is given as a vector of street segment ids, and this function can
@@ -37,8 +89,7 @@ double compute_path_travel_time(const std::vector<StreetSegmentIndex>& path, con
         return travelTime;
     }
     
-    //make streetinfo struct and streetID variable to retrieve streetID from street segment index
-    InfoStreetSegment segStruct;
+    //street IDs are read from SegmentStreetID (no getInfoStreetSegment call per segment)
     int previousStreetID, nextStreetID; //street IDs of two consecutive street
     
     //Find number of turn penalties by finding # of turns -> Need to find street id from street segment to get # of turns
@@ -47,18 +98,16 @@ double compute_path_travel_time(const std::vector<StreetSegmentIndex>& path, con
     std::vector<StreetSegmentIndex>::const_iterator it = path.begin();
     
     //get first streetID
-    segStruct = getInfoStreetSegment(*it);
-    previousStreetID = segStruct.streetID;
+    previousStreetID = SegmentStreetID[*it];
     
-    travelTime = find_street_segment_travel_time(*it);
+    travelTime = SegmentTravelTime[*it];
     it++;
     
     //For all street segments after the first one, run loop
     while(it != path.end()){
         
         //First check if there was a turn
-        segStruct = getInfoStreetSegment(*it);
-        nextStreetID = segStruct.streetID;
+        nextStreetID = SegmentStreetID[*it];
         
         //check if streetID has changed, if yes -> add turn penalty and increment previous streetID
         if (previousStreetID != nextStreetID){
@@ -67,7 +116,7 @@ double compute_path_travel_time(const std::vector<StreetSegmentIndex>& path, con
         } 
         
         //Second, add travel time of the street segment
-        travelTime = travelTime + find_street_segment_travel_time(*it);
+        travelTime = travelTime + SegmentTravelTime[*it];
                 
         // advance to next segment
         it++;    
@@ -84,10 +133,12 @@ double compute_path_travel_time(const std::vector<StreetSegmentIndex>& path, con
 // with the shortest travel time is returned. The path is returned as a vector
 // of street segment ids; traversing these street segments, in the returned
 // order, would take one from the start to the end intersection.
- std::vector<StreetSegmentIndex> find_path_between_intersections(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end, const double turn_penalty){
+std::vector<StreetSegmentIndex> routingContext::find_path_between_intersections(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end, const double turn_penalty){
     
     bool pathFound = false;
     std::vector<StreetSegmentIndex> path;
+    walkingRoute.clear();
+    refreshClosures();
     
 //    //make node object of starting intersection
 //    Node sourceNode(intersect_id_start);
@@ -106,6 +157,7 @@ double compute_path_travel_time(const std::vector<StreetSegmentIndex>& path, con
     if (pathFound){
         path = bfsTraceBack(intersect_id_start); //trace forwards, starting from the starting ID
     }
+    drivingRoute.set(pathFound, intersect_id_start, path, bestPathTravelTime);
     clearNodesEncountered();
     //delete wavefront data structures
     return path;        
@@ -121,8 +173,7 @@ double compute_path_walking_time(const std::vector<StreetSegmentIndex>& path,
         return travelTime;
     }
     
-    //make streetinfo struct and streetID variable to retrieve streetID from street segment index
-    InfoStreetSegment segStruct;
+    //street IDs are read from SegmentStreetID (no getInfoStreetSegment call per segment)
     int previousStreetID, nextStreetID; //street IDs of two consecutive street
     
     //Find number of turn penalties by finding # of turns -> Need to find street id from street segment to get # of turns
@@ -131,8 +182,7 @@ double compute_path_walking_time(const std::vector<StreetSegmentIndex>& path,
     std::vector<StreetSegmentIndex>::const_iterator it = path.begin();
     
     //get first streetID
-    segStruct = getInfoStreetSegment(*it);
-    previousStreetID = segStruct.streetID;
+    previousStreetID = SegmentStreetID[*it];
     
     //get first segment's travel walking speed
     double length = 0;
@@ -144,8 +194,7 @@ double compute_path_walking_time(const std::vector<StreetSegmentIndex>& path,
     while(it != path.end()){
         
         //First check if there was a turn
-        segStruct = getInfoStreetSegment(*it);
-        nextStreetID = segStruct.streetID;
+        nextStreetID = SegmentStreetID[*it];
         
         //check if streetID has changed, if yes -> add turn penalty and increment previous streetID
         if (previousStreetID != nextStreetID){
@@ -163,10 +212,54 @@ double compute_path_walking_time(const std::vector<StreetSegmentIndex>& path,
     
     return travelTime;
 }
-        
 
+/*
+ * Batch versions of compute_path_travel_time and compute_path_walking_time, for scoring many paths at once
+ * Paths are evaluated in parallel (one path per iteration), each by the scalar function, so every time is
+ * exactly the value the scalar function returns
+ * Returns: time (seconds) of each path, in the order of paths
+ */
+std::vector<double> compute_path_travel_times(const std::vector<std::vector<StreetSegmentIndex>>& paths, const double turn_penalty){
+    std::vector<double> travelTimes(paths.size());
+    
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (unsigned i = 0; i < paths.size(); i++){
+        travelTimes[i] = compute_path_travel_time(paths[i], turn_penalty);
+    }
+    return travelTimes;
+}
 
-std::pair<std::vector<StreetSegmentIndex>, std::vector<StreetSegmentIndex>> find_path_with_walk_to_pick_up(const IntersectionIndex start_intersection, 
+std::vector<double> compute_path_walking_times(const std::vector<std::vector<StreetSegmentIndex>>& paths, 
+                                               const double walking_speed, 
+                                               const double turn_penalty){
+    std::vector<double> walkingTimes(paths.size());
+    
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (unsigned i = 0; i < paths.size(); i++){
+        walkingTimes[i] = compute_path_walking_time(paths[i], walking_speed, turn_penalty);
+    }
+    return walkingTimes;
+}
+
+//Returns: total travel time of a courier route, subpaths timed in parallel then summed in order
+//(same value as summing compute_path_travel_time over the subpaths, as the courier verifier does)
+double compute_courier_route_travel_time(const std::vector<CourierSubpath>& route, const double turn_penalty){
+    std::vector<double> subpathTimes(route.size());
+    
+    #pragma omp parallel for schedule(dynamic, 4)
+    for (unsigned i = 0; i < route.size(); i++){
+        subpathTimes[i] = compute_path_travel_time(route[i].subpath, turn_penalty);
+    }
+    
+    double travelTime = 0;
+    for (unsigned i = 0; i < subpathTimes.size(); i++){
+        travelTime += subpathTimes[i];
+    }
+    return travelTime;
+}
+
+
+std::pair<std::vector<StreetSegmentIndex>, std::vector<StreetSegmentIndex>> routingContext::find_path_with_walk_to_pick_up(const IntersectionIndex start_intersection, 
                                                                              const IntersectionIndex end_intersection,
                                                                              const double turn_penalty,
                                                                              const double walking_speed, 
@@ -175,61 +268,227 @@ std::pair<std::vector<StreetSegmentIndex>, std::vector<StreetSegmentIndex>> find
     //Setting up return variables
     std::vector<StreetSegmentIndex> walkingPath;
     std::vector<StreetSegmentIndex> drivingPath;
+    walkingRoute.clear();
+    drivingRoute.clear();
+    refreshClosures();
     
     bool fullWalkPath = false;
     const double walkingLimitSecs = walking_time_limit*60; //convert time limiit from mins to s
     
     fullWalkPath = walkingPathBFS(start_intersection, end_intersection, turn_penalty, walking_speed, walkingLimitSecs);
     
+    //a newer request superseded this one while walking, no path is given
+    if (cancelRequested)
+        return std::make_pair(walkingPath, drivingPath);
+    
     if (fullWalkPath){ //no driving path needed. Walking time limit covers the full path
         walkingPath = walkBFSTraceBack(end_intersection);     
-        clearWalkableNodes();
+        walkingRoute.set(true, start_intersection, walkingPath, walkableSearch.arrivalTime(end_intersection));
         return std::make_pair(walkingPath, drivingPath);
     }
     
-    int numOfWalkableNodes = walkableNodes.size();//At least one node in map should exist (the start node)
+    int numOfWalkableNodes = walkableSearch.reachedIntersections().size();//At least one node in map should exist (the start node)
     
     if (numOfWalkableNodes < 2){ //If there are no walkable nodes other than start node
         //no walking path available. Full path should be driving only
         drivingPath = find_path_between_intersections(start_intersection, end_intersection, turn_penalty);
-        clearWalkableNodes();
         return std::make_pair(walkingPath, drivingPath);
     }
     
-    double smallestDrivingTime = MAX_DRIVING_TIME; //initialize to large number so that shorter path time is found
-    int bestWalkableIntersect = -1; 
-//    bool drivingPathPossible = false; //check for corner case: there is no driving path available for all the walkable nodes
+    //a single search backwards from the destination reaches every walkable Intersection
+    //the pick up is the one with the smallest walking time + driving time
+    int bestWalkableIntersect = pickUpDrivingSearch(end_intersection, turn_penalty);
+    
+    bool pathFound = (bestWalkableIntersect != -1 && !cancelRequested);
+    if (pathFound){
+        //no walking if the pick up is the start itself
+        if (bestWalkableIntersect != start_intersection){
+            walkingPath = walkBFSTraceBack(bestWalkableIntersect);
+            walkingRoute.set(true, start_intersection, walkingPath, walkableSearch.arrivalTime(bestWalkableIntersect));
+        }
+        drivingPath = bfsTraceBack(bestWalkableIntersect); //nodesEncountered leads from every reached node to end_intersection
+    }    
+    drivingRoute.set(pathFound, bestWalkableIntersect, drivingPath, bestPathTravelTime);
+    //reset nodesEncountered 
+    clearNodesEncountered();
 
-    bool pathFound;
-    //for every walkable Intersection
-    std::unordered_map<int, Node*>::iterator nodesIt;
-    for ( nodesIt = walkableNodes.begin(); nodesIt != walkableNodes.end(); ++nodesIt){
-        pathFound = breadthFirstSearch(end_intersection, nodesIt->first, turn_penalty);
-        if (!pathFound)
-            continue;
-//        drivingPathPossible = true;
-        if (bestPathTravelTime < smallestDrivingTime){ //attempting to find the walkable Node with the smallest driving time
-            bestWalkableIntersect = nodesIt->first;
-            smallestDrivingTime = bestPathTravelTime;
+    return std::make_pair(walkingPath, drivingPath);
+}
+
+
+/*
+ * Returns every intersection within walking_time_limit (minutes) of start_intersection, with its walking time (seconds)
+ * Same walking rules as find_path_with_walk_to_pick_up (one-ways respected, turn_penalty when the street changes)
+ * If withHull, also the convex hull of the reached intersections, to display the walkable area
+ */
+walkingIsochrone routingContext::find_walking_isochrone(const IntersectionIndex start_intersection, 
+                                        const double turn_penalty,
+                                        const double walking_speed, 
+                                        const double walking_time_limit,
+                                        bool withHull){
+    walkingIsochrone isochrone;
+    
+    if (start_intersection < 0 || start_intersection >= getNumIntersections() || walking_speed <= 0)
+        return isochrone;
+    
+    refreshClosures();
+    isochroneSearch.run(start_intersection, walking_speed, walking_time_limit*60, turn_penalty, -1, closures, &cancelRequested);
+    if (cancelRequested)
+        return isochrone;
+    
+    const std::vector<int>& reachedIDs = isochroneSearch.reachedIntersections();
+    isochrone.reached.reserve(reachedIDs.size());
+    for (std::vector<int>::const_iterator it = reachedIDs.begin(); it != reachedIDs.end(); ++it){
+        isochrone.reached.push_back(std::make_pair(*it, isochroneSearch.arrivalTime(*it)));
+    }
+    
+    //nearest first
+    std::sort(isochrone.reached.begin(), isochrone.reached.end(), [](const std::pair<int, double>& a, const std::pair<int, double>& b){
+        return a.second < b.second;
+    });
+    
+    if (withHull){
+        std::vector<ezgl::point2d> points;
+        points.reserve(reachedIDs.size());
+        for (std::vector<int>::const_iterator it = reachedIDs.begin(); it != reachedIDs.end(); ++it){
+            points.push_back(IntersectionXY[*it]);
         }
-      
-        //reset nodesEncountered for the next driving path
-        clearNodesEncountered();
+        isochrone.hull = convexHull(points);
     }
     
-    if (bestWalkableIntersect != -1){
-        walkingPath = walkBFSTraceBack(bestWalkableIntersect);
-        pathFound = breadthFirstSearch(end_intersection, bestWalkableIntersect, turn_penalty); //there's no significance of holding this value of pathFound
-        drivingPath = bfsTraceBack(bestWalkableIntersect); //can assume that pathFound is true at this point 
-        //reset nodesEncountered 
-        clearNodesEncountered();
-    }    
-    clearWalkableNodes();    
-    return std::make_pair(walkingPath, drivingPath);
+    return isochrone;
 }
 
+//Returns: convex hull of points (monotone chain), counter-clockwise, without collinear points
+std::vector<ezgl::point2d> convexHull(std::vector<ezgl::point2d> points){
+    
+    if (points.size() < 3)
+        return points;
+    
+    std::sort(points.begin(), points.end(), [](const ezgl::point2d& a, const ezgl::point2d& b){
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    
+    //> 0 if o -> a -> b turns counter-clockwise
+    auto cross = [](const ezgl::point2d& o, const ezgl::point2d& a, const ezgl::point2d& b){
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    };
+    
+    std::vector<ezgl::point2d> hull(2 * points.size(), ezgl::point2d(0, 0));
+    int size = 0;
+    
+    //lower hull, left to right
+    for (unsigned i = 0; i < points.size(); i++){
+        while (size >= 2 && cross(hull[size - 2], hull[size - 1], points[i]) <= 0)
+            size--;
+        hull[size++] = points[i];
+    }
+    
+    //upper hull, right to left
+    int lowerSize = size + 1;
+    for (int i = (int) points.size() - 2; i >= 0; i--){
+        while (size >= lowerSize && cross(hull[size - 2], hull[size - 1], points[i]) <= 0)
+            size--;
+        hull[size++] = points[i];
+    }
+    
+    //the first point was added again at the end
+    hull.erase(hull.begin() + size - 1, hull.end());
+    return hull;
+}
+
+/*
+ * Driving part of find_path_with_walk_to_pick_up: one Dijkstra search backwards from destID (driving against each segment)
+ * A node's bestTime is its driving time to destID, and its reachingEdge is the next segment towards destID
+ * Stops once every walkable node is reached, or once no pick up can beat the best total (walking times are >= 0)
+ * Fills nodesEncountered (traced with bfsTraceBack) and bestPathTravelTime (driving time from the pick up)
+ * Returns: the walkable node with the smallest walking time + driving time, -1 if none can drive to destID
+ */
+int routingContext::pickUpDrivingSearch(int destID, const double turn_penalty){
+    
+    bestPathTravelTime = 0;
+    Node* destNodePtr = new Node(destID, NO_EDGE, NO_TIME);
+    nodesEncountered.insert({destID, destNodePtr});
+    
+    //(driving time to destID, intersection ID), smallest time first
+    std::priority_queue<weightPair, std::vector<weightPair>, std::greater<weightPair>> waveQueue;
+    waveQueue.push(std::make_pair(NO_TIME, destID));
+    
+    int bestPickUp = -1;
+    double bestTotalTime = MAX_DRIVING_TIME;
+    int walkableLeft = walkableSearch.reachedIntersections().size(); //walkable nodes not reached yet
+    
+    while (!waveQueue.empty()){
+        //a newer request superseded this search
+        if (cancelRequested)
+            return -1;
+        
+        double waveCurrentTime = waveQueue.top().first;
+        Node* waveCurrentNode = getNodeByID(waveQueue.top().second);
+        waveQueue.pop();
+        
+        //a faster way to this node was found after this wave was queued
+        if (waveCurrentTime > waveCurrentNode->bestTime)
+            continue;
+        
+        //walking takes no negative time, so no node reached from here on can beat the best total
+        if (waveCurrentTime >= bestTotalTime)
+            break;
+        
+        if (walkableSearch.reached(waveCurrentNode->ID)){
+            double totalTime = walkableSearch.arrivalTime(waveCurrentNode->ID) + waveCurrentTime;
+            if (totalTime < bestTotalTime){
+                bestTotalTime = totalTime;
+                bestPickUp = waveCurrentNode->ID;
+                bestPathTravelTime = waveCurrentTime;
+            }
+            
+            if (--walkableLeft == 0)
+                break;
+        }
+        
+        for (std::vector<int>::const_iterator it = waveCurrentNode->outEdgeIDs.begin(); it != waveCurrentNode->outEdgeIDs.end(); ++it){
+            if (closures.closed(*it))
+                continue;
+            //the outer node drives to the current node along this segment
+            InfoStreetSegment segStruct = getInfoStreetSegment(*it);
+            int outerIntersectID;
+            if (segStruct.from == waveCurrentNode->ID){
+                if (segStruct.oneWay)
+                    continue; //one-way away from the current node
+                outerIntersectID = segStruct.to;
+            }
+            else{
+                outerIntersectID = segStruct.from;
+            }
+            
+            //turn penalty if the street changes between this segment and the next one towards destID
+            double newTravelTime = waveCurrentTime + SegmentTravelTime[*it];
+            if (waveCurrentNode->reachingEdge != NO_EDGE && getInfoStreetSegment(waveCurrentNode->reachingEdge).streetID != segStruct.streetID)
+                newTravelTime += turn_penalty;
+            
+            std::unordered_map<int, Node*>::const_iterator nodeItr = nodesEncountered.find(outerIntersectID);
+            Node* outerNode;
+            if (nodeItr == nodesEncountered.end()){
+                outerNode = new Node(outerIntersectID, NO_EDGE, MAX_DRIVING_TIME);
+                nodesEncountered.insert({outerIntersectID, outerNode});
+            }
+            else{
+                outerNode = nodeItr->second;
+            }
+            
+            if (newTravelTime < outerNode->bestTime){
+                outerNode->bestTime = newTravelTime;
+                outerNode->reachingEdge = *it;
+                waveQueue.push(std::make_pair(newTravelTime, outerIntersectID));
+            }
+        }
+    }
+    
+    return bestPickUp;
+}
 
-bool breadthFirstSearch(int startID, int destID, const double turn_penalty){
+bool routingContext::breadthFirstSearch(int startID, int destID, const double turn_penalty){
     
     bestPathTravelTime = 0;
     //Create Node for start Intersection
@@ -244,12 +503,8 @@ bool breadthFirstSearch(int startID, int destID, const double turn_penalty){
     //get direction from startID to destID -> it is the FIRST ideal direction
     double idealDirection = getDirectionAngle(startID, destID);
     
-    //variable to be used later to store destination node's latlon coordinates
-    LatLon destLatLon= getIntersectionPosition(destID);
     //calculate distance from source node to dest node for future calculations
-    LatLon sourceLatLon = getIntersectionPosition(startID);
-    std::pair<LatLon, LatLon> startToDestLatLon (sourceLatLon, destLatLon);
-    double distanceFromSourceToEnd = find_distance_between_two_points(startToDestLatLon);
+    double distanceFromSourceToEnd = distanceBetweenPoints(IntersectionLatLonArrays, startID, destID);
     
      //put source node into wavefront
     wave sourceWave(sourceNodePtr, NO_EDGE, NO_TIME, NO_DIRECTION_DIFFERENCE, PERFECT_HEURISTIC, waveIDTracker);
@@ -262,6 +517,10 @@ bool breadthFirstSearch(int startID, int destID, const double turn_penalty){
        
     //while there exists nodes in the queue, check these connected nodes
     while (!waveQueue.empty()){   
+        //a newer request superseded this search
+        if (cancelRequested)
+            return false;
+        
         //first deal with wave at top of list
         wave waveCurrent = waveList[waveQueue.top().waveIDTracker]; //based on the ID with smallest weighting in priority queue, get that wave
         //remove top wave, it is being checked
@@ -293,6 +552,9 @@ bool breadthFirstSearch(int startID, int destID, const double turn_penalty){
             std::vector<int>::iterator it;
             
             for(it = edges.begin(); it != edges.end(); ++it){
+                //closed segments are never driven on
+                if (closures.closed(*it))
+                    continue;
                 //find "TO" intersection for segment and push node and edge used to get to node to bottom of wavefront
                 InfoStreetSegment segStruct = getInfoStreetSegment(*it);
                 if (segStruct.from == waveCurrentNode->ID){
@@ -349,9 +611,7 @@ bool breadthFirstSearch(int startID, int destID, const double turn_penalty){
                 }
                 
                 //find distance from outerNode to destinatino node to decide order of priority queue
-                LatLon outerNodeLatLon = getIntersectionPosition(outerNode->ID);
-                std::pair <LatLon, LatLon> nodeToEnd (outerNodeLatLon, destLatLon);
-                double distanceFromNodeToEnd = find_distance_between_two_points(nodeToEnd);
+                double distanceFromNodeToEnd = distanceBetweenPoints(IntersectionLatLonArrays, outerNode->ID, destID);
                 //calculate percentage of distance from node to end to distance from source to end
                 double heuristic = 10*directionDif / 2*M_PI + 70*distanceFromNodeToEnd/distanceFromSourceToEnd + 20*(MaxSpeedLimit - segStruct.speedLimit)/MaxSpeedLimit;
                 
@@ -368,487 +628,148 @@ bool breadthFirstSearch(int startID, int destID, const double turn_penalty){
     waveQueue = std::priority_queue<wave, std::vector<wave>, compareHeuristicFunction>();
     waveList.clear();
     //if no path is found
-    directionsText = "No path found";
     return false;
 }
 
 //bfsTraceBack is actually "tracing forward" since initially start and end IDs were flipped
-//Creates message for directions of path
-std::vector<StreetSegmentIndex> bfsTraceBack(int startID){ //startID is the node from which we start to "Trace back" from
+//Returns: the path from startID, following each node's reachingEdge (directions are built later, only if asked for)
+std::vector<StreetSegmentIndex> routingContext::bfsTraceBack(int startID){ //startID is the node from which we start to "Trace back" from
     std::vector<StreetSegmentIndex> path;
-    Node * nextNode = getNodeByID(startID);
-    //get reaching edge segment from destination Node
-    int forwardSegID = nextNode->reachingEdge;
-
-    //variable to store intersectionID
     int nextIntersectID = startID;
-    //historic street seg & intersection needed for directions
-    int previousIntersectID = NO_EDGE, middleIntersectID = nextIntersectID;//Set to -1 for non-existent values (since initially looking at first Node)
-    std::string directionInstruction = ""; //a single line of the directions
-    
-    //Make instructions more condensed by combining redundant instructions that say "Continue Straight" for the same street
-    int redundantStreetID = -1; //keep track of the redundant street ID
-    bool continuingStraight = false; //flag to keep track if the directions continuously follow straight
-    double distanceCombined = 0; //track the total distance to travel accross all redundant street segments
+    int forwardSegID = getNodeByID(startID)->reachingEdge;
     
     while (forwardSegID != NO_EDGE){
-
-        middleIntersectID = nextIntersectID;
+        path.push_back(forwardSegID);
         
-        path.push_back(forwardSegID); //this segment is part of the path
-        segmentHighlight[forwardSegID].driving = true; //part of driving path
-        segmentsHighlighted.push_back(forwardSegID); //add this segment to the list of those highlighted
-                
-        //advance nextNode
-        //find intersection-node the segment came to current node from and set it to next node
+        //advance to the intersection at the other end of the segment
         InfoStreetSegment segStruct = getInfoStreetSegment(forwardSegID);
-        
-        if (segStruct.to == nextIntersectID){
-            nextNode = getNodeByID(segStruct.from);
-        }
-        else{
-            nextNode = getNodeByID(segStruct.to);
-        }
-        
-        nextIntersectID = nextNode->ID; //update intersectionID as the intersection at nextNode
-        
-        //At this point, next, current, and previousIntersectID are all set
-        //There are 4 parts to direction:
-        //1. "In __ km / m"
-        //2. Navigation ("Turn Left/Right" / "Continue Straight" / "Make a U-turn" / "Head [bearing]" )
-        //3. "on"
-        //4. New street name
-        
-        //Order of parts computed: 2, 3, 4, 1
-        directionInstruction = ""; //reset value of directionInstruction (single line in the directions)
-        //part #2:
-        if(previousIntersectID ==NO_EDGE){ //if this is the first street seg of path
-            directionInstruction += "Head ";
-            LatLon midInter = IntersectionCoordinates[middleIntersectID];
-            LatLon nextInter = IntersectionCoordinates[nextIntersectID];
-            
-            std::pair <double, double> xyStart = latLonToCartesian(midInter);
-            std::pair <double, double> xyNext = latLonToCartesian(nextInter); 
-            double angle = getRotationAngle(xyStart, xyNext); //angle returned is in range [-180, 180]
-            
-            if (angle <= 30)
-                directionInstruction += "East ";
-            else if (angle <= 60)
-                directionInstruction += "North East ";
-            else if (angle <= 120)
-                directionInstruction += "North ";
-            else if (angle <= 150)
-                directionInstruction += "North West";
-            else if (angle <= 210)
-                directionInstruction += "West ";
-            else if (angle <= 240)
-                directionInstruction += "South West";
-            else if (angle <= 300)
-                directionInstruction += "South ";
-            else if (angle <= 330)
-                directionInstruction += "South East";
-            else //if (angle <= 180)
-                directionInstruction += "East ";
-            
-        }//end of (if this is the first segment)
-        
-        else{    
-            LatLon prevInter = IntersectionCoordinates[previousIntersectID];
-            LatLon midInter = IntersectionCoordinates[middleIntersectID];
-            LatLon nextInter = IntersectionCoordinates[nextIntersectID];
-            
-            std::pair <double, double> xyPrev = latLonToCartesian(prevInter);
-            std::pair <double, double> xyMid = latLonToCartesian(midInter);
-            std::pair <double, double> xyNext = latLonToCartesian(nextInter); 
-            double angle1 = getRotationAngle(xyPrev, xyMid); //angle of first segment with respect to x, y axis
-            double angle2 = getRotationAngle(xyMid, xyNext); //angle of second segment
-            double angleDiff = angle2 - angle1; //compare the angle the next street with previous street
-            
-            bool flagBroken = false; //helper flag for when the street segment transitions from being redundant to NOT being redundant
-            if (continuingStraight){
-                if (segStruct.streetID==redundantStreetID && angleDiff > -15 && angleDiff <=15){ //if the continuingStraight flag should still be true
-                    distanceCombined += SegmentLengths[forwardSegID]; //increment the total distance that was skipped (redundant)
-                    
-                    //attempt to skip to next iteration of while loop (skip to the next segment)
-                    previousIntersectID = middleIntersectID; //advance prevoiusIntersectID
-                    forwardSegID = nextNode->reachingEdge; 
-                    continue;
-                }
-                else{ //If segment is no longer redundant, continuingStraight flag must be reset
-                    flagBroken = true;
-                    continuingStraight = false;
-                    directionInstruction += "\nIn " + printDistance(distanceCombined)+", ";
-                    distanceCombined = 0; //reset the total distance combined back to 0, for safety (redundancy has been dealt with)
-                }
-            }
-           
-            
-            if (angleDiff > 165){ //next street is angled at > 165 degrres counter-clockwise 
-                directionInstruction += "Make a Sharp Left ";//or U-turn
-            }
-            else if (angleDiff > 15){ //next street is angled between 15 and 165 degrres counter-clockwise (Left turn)
-                directionInstruction += "Turn Left ";//Left turn
-            }
-            else if (angleDiff > -15 && !continuingStraight){ //next street is angled between 15 and -15 degrees (straight "turn")
-                //Two possible cases. Cases determined using flagBroken:
-                //Case 1: We reached a straight segment and consecutively, it is straight for the first time (if flagBroken is FALSE)
-                //Case 2: Special case were street segments remain straight, however the name has been changed (e.g. College St to Carlton St) (if flagBroken is TRUE) 
-                
-                directionInstruction += "Continue Straight ";//required to print in both cases
-                
-                if (!flagBroken){ //in this case, we do NOT want to reset the process of setting the flag for continuingStraight and checking for redundancy. 
-                    directionsText +=directionInstruction;
-                    redundantStreetID = segStruct.streetID;
-                    directionsText += "on " + getStreetName(redundantStreetID);
-                    distanceCombined = SegmentLengths[forwardSegID];
-                    continuingStraight = true;
-                    
-                    //attempt to skip to next iteration of while loop
-                    previousIntersectID = middleIntersectID; //advance prevoiusIntersectID
-                    forwardSegID = nextNode->reachingEdge;  
-                    continue;
-                }
-            }
-            else if (angleDiff > -165){ //Right Turn 
-                directionInstruction += "Turn Right ";//Right turn
-            }
-            else{  //next street is angled < -165 degrres (clockwise) (Sharp right turn or U-turn)
-                directionInstruction += "Make a Sharp Right ";//U-turn or Sharp Right turn
-            }
-        }
-        //part #3:
-        directionInstruction += "on ";
-        
-        //part #4:
-        directionInstruction += getStreetName(segStruct.streetID);
-        
-        //part #1:
-        directionInstruction +="\nIn "+printDistance(SegmentLengths[forwardSegID])+", ";
-        
-        directionsText+=directionInstruction;
-        
-        previousIntersectID = middleIntersectID; //advance prevoiusIntersectID
-
-        //retrieve next segment (segment after nextNode)
-        //invalid read of size 4
-        forwardSegID = nextNode->reachingEdge;        
+        nextIntersectID = (segStruct.to == nextIntersectID) ? segStruct.from : segStruct.to;
+        forwardSegID = getNodeByID(nextIntersectID)->reachingEdge;
     }
     
-    if (distanceCombined!=0) //special case if the path ends with a redundant street name. Part #1 (remaining distance) needs to be printed
-        directionsText += "\nIn " + printDistance(distanceCombined)+", ";
-    
-    directionsText = "Driving Directions:\n\n"+directionsText + "You will arrive at your destination. \nEstimated time: " 
-            + printTime(bestPathTravelTime/60); //convert bestPathTravelTime from seconds to minutes
-       
-    
     return path;
 }
 
-bool walkingPathBFS(int startID, int destID, const double turn_penalty,
+bool routingContext::walkingPathBFS(int startID, int destID, const double turn_penalty,
         const double walking_speed,const double walking_time_limit){
 
-    //Create Node for start Intersection
-    Node* sourceNodePtr = new Node(startID, NO_EDGE, NO_TIME);
-    walkableNodes.insert({startID, sourceNodePtr}); //keep track of new start node and its ID (for deletion)
-    
-    //declare list which will contain queue of nodes to check 
-    std::vector<wave> waveList; //change data structure to heap
-    std::priority_queue<wave, std::vector<wave>, compareWalkingTime> waveQueue; //hold all the weights with the IDs of the waves (to be accesed from vector)
-    int waveIDTracker = 0; //keep track of IDs of waves
-    
-     //put source node into wavefront
-    wave sourceWave(sourceNodePtr, NO_EDGE, NO_TIME, NO_DIRECTION_DIFFERENCE, PERFECT_HEURISTIC, waveIDTracker);
-    waveList.push_back(sourceWave);
-    waveQueue.push(sourceWave); //0 length for reaching edge, 0 for ID in waveList as its the first wave 
-    waveIDTracker++; //advance to next ID of wave
+    //walks everywhere within the limit unless destID is reached first (then no driving is needed)
+    //the walkable intersections are left in walkableSearch for the pick up search and walkBFSTraceBack
+    return walkableSearch.run(startID, walking_speed, walking_time_limit, turn_penalty, destID, closures, &cancelRequested);
+}
+
+/*
+ * Returns: the walking path from the start of the last walkableSearch to pickupIntersectID
+ * Traced back from the pick up (each intersection's reachingEdge), then reversed
+ * */
+std::vector<StreetSegmentIndex> routingContext::walkBFSTraceBack(int pickupIntersectID){ 
+    std::vector<StreetSegmentIndex> path;
+    int prevNodeID = pickupIntersectID;
+    int reachingSegID = walkableSearch.reachingEdge(prevNodeID);
     
-    //variable to be used later to store intersection ID as an int
-    int  outerIntersectID;
-       
-    //while there exists nodes in the queue, check these connected nodes
-    while (!waveQueue.empty()){  
+    while (reachingSegID != NO_EDGE){
+        path.push_back(reachingSegID);
         
-        /*First, extract wave & node*/
-        //extract wave at top of list
-        wave waveCurrent = waveList[waveQueue.top().waveIDTracker]; //based on the ID with smallest weighting in priority queue, get that wave
-        waveQueue.pop(); //remove top wave, it is being checked
+        InfoStreetSegment segStruct = getInfoStreetSegment(reachingSegID);
+        prevNodeID = (segStruct.to == prevNodeID) ? segStruct.from : segStruct.to;
+        reachingSegID = walkableSearch.reachingEdge(prevNodeID);
+    }
+    
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+/*
+ * Returns: the maneuvers along path (from startID), in one forward pass
+ * Segments that go on straight along the same street are merged into the maneuver before them
+ */
+std::vector<maneuver> path_maneuvers(int startID, const std::vector<StreetSegmentIndex>& path){
+    std::vector<maneuver> maneuvers;
+    int fromID = startID;
+    double previousAngle = 0;
+    
+    for (unsigned i = 0; i < path.size(); i++){
+        InfoStreetSegment segStruct = getInfoStreetSegment(path[i]);
+        int toID = (segStruct.from == fromID) ? segStruct.to : segStruct.from;
         
-        //extract Node  Characteristics
-        Node * waveCurrentNode = waveCurrent.node; 
-        double waveCurrentTime = waveCurrent.travelTime;
+        double angle = getRotationAngle(intersectionToCartesian(fromID), intersectionToCartesian(toID)); //in [0, 360)
         
-        /*Check Corner Case: Destination can be reached within walking time limit*/
-        //check if current node is destination node
-        if (waveCurrent.node->ID == destID){
-            waveQueue = std::priority_queue<wave, std::vector<wave>, compareWalkingTime >();
-            waveList.clear();
-            return true;
+        if (i == 0){
+            compassBearing bearing;
+            if (angle <= 30 || angle > 330)
+                bearing = eastBearing;
+            else if (angle <= 60)
+                bearing = northEastBearing;
+            else if (angle <= 120)
+                bearing = northBearing;
+            else if (angle <= 150)
+                bearing = northWestBearing;
+            else if (angle <= 210)
+                bearing = westBearing;
+            else if (angle <= 240)
+                bearing = southWestBearing;
+            else if (angle <= 300)
+                bearing = southBearing;
+            else
+                bearing = southEastBearing;
+            
+            maneuvers.push_back({headManeuver, bearing, segStruct.streetID, SegmentLengths[path[i]]});
         }
-                        
-        if (waveCurrentTime >= walking_time_limit) //If walking time limit has been "used up" for this node
-            continue; //skip to next wave, no need to crawl to outer nodes
+        else{
+            //turn from the previous segment, counter-clockwise positive, in (-180, 180]
+            double angleDiff = angle - previousAngle;
+            if (angleDiff > 180)
+                angleDiff -= 360;
+            else if (angleDiff <= -180)
+                angleDiff += 360;
             
-        /*Assume that crawling can be performed on wave's Node (Node's travelling Time is < walking_time_limit */
-
-        /*Visit each outernode and evaluate walking time. Then decide whether to create wave and add to queue*/
-        std::vector<int>edges = waveCurrentNode->outEdgeIDs; //extract node's outer edges
-        std::vector<int>::iterator it;
-        for(it = edges.begin(); it != edges.end(); ++it){
-            //find "TO" intersection for segment and push node and edge used to get to node to bottom of wavefront
-            InfoStreetSegment segStruct = getInfoStreetSegment(*it);
-            if (segStruct.from == waveCurrentNode->ID){
-                //check if one-way
-                if (segStruct.oneWay)
-                    continue; //path down this segment is invalid, skip to next segment
-                outerIntersectID = segStruct.to;
-            }
-            else{ //the inner Node = the 'to' of the segment
-                outerIntersectID = segStruct.from;
-            }
-
-            std::unordered_map<int,Node*>::const_iterator nodeItr =  walkableNodes.find(outerIntersectID);
-            Node* outerNode;
-
-            if (nodeItr == walkableNodes.end()){ //if node does not exist yet
-                
-                //compute projected walking time for the node. Check if this node's travel time is within the limit
-                double newTravelTime;
-                
-                if (waveCurrentNode->reachingEdge == NO_EDGE){//corner case: current node is the start node, so there doesn't exist a reaching edge
-                    newTravelTime = SegmentLengths[*it]/walking_speed; //travel time is only the time of the current segment
-                }
-                
-                else{//if previous segment (reaching edge) exists
-                    std::vector<int> adjacentSegments; //hold street segment nodes leading to source node as well as the connecting segment to the outer node
-                    adjacentSegments.push_back(waveCurrentNode->reachingEdge); //reaching edge of source node
-                    adjacentSegments.push_back(*it); //segment from inner to outer node
-                    //calculate travel time of both adjacent segments, subtract off the 1st segment 
-                    //result is the turn_penalty (if applicable) and 2nd street seg travel time               
-                    newTravelTime = compute_path_walking_time(adjacentSegments, walking_speed, turn_penalty);
-                    newTravelTime-= SegmentLengths[waveCurrentNode->reachingEdge]/walking_speed;
-                    newTravelTime += waveCurrentTime;
-                }
-                if (newTravelTime > walking_time_limit) //Walking to this Node would take longer than walking_time_limit
-                    continue;
-                
-                //otherwise, create a new node to add to wave
-                outerNode = new Node(outerIntersectID, *it, newTravelTime);//create a new Node
-                walkableNodes.insert({outerIntersectID, outerNode});
-                
-                //create wave + push to queue
-                //push to list   
-                
-                wave outerWave(outerNode, *it, newTravelTime, NO_DIRECTION_DIFFERENCE, PERFECT_HEURISTIC, waveIDTracker);
-                waveList.push_back(outerWave);
-                waveQueue.push(outerWave); 
-                waveIDTracker++; //advance to next ID of wave
-
+            if (angleDiff > -15 && angleDiff <= 15 && segStruct.streetID == maneuvers.back().streetID){
+                maneuvers.back().distance += SegmentLengths[path[i]]; //same street, straight on: nothing to say
             }
-            else{ //if node exists, use the existing node
-                outerNode = nodeItr->second;
-//                int reachingSeg = outerNode->reachingEdge;
-                //compute projected walking time for the node
-                double newTravelTime;
-                
-                if (waveCurrentNode->reachingEdge==NO_EDGE){//corner case: current node is the start node, so there doesn't exist a reaching edge
-                    newTravelTime = SegmentLengths[*it]/walking_speed; //travel time is only the time of the current segment
-                }
+            else{
+                maneuverType type;
+                if (angleDiff > 165)
+                    type = sharpLeftManeuver; //or U-turn
+                else if (angleDiff > 15)
+                    type = turnLeftManeuver;
+                else if (angleDiff > -15)
+                    type = continueStraightManeuver;
+                else if (angleDiff > -165)
+                    type = turnRightManeuver;
+                else
+                    type = sharpRightManeuver; //or U-turn
                 
-                else{//if previous segment (reaching edge) exists
-                    std::vector<int> adjacentSegments; //hold street segmnts of the inner node and segment from inner to outer node
-                    adjacentSegments.push_back(waveCurrentNode->reachingEdge); //segment to get to inner node
-                    adjacentSegments.push_back(*it); //segment from inner to outer node
-                    //calculate travel time of both adjacent segments, subtract off the 1st segment 
-                    //result is the turn_penalty (if applicable) and 2nd street seg travel time               
-                    newTravelTime = compute_path_walking_time(adjacentSegments, walking_speed, turn_penalty);
-                    newTravelTime-= SegmentLengths[waveCurrentNode->reachingEdge]/walking_speed;
-                    newTravelTime += waveCurrentNode->bestTime;
-                }
-                if (outerNode->bestTime <= newTravelTime) //this new path to the visited node is not a shorter path (no need to crawl again))
-                    continue;
-                
-                //create wave + push to queue
-                //push to list   
-                
-                wave outerWave(outerNode, *it, newTravelTime, NO_DIRECTION_DIFFERENCE, PERFECT_HEURISTIC, waveIDTracker);
-                waveList.push_back(outerWave);
-                waveQueue.push(outerWave); 
-                waveIDTracker++; //advance to next ID of wave
+                maneuvers.push_back({type, eastBearing, segStruct.streetID, SegmentLengths[path[i]]});
             }
-
         }
-            waveCurrentNode->crawlEnable = false; //crawling complete. Reset enable to false. 
+        
+        previousAngle = angle;
+        fromID = toID;
     }
     
-    
-    waveQueue = std::priority_queue<wave, std::vector<wave>, compareWalkingTime >();
-    waveList.clear();
-
-    return false; //driving component required
+    return maneuvers;
 }
 
 /*
- * Develops Walking path and Creates message for directions
- * pickupIntersectID: the intersection we start tracing back from towards the startID  
- * Strategy: trace back from pickupIntersectID using the same traceback logic discussed in class. 
- * Print directions in reverse order as you are tracing each segment
- * */
-std::vector<StreetSegmentIndex> walkBFSTraceBack(int pickupIntersectID){ 
-    std::vector<StreetSegmentIndex> path;
-    Node * prevNode;
-    prevNode = getWalkableNodeByID(pickupIntersectID); //prevNode points to node at pickup Intersection
-    int forwardSegID = prevNode->reachingEdge; //get the segment that leads to the pickup spot. 
-    //This will be the segment between middleIntersectionID and nextIntersectionID
-
-    int nextIntersectID = pickupIntersectID;    //variable to store intersection closest to pickup 
-    int previousIntersectID, middleIntersectID; //previousIntersectID stores intersection closest to the starting point (furthest from pickup)
-    //middleIntersectID stores intersection between previous and next
-    std::string directionInstruction = ""; //a single line of the directions text (e.g. Continue Straight on Bay street)
-
-    //attempt to get the node at the other end of forwardSegID. Set this node to prevNode, which is used to set middleIntersectID
-    InfoStreetSegment segStruct = getInfoStreetSegment(forwardSegID);
-
-    if (segStruct.to == nextIntersectID){
-        prevNode = getWalkableNodeByID(segStruct.from);
-    }
-    else{
-        prevNode = getWalkableNodeByID(segStruct.to);
+ * Returns: one line per maneuver, each line after the first starting with the distance before it
+ * e.g. "Head North on Bay Street\nIn 300 m, Turn Left on College Street\nIn 1 km, "
+ */
+std::string maneuvers_text(const std::vector<maneuver>& maneuvers){
+    static const char* const BearingNames[] = {"East ", "North East ", "North ", "North West ", "West ", "South West ", "South ", "South East "};
+    static const char* const ManeuverNames[] = {"Head ", "Turn Left ", "Turn Right ", "Continue Straight ", "Make a Sharp Left ", "Make a Sharp Right "};
+    
+    std::string text;
+    for (std::vector<maneuver>::const_iterator it = maneuvers.begin(); it != maneuvers.end(); ++it){
+        text += ManeuverNames[it->type];
+        if (it->type == headManeuver)
+            text += BearingNames[it->bearing];
+        text += "on " + getStreetName(it->streetID) + "\nIn " + printDistance(it->distance) + ", ";
     }
-
-    middleIntersectID = prevNode->ID; //set middleIntersectID to the intersection at the other end of forwardSegID
-    
-    //while we are dealing with a segment that is not the first segment
-    while (prevNode->reachingEdge != NO_EDGE){
-        
-       forwardSegID = getWalkableNodeByID(nextIntersectID)->reachingEdge;  //focus on the segment between next and mid intersections       
-       int prevSegID = prevNode->reachingEdge; // a "dummy" variable representing the edge between prev and mid intersections
-               
-        path.push_back(forwardSegID); //add this segment to the path
-        segmentHighlight[forwardSegID].walking = true; //part of walking path
-        segmentsHighlighted.push_back(forwardSegID); //add this segment to the list of those highlighted
-                
-        //attempt to advance prevNode
-        segStruct = getInfoStreetSegment(prevSegID);
-        
-        if (segStruct.to == middleIntersectID){
-            prevNode = getWalkableNodeByID(segStruct.from);
-        }
-        else{
-            prevNode = getWalkableNodeByID(segStruct.to);
-        }
-        //prevNode is now at correct location. Set the previous Intersection value
-        previousIntersectID = prevNode->ID; 
-        
-        //At this point, next, mid, and previous intersections are all set
-        //There are 4 parts to direction:
-        //1. "In __ km / m"
-        //2. Navigation ("Turn Left/Right" / "Continue Straight" / "Make a U-turn" / "Head [bearing]" )
-        //3. "on"
-        //4. New street name (e.g. "College Street")
-        
-        //Order of parts computed: 2, 3, 4, 1
-        directionInstruction = ""; //reset value of directionInstruction (single line in the directions)
-        
-        //part #2:   
-        LatLon prevInter = IntersectionCoordinates[previousIntersectID];
-        LatLon midInter = IntersectionCoordinates[middleIntersectID];
-        LatLon nextInter = IntersectionCoordinates[nextIntersectID];
-
-        std::pair <double, double> xyPrev = latLonToCartesian(prevInter);
-        std::pair <double, double> xyMid = latLonToCartesian(midInter);
-        std::pair <double, double> xyNext = latLonToCartesian(nextInter); 
-        double angle1 = getRotationAngle(xyPrev, xyMid); //angle of first segment with respect to x, y axis
-        double angle2 = getRotationAngle(xyMid, xyNext); //angle of second segment
-        double angleDiff = angle2 - angle1; //compare the angle the next street with previous street
-
-        if (angleDiff > 165){ //next street is angled at > 165 degrres counter-clockwise 
-            directionInstruction += "Make a Sharp Left ";//or U-turn
-        }
-        else if (angleDiff > 15){ //next street is angled between 15 and 165 degrres counter-clockwise (Left turn)
-            directionInstruction += "Turn Left ";//Left turn
-        }
-        else if (angleDiff > -15){ //next street is angled between 15 and -15 degrees (straight "turn")
-            directionInstruction += "Continue Straight ";
-        }
-        else if (angleDiff > -165){ //Right Turn 
-            directionInstruction += "Turn Right ";//Right turn
-        }
-        else{  //next street is angled < -165 degrres (clockwise) (Sharp right turn or U-turn)
-            directionInstruction += "Make a Sharp Right ";//U-turn or Sharp Right turn
-        }
-            
-        //part #3:
-        directionInstruction += "on ";
-        
-        //part #4:
-        directionInstruction += getStreetName(getInfoStreetSegment(forwardSegID).streetID);
-        
-        //part #1:
-        directionInstruction +="\nIn "+printDistance(SegmentLengths[forwardSegID])+", ";
-        
-        walkingDirectionsText= directionInstruction + walkingDirectionsText; //insert instruction in the beginning of the text
-
-        nextIntersectID = middleIntersectID;     //advance intersections   
-        middleIntersectID = previousIntersectID; 
-        
-    } //End of while loop for all segments other than the starting street segment
-    
-    //Now deal with the starting street segment
-    forwardSegID = getWalkableNodeByID(nextIntersectID)->reachingEdge; 
-    path.push_back(forwardSegID);  //Add the starting segment to the path
-    segmentHighlight[forwardSegID].walking = true; //part of driving path
-    segmentsHighlighted.push_back(forwardSegID);
-    
-    //create the first instruction. E.g. "Head South on Yonge Street"
-    //creating part #2:
-    directionInstruction = "Head ";
-    LatLon midInter = IntersectionCoordinates[middleIntersectID];
-    LatLon nextInter = IntersectionCoordinates[nextIntersectID];
-
-    std::pair <double, double> xyStart = latLonToCartesian(midInter);
-    std::pair <double, double> xyNext = latLonToCartesian(nextInter); 
-    double angle = getRotationAngle(xyStart, xyNext); //angle returned is in range [-180, 180]
-
-    if (angle <= 30)
-        directionInstruction += "East ";
-    else if (angle <= 60)
-        directionInstruction += "North East ";
-    else if (angle <= 120)
-        directionInstruction += "North ";
-    else if (angle <= 150)
-        directionInstruction += "North West";
-    else if (angle <= 210)
-        directionInstruction += "West ";
-    else if (angle <= 240)
-        directionInstruction += "South West";
-    else if (angle <= 300)
-        directionInstruction += "South ";
-    else if (angle <= 330)
-        directionInstruction += "South East";
-    else //if (angle <= 180)
-        directionInstruction += "East ";
-
-     segStruct = getInfoStreetSegment(forwardSegID);
-
-    //part #3:
-    directionInstruction += "on ";
-
-    //part #4:
-    directionInstruction += getStreetName(segStruct.streetID);
-
-    //part #1:
-    directionInstruction +="\nIn "+printDistance(SegmentLengths[forwardSegID])+", ";
-
-    walkingDirectionsText = directionInstruction + walkingDirectionsText; //insert instruction in the beginning of the text
-    
-    walkingDirectionsText = "Walking Directions:\n\n"+walkingDirectionsText + "You will arrive at the pickup spot. \nEstimated walking time: " 
-            + printTime((getWalkableNodeByID(pickupIntersectID)->bestTime)/60); //convert bestPathTravelTime from seconds to minutes
-       
-    return path;
+    return text;
 }
 
 
-Node* getNodeByID(int intersectionID){
+Node* routingContext::getNodeByID(int intersectionID){
     Node* nodeOfID;
     
     //Use global structure to access node
@@ -857,15 +778,6 @@ Node* getNodeByID(int intersectionID){
     return nodeOfID;
 }
 
-Node* getWalkableNodeByID(int intersectionID){
-    Node* nodeOfID;
-    
-    //Use global structure to access node
-    nodeOfID = walkableNodes.find(intersectionID) -> second;
-    
-    return nodeOfID;
-}
-
 std::string printDistance(double distance){
     std::string text = "";
     
@@ -922,11 +834,9 @@ std::string printTime(double time){
 double getDirectionAngle(int from, int to){
     double radians;
     
-    LatLon fromLL = IntersectionCoordinates[from];
-    LatLon toLL = IntersectionCoordinates[to];
-    
-    std::pair < double, double > fromCart = latLonToCartesian (fromLL);
-    std::pair < double, double > toCart = latLonToCartesian (toLL);
+    //positions projected at load
+    std::pair < double, double > fromCart = intersectionToCartesian (from);
+    std::pair < double, double > toCart = intersectionToCartesian (to);
     
     radians = atan2(fromCart.second - toCart.second, fromCart.first - toCart.first);
     return radians;
@@ -941,15 +851,7 @@ double getDirectionAngle(int from, int to){
 //    }
 //}
 
-//empty walkable nodes unordered map
-void clearWalkableNodes(){
-    for (std::unordered_map<int, Node*>::iterator walkableNodesIt = walkableNodes.begin(); walkableNodesIt != walkableNodes.end(); walkableNodesIt++){
-        delete (*walkableNodesIt).second;       //invalid read here, deleting something that has already been deleted?
-    }
-    walkableNodes.clear();
-}
-
-void clearNodesEncountered(){
+void routingContext::clearNodesEncountered(){
     for (std::unordered_map<int, Node*>::iterator nodesEncounteredIt = nodesEncountered.begin(); nodesEncounteredIt != nodesEncountered.end(); nodesEncounteredIt++){
         delete (*nodesEncounteredIt).second;      
     }
@@ -958,145 +860,429 @@ void clearNodesEncountered(){
 
 
 
-std::vector<StreetSegmentIndex> find_path_djikstra(const IntersectionIndex intersect_id_start, const std::vector<std::pair<int, std::string>>pickUpDropOffNodes, const double turn_penalty){
+std::vector<StreetSegmentIndex> routingContext::find_path_djikstra(const IntersectionIndex intersect_id_start, const std::vector<std::pair<int, std::string>>& pickUpDropOffNodes, const double turn_penalty){
     
-    bool pathFound = false;
     std::vector<StreetSegmentIndex> path;
-    
-    Node* sourceNode = getNodePtrById(intersect_id_start);
-    
-    pathFound = djikstraBFS(sourceNode, pickUpDropOffNodes, turn_penalty); 
+    find_path_djikstra_bool = false;
+    refreshClosures();
     
     //If path is found, traceback path and store street segments
-    if (pathFound){
-        //get last intersection
-        int lastIntersection = intersectionsReached.back().first;
-        path = djikstraBFSTraceBack(lastIntersection); //trace forwards, starting from the starting ID
+    if (djikstraBFS(intersect_id_start, pickUpDropOffNodes, turn_penalty)){
+        path = djikstraBFSTraceBack(targetReached.first); //trace forwards, starting from the starting ID
     }
-
-    clearNodesEncountered();
-    populateNodeVector();
-    //delete wavefront data structures
+    
     return path;        
 }
 
 //returns dest node that is reached first
-bool djikstraBFS(Node* sourceNode, std::vector<std::pair<int, std::string>> pickUpDropOffNodes, const double turn_penalty){
+//the workspace is stamped per search instead of being reset, so a search only costs the nodes it reaches
+bool routingContext::djikstraBFS(int sourceID, const std::vector<std::pair<int, std::string>>& pickUpDropOffNodes, const double turn_penalty){
     
     bestPathTravelTime = 0;
     
-    //equal to turn_penalty if street_Ids change
-    double addTurnPenalty = 0;
+    djikstraSpace.prepare(getNumIntersections());
     
-    //declare list which will contain queue of nodes to check
-    std::priority_queue<waveElem, std::vector<waveElem>, compareTime> waveQueue;
+    //(travel time from the source, (intersection ID, reaching edge)), smallest time first
+    typedef std::pair<double, std::pair<int, int>> djikstraWave;
+    std::priority_queue<djikstraWave, std::vector<djikstraWave>, std::greater<djikstraWave>> waveQueue;
     
-        //put source node into wavefront
-    waveQueue.push( waveElem(sourceNode, NO_EDGE, NO_TIME) ); //0 length for reaching edge, 0 for ID in waveList as its the first wave 
-     
-    bool endNodeFound = false;
-       
-    //while a node hasn't been found
-    while (!endNodeFound){ 
-        //nodes remaining to explore
-        while (!waveQueue.empty()){ 
-            //picl out most promising node
-            waveElem wave = waveQueue.top(); //gets wave with smallest weighting in priority queue
-            waveQueue.pop();        //remove element, it is being checked
-            
-            Node * currNode = wave.node;
-
-            //otherwise if better path or new node found, update bestTime, re-expand
-            //in first iteration, currentTravelTime == 0
-            if (wave.travelTime < currNode->bestTime){
-            
-                currNode->bestTime = wave.travelTime; //update Node's best time
-                currNode->reachingEdge = wave.edgeID; //update Node's best time reaching edge
-                
-                //check if any of the destination nodes have been found
-                for (std::vector<std::pair<int, std::string>>::iterator destNodesIt = pickUpDropOffNodes.begin(); destNodesIt != pickUpDropOffNodes.end(); destNodesIt++){
-                    if (currNode->ID == destNodesIt->first){
-                        bestPathTravelTime = wave.travelTime;
-                        //put intersection ID into global variable to tell courier function that it has been reached
-                        intersectionsReached.push_back(*destNodesIt);
-                        endNodeFound = true;
-                        //path found, now clear priority queue
-                        waveQueue = std::priority_queue< waveElem, std::vector<waveElem>, compareTime >();
-                        find_path_djikstra_bool = true;
-                        return true;
-                    }
+    //put source node into wavefront
+    waveQueue.push(std::make_pair(NO_TIME, std::make_pair(sourceID, NO_EDGE)));
+    
+    //nodes remaining to explore
+    while (!waveQueue.empty()){ 
+        //a newer request superseded this search
+        if (cancelRequested)
+            return false;
+        
+        //pick out most promising node
+        double travelTime = waveQueue.top().first;
+        int currID = waveQueue.top().second.first;
+        int reachingEdge = waveQueue.top().second.second;
+        waveQueue.pop();
+        
+        //a node is expanded once, with its best time
+        if (djikstraSpace.settled(currID))
+            continue;
+        djikstraSpace.stamp[currID] = djikstraSpace.run;
+        djikstraSpace.time[currID] = travelTime;
+        djikstraSpace.edge[currID] = reachingEdge;
+        
+        //check if any of the destination nodes have been found
+        for (std::vector<std::pair<int, std::string>>::const_iterator destNodesIt = pickUpDropOffNodes.begin(); destNodesIt != pickUpDropOffNodes.end(); destNodesIt++){
+            if (currID == destNodesIt->first){
+                bestPathTravelTime = travelTime;
+                //tell the courier which target has been reached
+                targetReached = *destNodesIt;
+                find_path_djikstra_bool = true;
+                return true;
             }
+        }
         
-                //stores node ID as an int
-                int  to_nodeId;
-                for(std::vector<int>::iterator edgeIt = currNode->outEdgeIDs.begin(); edgeIt != currNode->outEdgeIDs.end(); edgeIt++){
-                
-                 //find other end of segment
-                InfoStreetSegment segStruct_out = getInfoStreetSegment(*edgeIt);
-                if (segStruct_out.to == currNode->ID){
-                    //check if one-way
-                    if (segStruct_out.oneWay)
-                        continue; //path down this segment is invalid, skip to next segment
-                    to_nodeId = segStruct_out.from;
-                }
-                else //the inner Node is the 'to' of the segment
-                    to_nodeId = segStruct_out.to;
-                                
-                //if segments have different street Ids, add a turn penalty
-                if(currNode != sourceNode){
-                    InfoStreetSegment segStruct_node = getInfoStreetSegment(currNode->reachingEdge);
-                    if(segStruct_out.streetID != segStruct_node.streetID)
-                        addTurnPenalty = turn_penalty;
-                    else addTurnPenalty = 0;
-                }
-                //*push node and edge used to wavefront
-                waveQueue.push( waveElem(getNodePtrById(to_nodeId), (*edgeIt),  wave.travelTime + SegmentTravelTime[*edgeIt] + addTurnPenalty) );
-                }
+        int reachingStreetID = (reachingEdge == NO_EDGE) ? -1 : getInfoStreetSegment(reachingEdge).streetID;
+        
+        const std::vector<int>& outEdges = IntersectionStreetSegments[currID];
+        for (std::vector<int>::const_iterator edgeIt = outEdges.begin(); edgeIt != outEdges.end(); edgeIt++){
+            if (closures.closed(*edgeIt))
+                continue;
+            //find other end of segment
+            InfoStreetSegment segStruct_out = getInfoStreetSegment(*edgeIt);
+            int to_nodeId;
+            if (segStruct_out.to == currID){
+                //check if one-way
+                if (segStruct_out.oneWay)
+                    continue; //path down this segment is invalid, skip to next segment
+                to_nodeId = segStruct_out.from;
             }
+            else //the inner Node is the 'from' of the segment
+                to_nodeId = segStruct_out.to;
+            
+            if (djikstraSpace.settled(to_nodeId))
+                continue; //already has its best time
+            
+            //if segments have different street Ids, add a turn penalty (none leaving the source)
+            double addTurnPenalty = (reachingEdge != NO_EDGE && segStruct_out.streetID != reachingStreetID) ? turn_penalty : 0;
+            
+            //push node and edge used to wavefront
+            waveQueue.push(std::make_pair(travelTime + SegmentTravelTime[*edgeIt] + addTurnPenalty, std::make_pair(to_nodeId, *edgeIt)));
         }
     }
     //if no path is found
-    directionsText = "No path found";
     return false;
 }
 
 
-std::vector<StreetSegmentIndex> djikstraBFSTraceBack(int destID){
+std::vector<StreetSegmentIndex> routingContext::djikstraBFSTraceBack(int destID){
    
     std::vector<StreetSegmentIndex> path;
-    Node* currentNode = getNodePtrById(destID);
-
-    int prevSegID = currentNode->reachingEdge; //get the segment that leads to the destination
-//
-////    int nextIntersectID = destID;     
-//  //  int previousIntersectID, middleIntersectID; //previousIntersectID stores intersection closest to the starting point (furthest from pickup)
-//    //middleIntersectID stores intersection between previous and next
-
-    InfoStreetSegment segStruct; 
+    
     int lastIntersectionID = destID;
+    int prevSegID = djikstraSpace.edge[destID]; //get the segment that leads to the destination
     
-//    //while we are dealing with a segment that is not the first segment
+    //while we are dealing with a segment that is not the first segment
     while (prevSegID != NO_EDGE){
         path.push_back(prevSegID);
-//        
-        segStruct = getInfoStreetSegment(prevSegID);
+        
+        InfoStreetSegment segStruct = getInfoStreetSegment(prevSegID);
+        lastIntersectionID = (segStruct.to == lastIntersectionID) ? segStruct.from : segStruct.to;
+        prevSegID = djikstraSpace.edge[lastIntersectionID];
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+//Returns: travel time (seconds) of the path leaving at departure_time (seconds since midnight), each segment timed by
+//SegmentSpeedProfiles when it is entered; same as compute_path_travel_time if no profiles are loaded
+double compute_path_travel_time_at(const std::vector<StreetSegmentIndex>& path, const double turn_penalty, const double departure_time){
+    
+    double clock = departure_time;
+    for (unsigned i = 0; i < path.size(); i++){
+        if (i > 0 && SegmentStreetID[path[i]] != SegmentStreetID[path[i - 1]])
+            clock += turn_penalty;
+        clock += SegmentSpeedProfiles.travelTime(path[i], clock);
+    }
+    return clock - departure_time;
+}
+
+std::vector<StreetSegmentIndex> find_path_at_departure_time(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end,
+                                                            const double turn_penalty, const double departure_time, double& travelTime){
+    routingContext& context = thread_routing_context();
+    std::vector<StreetSegmentIndex> path = context.find_path_time_dependent(intersect_id_start, intersect_id_end, turn_penalty, departure_time);
+    travelTime = context.lastPathTravelTime();
+    return path;
+}
+
+std::vector<StreetSegmentIndex> routingContext::find_path_time_dependent(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end,
+                                                                         const double turn_penalty, const double departure_time){
+    std::vector<StreetSegmentIndex> path;
+    walkingRoute.clear();
+    refreshClosures();
+    
+    bool pathFound = timeDependentSearch(intersect_id_start, intersect_id_end, turn_penalty, departure_time);
+    if (pathFound)
+        path = djikstraBFSTraceBack(intersect_id_end);
+    
+    drivingRoute.set(pathFound, intersect_id_start, path, bestPathTravelTime);
+    return path;
+}
+
+//entry of the time-dependent search's wavefront
+struct timedWave{
+    double priority; //arrival time + lower bound of the time left
+    double arrival; //clock (seconds since midnight) on reaching the intersection
+    int intersectionID;
+    int reachingEdge;
+    
+    bool operator>(const timedWave& other) const{
+        return priority > other.priority;
+    }
+};
 
-        if (segStruct.to == lastIntersectionID){
-            currentNode = getNodePtrById(segStruct.from);
+//A* over arrival times: a segment's time is looked up (SegmentSpeedProfiles) only when it is relaxed, at the clock it is
+//entered; profiles are FIFO, so settling each intersection once at its earliest arrival is exact (up to turn penalties,
+//as in djikstraBFS)
+//lower bound: distance to the destination at the fastest speed of the map, measured as segment lengths are (with the
+//cosine of the pair's own average latitude: IntersectionXY uses the map's, which overestimates east-west distances away
+//from it, and an overestimate could settle an intersection before its fastest arrival)
+bool routingContext::timeDependentSearch(int sourceID, int destID, const double turn_penalty, const double departure_time){
+    
+    bestPathTravelTime = 0;
+    
+    djikstraSpace.prepare(getNumIntersections());
+    
+    double fastestSpeed = SegmentSpeedProfiles.fastestSpeed();
+    
+    std::priority_queue<timedWave, std::vector<timedWave>, std::greater<timedWave>> waveQueue;
+    waveQueue.push({departure_time, departure_time, sourceID, NO_EDGE});
+    
+    while (!waveQueue.empty()){
+        if (cancelRequested)
+            return false;
+        
+        timedWave current = waveQueue.top();
+        waveQueue.pop();
+        
+        if (djikstraSpace.settled(current.intersectionID))
+            continue;
+        djikstraSpace.stamp[current.intersectionID] = djikstraSpace.run;
+        djikstraSpace.time[current.intersectionID] = current.arrival;
+        djikstraSpace.edge[current.intersectionID] = current.reachingEdge;
+        
+        if (current.intersectionID == destID){
+            bestPathTravelTime = current.arrival - departure_time;
+            return true;
         }
-        else{
-            currentNode = getNodePtrById(segStruct.to);
+        
+        int reachingStreetID = (current.reachingEdge == NO_EDGE) ? -1 : SegmentStreetID[current.reachingEdge];
+        
+        const std::vector<int>& outEdges = IntersectionStreetSegments[current.intersectionID];
+        for (std::vector<int>::const_iterator edgeIt = outEdges.begin(); edgeIt != outEdges.end(); edgeIt++){
+            if (closures.closed(*edgeIt))
+                continue;
+            InfoStreetSegment segStruct_out = getInfoStreetSegment(*edgeIt);
+            int to_nodeId;
+            if (segStruct_out.to == current.intersectionID){
+                if (segStruct_out.oneWay)
+                    continue;
+                to_nodeId = segStruct_out.from;
+            }
+            else
+                to_nodeId = segStruct_out.to;
+            
+            if (djikstraSpace.settled(to_nodeId))
+                continue;
+            
+            double enterTime = current.arrival;
+            if (current.reachingEdge != NO_EDGE && segStruct_out.streetID != reachingStreetID)
+                enterTime += turn_penalty;
+            double arrival = enterTime + SegmentSpeedProfiles.travelTime(*edgeIt, enterTime);
+            
+            double timeLeft = 0;
+            if (fastestSpeed > 0)
+                timeLeft = distanceBetweenPoints(IntersectionLatLonArrays, to_nodeId, destID) / fastestSpeed;
+            waveQueue.push({arrival + timeLeft, arrival, to_nodeId, *edgeIt});
+        }
+    }
+    return false;
+}
+
+std::vector<alternativePath> find_alternative_paths(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end,
+                                                    const double turn_penalty, const unsigned k){
+    return thread_routing_context().find_alternative_paths(intersect_id_start, intersect_id_end, turn_penalty, k);
+}
+
+//Returns: intersections along path, startID first
+static std::vector<int> path_intersections(int startID, const std::vector<StreetSegmentIndex>& path){
+    std::vector<int> intersections;
+    intersections.reserve(path.size() + 1);
+    intersections.push_back(startID);
+    for (std::vector<StreetSegmentIndex>::const_iterator it = path.begin(); it != path.end(); ++it){
+        InfoStreetSegment segStruct = getInfoStreetSegment(*it);
+        intersections.push_back((segStruct.from == intersections.back()) ? segStruct.to : segStruct.from);
+    }
+    return intersections;
+}
+
+/*
+ * Via intersection alternatives: one search forward from the start and one backward from the end, both stopped at
+ * (1 + ALTERNATIVE_MAX_STRETCH) times the fastest time, give for every intersection v settled by both the fastest
+ * path start -> v -> end at no further search cost. The candidates are tried shortest first; those on a path already
+ * chosen are skipped (they only give that path again)
+ */
+std::vector<alternativePath> routingContext::find_alternative_paths(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end,
+                                                                    const double turn_penalty, const unsigned k){
+    std::vector<alternativePath> alternatives;
+    walkingRoute.clear();
+    drivingRoute.clear();
+    refreshClosures();
+    bestPathTravelTime = 0;
+    
+    if (k == 0)
+        return alternatives;
+    if (intersect_id_start == intersect_id_end){
+        alternatives.push_back({std::vector<StreetSegmentIndex>(), 0});
+        drivingRoute.set(true, intersect_id_start, alternatives[0].path, 0);
+        return alternatives;
+    }
+    
+    //the forward search sets the bound once it settles the end, the backward search then stays within it
+    double bound = -1;
+    if (!boundedSearch(intersect_id_start, intersect_id_end, false, turn_penalty, bound, forwardSpace))
+        return alternatives;
+    if (!boundedSearch(intersect_id_end, -1, true, turn_penalty, bound, backwardSpace))
+        return alternatives;
+    
+    //(time through the via intersection, via intersection ID), fastest first
+    std::vector<std::pair<double, int>> candidates;
+    for (std::vector<int>::const_iterator it = forwardSpace.settledIDs.begin(); it != forwardSpace.settledIDs.end(); ++it){
+        if (!backwardSpace.settled(*it))
+            continue;
+        double viaTime = forwardSpace.time[*it] + backwardSpace.time[*it];
+        if (viaTime <= bound)
+            candidates.push_back(std::make_pair(viaTime, *it));
+    }
+    std::sort(candidates.begin(), candidates.end());
+    
+    std::vector<StreetSegmentIndex> fastest = searchSpacePath(intersect_id_end, false, forwardSpace);
+    alternatives.push_back({fastest, compute_path_travel_time(fastest, turn_penalty)});
+    bestPathTravelTime = alternatives[0].travelTime;
+    drivingRoute.set(true, intersect_id_start, fastest, bestPathTravelTime);
+    double maxTravelTime = (1 + ALTERNATIVE_MAX_STRETCH)*alternatives[0].travelTime;
+    
+    //Hashtable --> key: [segment ID] value: [chosen paths using it, as bits (path i is bit i)]
+    std::unordered_map<int, unsigned long> chosenSegments;
+    //Hashtable --> key: [intersection ID] value: [] (intersections on a chosen path)
+    std::unordered_set<int> chosenIntersections;
+    
+    std::vector<int> intersections = path_intersections(intersect_id_start, fastest);
+    chosenIntersections.insert(intersections.begin(), intersections.end());
+    for (std::vector<StreetSegmentIndex>::const_iterator it = fastest.begin(); it != fastest.end(); ++it){
+        chosenSegments[*it] |= 1UL;
+    }
+    
+    unsigned tried = 0;
+    for (std::vector<std::pair<double, int>>::const_iterator candidate = candidates.begin();
+         candidate != candidates.end() && alternatives.size() < k && alternatives.size() < 8*sizeof(unsigned long) && tried < ALTERNATIVE_MAX_CANDIDATES; ++candidate){
+        if (cancelRequested)
+            break;
+        
+        int viaID = candidate->second;
+        if (chosenIntersections.count(viaID) != 0)
+            continue;
+        tried++;
+        
+        std::vector<StreetSegmentIndex> path = searchSpacePath(viaID, false, forwardSpace);
+        std::vector<StreetSegmentIndex> toEnd = searchSpacePath(viaID, true, backwardSpace);
+        path.insert(path.end(), toEnd.begin(), toEnd.end());
+        
+        //the two halves may cross each other
+        intersections = path_intersections(intersect_id_start, path);
+        std::vector<int> sortedIntersections = intersections;
+        std::sort(sortedIntersections.begin(), sortedIntersections.end());
+        if (std::adjacent_find(sortedIntersections.begin(), sortedIntersections.end()) != sortedIntersections.end())
+            continue;
+        
+        double travelTime = compute_path_travel_time(path, turn_penalty);
+        if (travelTime > maxTravelTime)
+            continue;
+        
+        //time shared with each chosen path
+        std::vector<double> sharedTime(alternatives.size(), 0);
+        for (std::vector<StreetSegmentIndex>::const_iterator it = path.begin(); it != path.end(); ++it){
+            std::unordered_map<int, unsigned long>::const_iterator chosen = chosenSegments.find(*it);
+            if (chosen == chosenSegments.end())
+                continue;
+            for (unsigned i = 0; i < alternatives.size(); i++){
+                if ((chosen->second >> i) & 1)
+                    sharedTime[i] += SegmentTravelTime[*it];
+            }
         }
+        if (*std::max_element(sharedTime.begin(), sharedTime.end()) > ALTERNATIVE_MAX_OVERLAP*travelTime)
+            continue;
         
-        prevSegID = currentNode->reachingEdge;
-        lastIntersectionID = currentNode->ID;
+        unsigned long pathBit = 1UL << alternatives.size();
+        for (std::vector<StreetSegmentIndex>::const_iterator it = path.begin(); it != path.end(); ++it){
+            chosenSegments[*it] |= pathBit;
+        }
+        chosenIntersections.insert(intersections.begin(), intersections.end());
+        alternatives.push_back({path, travelTime});
     }
-    std::reverse(path.begin(), path.end());
-    return path;
+    
+    return alternatives;
 }
 
-Node* getNodePtrById(int intersectionID){
-    //retreive from global structure
-    return &NodeVector[intersectionID];
+//Dijkstra from sourceID, forward (driving away from it) or backward (times of driving to it), settling intersections
+//until their time passes bound; if bound is negative, it is set to (1 + ALTERNATIVE_MAX_STRETCH) times the time of stopID
+//once stopID is settled
+//Returns: false if cancelled, or stopID wasn't reached
+bool routingContext::boundedSearch(int sourceID, int stopID, bool backward, const double turn_penalty, double& bound, searchSpace& space){
     
+    space.prepare(getNumIntersections());
+    
+    //(travel time, (intersection ID, reaching edge)), smallest time first
+    typedef std::pair<double, std::pair<int, int>> djikstraWave;
+    std::priority_queue<djikstraWave, std::vector<djikstraWave>, std::greater<djikstraWave>> waveQueue;
+    waveQueue.push(std::make_pair(NO_TIME, std::make_pair(sourceID, NO_EDGE)));
+    
+    while (!waveQueue.empty()){
+        if (cancelRequested)
+            return false;
+        
+        double travelTime = waveQueue.top().first;
+        int currID = waveQueue.top().second.first;
+        int reachingEdge = waveQueue.top().second.second;
+        waveQueue.pop();
+        
+        if (bound >= 0 && travelTime > bound)
+            break;
+        if (space.settled(currID))
+            continue;
+        space.stamp[currID] = space.run;
+        space.time[currID] = travelTime;
+        space.edge[currID] = reachingEdge;
+        space.settledIDs.push_back(currID);
+        
+        if (currID == stopID && bound < 0)
+            bound = (1 + ALTERNATIVE_MAX_STRETCH)*travelTime;
+        
+        int reachingStreetID = (reachingEdge == NO_EDGE) ? -1 : SegmentStreetID[reachingEdge];
+        
+        const std::vector<int>& edges = IntersectionStreetSegments[currID];
+        for (std::vector<int>::const_iterator edgeIt = edges.begin(); edgeIt != edges.end(); edgeIt++){
+            if (closures.closed(*edgeIt))
+                continue;
+            InfoStreetSegment segStruct = getInfoStreetSegment(*edgeIt);
+            if (segStruct.from == segStruct.to)
+                continue;
+            
+            //forward: driven from currID, backward: driven to currID
+            bool leavesFromCurr = (segStruct.from == currID);
+            if (segStruct.oneWay && leavesFromCurr == backward)
+                continue;
+            int outerID = leavesFromCurr ? segStruct.to : segStruct.from;
+            if (space.settled(outerID))
+                continue;
+            
+            double addTurnPenalty = (reachingEdge != NO_EDGE && segStruct.streetID != reachingStreetID) ? turn_penalty : 0;
+            waveQueue.push(std::make_pair(travelTime + SegmentTravelTime[*edgeIt] + addTurnPenalty, std::make_pair(outerID, *edgeIt)));
+        }
+    }
+    return stopID < 0 || space.settled(stopID);
+}
+
+//Returns: segments from the search's source to viaID (forward), or from viaID to the source (backward)
+std::vector<StreetSegmentIndex> routingContext::searchSpacePath(int viaID, bool backward, const searchSpace& space) const{
+    std::vector<StreetSegmentIndex> path;
+    
+    int intersectionID = viaID;
+    while (space.edge[intersectionID] != NO_EDGE){
+        int segmentID = space.edge[intersectionID];
+        path.push_back(segmentID);
+        InfoStreetSegment segStruct = getInfoStreetSegment(segmentID);
+        intersectionID = (segStruct.from == intersectionID) ? segStruct.to : segStruct.from;
+    }
+    
+    if (!backward)
+        std::reverse(path.begin(), path.end());
+    return path;
 }
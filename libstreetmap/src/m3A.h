@@ -6,43 +6,62 @@
 #include "ezgl/application.hpp"
 #include "ezgl/graphics.hpp"
 #include "ezgl/point.hpp"
+#include <atomic>
+#include <functional>
 #include <chrono>
 #include <thread>
 //#include <list> //remove once wavefront data structure updated
 #include "m3.h"
+#include "m4.h"
 #include "m1.h"
 #include "globals.h"
 #include "drawMap.h"
 #include <math.h>
 #include <waveElem.h>
+#include "walkingSearch.h"
+#include "routingContext.h"
 
-//M4 path finding helper functions
-bool djikstraBFS(Node* sourceNode, std::vector<std::pair<int, std::string>> pickUpDropOffNodes, const double turn_penalty);
-//bool djikstraSearch(Node* sourceNode, int destID);
-std::vector<StreetSegmentIndex> find_path_djikstra(const IntersectionIndex intersect_id_start, const std::vector<std::pair<int, std::string>> pickUpDropOffNodes, const double turn_penalty);
-std::vector<StreetSegmentIndex> djikstraBFSTraceBack(int destID);
+//Returns: the calling thread's routing context, which the free path functions (m3, m4) run on
+routingContext& thread_routing_context();
 
-//Driving Path Helper functions
-bool breadthFirstSearch(int startID, int destID, const double turn_penalty);
-std::vector<StreetSegmentIndex> bfsTraceBack(int destID);
-Node* getNodeByID(int intersectionID);
-Node* getNodePtrById(int intersectionID);
-void populateNodeVector();
+//find_path_between_intersections, also giving the path's travel time (seconds), answered from RouteCache when possible
+std::vector<StreetSegmentIndex> find_path_and_travel_time(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end, 
+                                                          const double turn_penalty, double& travelTime);
 
-//Walking Path Helper functions
-bool walkingPathBFS(int startID, int destID, const double turn_penalty, const double walking_speed, const double walking_time_limit);
-Node* getWalkableNodeByID(int intersectionID);
-std::vector<StreetSegmentIndex> walkBFSTraceBack(int pickupIntersectID); //Traces path from start to end, provides 
+//find_path_and_travel_time that also avoids closed_segments (on top of the global SegmentClosures)
+std::vector<StreetSegmentIndex> find_path_avoiding(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end,
+                                                   const double turn_penalty, const std::vector<StreetSegmentIndex>& closed_segments, double& travelTime);
+
+//Fastest path and up to k - 1 alternatives (on the calling thread's context, see routingContext::find_alternative_paths)
+std::vector<alternativePath> find_alternative_paths(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end,
+                                                    const double turn_penalty, const unsigned k);
+
+//Batch path times: paths evaluated in parallel, same values as compute_path_travel_time / compute_path_walking_time
+std::vector<double> compute_path_travel_times(const std::vector<std::vector<StreetSegmentIndex>>& paths, const double turn_penalty);
+std::vector<double> compute_path_walking_times(const std::vector<std::vector<StreetSegmentIndex>>& paths, const double walking_speed, const double turn_penalty);
+double compute_courier_route_travel_time(const std::vector<CourierSubpath>& route, const double turn_penalty);
+
+//Time of day driving (SegmentSpeedProfiles): departure_time is seconds since midnight, travelTime is set in seconds
+std::vector<StreetSegmentIndex> find_path_at_departure_time(const IntersectionIndex intersect_id_start, const IntersectionIndex intersect_id_end,
+                                                            const double turn_penalty, const double departure_time, double& travelTime);
+double compute_path_travel_time_at(const std::vector<StreetSegmentIndex>& path, const double turn_penalty, const double departure_time);
+
+//M4 path finding: path to whichever of pickUpDropOffNodes is reached first (on the calling thread's context)
+std::vector<StreetSegmentIndex> find_path_djikstra(const IntersectionIndex intersect_id_start, const std::vector<std::pair<int, std::string>>& pickUpDropOffNodes, const double turn_penalty);
+
+//Walking isochrone
+walkingIsochrone find_walking_isochrone(const IntersectionIndex start_intersection, const double turn_penalty, const double walking_speed, const double walking_time_limit, bool withHull = false);
+std::vector<ezgl::point2d> convexHull(std::vector<ezgl::point2d> points);
 
 double getDirectionAngle(int from, int to);
 
+//Directions: maneuvers of a path, then their text (see routingContext::drivingDirections)
+std::vector<maneuver> path_maneuvers(int startID, const std::vector<StreetSegmentIndex>& path);
+std::string maneuvers_text(const std::vector<maneuver>& maneuvers);
+
 //Printing Helper Functions
 std::string printTime(double time);
 std::string printDistance(double distance);
 
-//Clearing Data Structures
-void clearWalkableNodes();
-void clearNodesEncountered();
-
 #endif /* M3A_H */
 
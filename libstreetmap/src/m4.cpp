@@ -118,6 +118,8 @@ std::vector<CourierSubpath> traveling_courier( const std::vector<DeliveryInfo>&
     int intersectionFound;
     std::string pUdOprev, pUdOcurrent;
     std::vector<unsigned> deliveriesPickedUp; //?
+    //searches run on this thread's own context, so couriers can be planned on several threads at once
+    routingContext& context = thread_routing_context();
     std::vector <std::pair<int, std::string>> revisitLocations;
     
     while(pickUpDropOffLocations.empty() == false){ 
@@ -128,20 +130,18 @@ std::vector<CourierSubpath> traveling_courier( const std::vector<DeliveryInfo>&
         //If we are dealing with the first pick up (the intersection before must be a depot)
         if (prevIntersectID == NO_DELIVERY_NODE){ 
             //Find directions from starting Depot to the nearest pickup
-            drivingPath = find_path_djikstra(startDepot, pickUpDropOffLocations , turn_penalty);
+            drivingPath = context.find_path_djikstra(startDepot, pickUpDropOffLocations , turn_penalty);
             //if path does not exist
-            if ( drivingPath.empty() && (find_path_djikstra_bool == false) ){ 
+            if ( drivingPath.empty() && !context.djikstraPathFound() ){ 
                 invalidPath = true;
                 break;
              }
-            //otherwise, path was legal, rest global variable
-            find_path_djikstra_bool = false;
             
             //This is the first subpath from starting intersection to first delivery. Pick up indices should have the starting indice.
             //get intersection id that was reached in djikstra find_path and use it to put the subpath into struct and full path vector
             //set the current string
-            intersectionFound = intersectionsReached.back().first;
-            pUdOcurrent = intersectionsReached.back().second;
+            intersectionFound = context.lastTargetReached().first;
+            pUdOcurrent = context.lastTargetReached().second;
             
             //to be safe
             pickUpIndices.clear();
@@ -180,17 +180,15 @@ std::vector<CourierSubpath> traveling_courier( const std::vector<DeliveryInfo>&
         //We are dealing with a pickup or drop off that is NOT the first
         else{
             //Find directions from previous drop off intersection to a new closest intersection which is in pickUpDropOff vector
-            drivingPath = find_path_djikstra(prevIntersectID, pickUpDropOffLocations, turn_penalty); 
+            drivingPath = context.find_path_djikstra(prevIntersectID, pickUpDropOffLocations, turn_penalty); 
                        
-            if ( drivingPath.empty() && (find_path_djikstra_bool == false) ){
+            if ( drivingPath.empty() && !context.djikstraPathFound() ){
                 invalidPath = true;
                 break;
              }
-            //otherwise, path was legal, rest global variable
-            find_path_djikstra_bool = false;
             
             //get intersection id that was reached in djikstra
-            intersectionFound = intersectionsReached.back().first;
+            intersectionFound = context.lastTargetReached().first;
 
             //check if the node we are coming from is a pick up or drop off
             //if it is drop off, subtract total weight and clear pick up indices
@@ -234,7 +232,7 @@ std::vector<CourierSubpath> traveling_courier( const std::vector<DeliveryInfo>&
             // pUdOprev BECAUSE THEN ITS TOO LATE AND WE MIGHT SKIP THE DROP OFF EVEN IF ITS NEAR BY, WE HAVE TO ADD IT'S DROP OFF BEFORE WE LEAVE THE PICK UP
             
             //add drop off location when a package is picked up -> when pick up node is reached
-            pUdOcurrent = intersectionsReached.back().second;
+            pUdOcurrent = context.lastTargetReached().second;
             if (pUdOcurrent == "pickup"){                
                 
                 deliveryIndice = 0;
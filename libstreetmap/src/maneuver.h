@@ -0,0 +1,39 @@
+/*
+ * File:   maneuver.h
+ * Author: georg157
+ *
+ * One step of a route's directions ("Turn Left on Bay Street, in 300 m"), see path_maneuvers and maneuvers_text (m3A.h)
+ */
+
+#ifndef MANEUVER_H
+#define MANEUVER_H
+
+enum maneuverType {
+    headManeuver = 0, //first step of a path, see bearing
+    turnLeftManeuver,
+    turnRightManeuver,
+    continueStraightManeuver, //straight on, but the street changes
+    sharpLeftManeuver, //turn of more than 165 degrees (or U-turn)
+    sharpRightManeuver
+};
+
+enum compassBearing {
+    eastBearing = 0,
+    northEastBearing,
+    northBearing,
+    northWestBearing,
+    westBearing,
+    southWestBearing,
+    southBearing,
+    southEastBearing
+};
+
+struct maneuver{
+    maneuverType type;
+    compassBearing bearing; //direction headed, only used by headManeuver
+    int streetID; //street followed after the maneuver
+    double distance; //metres followed on the street before the next maneuver
+};
+
+#endif /* MANEUVER_H */
+
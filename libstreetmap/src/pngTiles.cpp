@@ -0,0 +1,156 @@
+/*
+ * File:   pngTiles.cpp
+ * Author: georg157
+ *
+ * Headless batch renderer: writes the map as PNG web map tiles (z/x/y.png), with no GTK window
+ */
+
+#include "pngTiles.h"
+#include "drawMap.h"
+#include "ezgl/canvas.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+//web map tile column of a longitude at a zoom level
+static int tileXFromLon(double lon, int zoom){
+    int tilesPerSide = 1 << zoom;
+    int x = (int) std::floor((lon + 180.0) / 360.0 * tilesPerSide);
+    return std::max(0, std::min(tilesPerSide - 1, x));
+}
+
+//web map tile row of a latitude at a zoom level (row 0 is the north edge)
+static int tileYFromLat(double lat, int zoom){
+    int tilesPerSide = 1 << zoom;
+    double latRad = lat * DEGREE_TO_RADIAN;
+    int y = (int) std::floor((1.0 - std::asinh(std::tan(latRad)) / M_PI) / 2.0 * tilesPerSide);
+    return std::max(0, std::min(tilesPerSide - 1, y));
+}
+
+static double lonFromTileX(int x, int zoom){
+    return x / (double) (1 << zoom) * 360.0 - 180.0;
+}
+
+static double latFromTileY(int y, int zoom){
+    return std::atan(std::sinh(M_PI * (1.0 - 2.0 * y / (double) (1 << zoom)))) / DEGREE_TO_RADIAN;
+}
+
+//Returns: a PNG_TILE_PIXELS square tile cut from padded (drawn with PNG_TILE_PADDING pixels around the tile on every side),
+//the tile's tileHeight rows stretched to the square (nullptr if the surface could not be made)
+static ezgl::surface* cutTile(ezgl::surface* padded, double tileHeight){
+    
+    cairo_surface_t* tile = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, PNG_TILE_PIXELS, PNG_TILE_PIXELS);
+    if (cairo_surface_status(tile) != CAIRO_STATUS_SUCCESS){
+        cairo_surface_destroy(tile);
+        return nullptr;
+    }
+    
+    cairo_t* context = cairo_create(tile);
+    cairo_scale(context, 1, PNG_TILE_PIXELS / tileHeight);
+    cairo_set_source_surface(context, padded, -PNG_TILE_PADDING, -PNG_TILE_PADDING);
+    cairo_pattern_set_filter(cairo_get_source(context), CAIRO_FILTER_BILINEAR);
+    cairo_paint(context);
+    cairo_destroy(context);
+    
+    cairo_surface_flush(tile);
+    return tile;
+}
+
+//creates a directory if it does not exist yet
+static bool makeDirectory(const std::string& path){
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+int render_png_tiles(const std::string& outputDirectory, LatLon southWest, LatLon northEast, int minZoom, int maxZoom){
+    
+    if (minZoom < 0 || maxZoom > 24 || minZoom > maxZoom || 
+        southWest.lat() > northEast.lat() || southWest.lon() > northEast.lon())
+        return -1;
+    
+    if (!makeDirectory(outputDirectory))
+        return -1;
+    
+    int totalTiles = 0;
+    auto startTotal = std::chrono::steady_clock::now();
+    
+    for (int zoom = minZoom; zoom <= maxZoom; zoom++){
+        
+        int xLow = tileXFromLon(southWest.lon(), zoom);
+        int xHigh = tileXFromLon(northEast.lon(), zoom);
+        int yLow = tileYFromLat(northEast.lat(), zoom);
+        int yHigh = tileYFromLat(southWest.lat(), zoom);
+        int numColumns = xHigh - xLow + 1;
+        int numTiles = numColumns * (yHigh - yLow + 1);
+        
+        //directories are made up front, so the threads only write files
+        std::string zoomDirectory = outputDirectory + "/" + std::to_string(zoom);
+        bool directoriesMade = makeDirectory(zoomDirectory);
+        for (int x = xLow; x <= xHigh && directoriesMade; x++){
+            directoriesMade = makeDirectory(zoomDirectory + "/" + std::to_string(x));
+        }
+        if (!directoriesMade){
+            std::cerr << "Could not create directories in " << zoomDirectory << "\n";
+            return totalTiles;
+        }
+        
+        int written = 0;
+        auto start = std::chrono::steady_clock::now();
+        
+        #pragma omp parallel for schedule(dynamic) reduction(+:written)
+        for (int tile = 0; tile < numTiles; tile++){
+            int x = xLow + tile % numColumns;
+            int y = yLow + tile / numColumns;
+            
+            //tile corners in (x,y): a tile's width is fixed by its longitudes, its height (shorter in latitude away from
+            //the equator) gives the rows it is drawn at, at the same metres per pixel
+            std::pair<double, double> xyNorthWest = latLonToCartesian(LatLon(latFromTileY(y, zoom), lonFromTileX(x, zoom)));
+            std::pair<double, double> xySouthEast = latLonToCartesian(LatLon(latFromTileY(y + 1, zoom), lonFromTileX(x + 1, zoom)));
+            double worldPerPixel = (xySouthEast.first - xyNorthWest.first) / PNG_TILE_PIXELS;
+            double tileHeight = (xyNorthWest.second - xySouthEast.second) / worldPerPixel;
+            
+            //drawn with a padding, so streets and names crossing the tile's edges are placed as in its neighbours
+            int paddedWidth = PNG_TILE_PIXELS + 2 * PNG_TILE_PADDING;
+            int paddedHeight = (int) std::ceil(tileHeight) + 2 * PNG_TILE_PADDING;
+            double padding = PNG_TILE_PADDING * worldPerPixel;
+            ezgl::rectangle world({xyNorthWest.first - padding, xyNorthWest.second + padding - paddedHeight * worldPerPixel}, 
+                                  {xySouthEast.first + padding, xyNorthWest.second + padding});
+            
+            ezgl::surface* padded = ezgl::canvas::render_offscreen(world, paddedWidth, paddedHeight, 
+                    [](ezgl::renderer *g){
+                        set_tile_scale_factor(g, PNG_TILE_SCREEN_WIDTH);
+                        draw_base_map(g);
+                        draw_map_details(g);
+                    });
+            
+            if (padded == nullptr)
+                continue;
+            
+            ezgl::surface* surface = cutTile(padded, tileHeight);
+            ezgl::renderer::free_surface(padded);
+            
+            if (surface == nullptr)
+                continue;
+            
+            std::string fileName = zoomDirectory + "/" + std::to_string(x) + "/" + std::to_string(y) + ".png";
+            if (cairo_surface_write_to_png(surface, fileName.c_str()) == CAIRO_STATUS_SUCCESS)
+                written++;
+            
+            ezgl::renderer::free_surface(surface);
+        }
+        
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "zoom " << zoom << ": " << written << " tiles in " << elapsed.count() << " s ("
+                  << written / std::max(elapsed.count(), 1e-9) << " tiles/sec)\n";
+        
+        totalTiles += written;
+    }
+    
+    std::chrono::duration<double> elapsedTotal = std::chrono::steady_clock::now() - startTotal;
+    std::cout << "total: " << totalTiles << " tiles in " << elapsedTotal.count() << " s ("
+              << totalTiles / std::max(elapsedTotal.count(), 1e-9) << " tiles/sec)\n";
+    
+    return totalTiles;
+}
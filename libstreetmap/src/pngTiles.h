@@ -0,0 +1,28 @@
+/*
+ * File:   pngTiles.h
+ * Author: georg157
+ *
+ * Headless batch renderer: writes the map as PNG web map tiles (z/x/y.png), with no GTK window
+ */
+
+#ifndef PNGTILES_H
+#define PNGTILES_H
+
+#include "LatLon.h"
+#include <string>
+
+#define PNG_TILE_PIXELS 256 //width and height of a web map tile
+#define PNG_TILE_SCREEN_WIDTH 1024 //tiles show the roads and widths a screen this wide would show at their scale
+#define PNG_TILE_PADDING 128 //pixels drawn around a tile and cut off, so names near its edges are placed and drawn whole
+
+//Renders every web map tile (Web Mercator z/x/y scheme) of zoom levels [minZoom, maxZoom] that overlaps the box
+//between southWest and northEast, into outputDirectory/z/x/y.png
+//Each tile shows exactly its Web Mercator extent: the map is drawn at the tile's own height in the app's projection,
+//then stretched to a square (exact at the tile edges, so tiles meet without gaps and line up with other web map layers)
+//Tiles are drawn on all cores, throughput (tiles/sec) is printed per zoom level and overall
+//The map must be loaded and populateDrawingData called
+//Returns: number of tiles written (-1 if the arguments are invalid)
+int render_png_tiles(const std::string& outputDirectory, LatLon southWest, LatLon northEast, int minZoom, int maxZoom);
+
+#endif /* PNGTILES_H */
+
@@ -0,0 +1,160 @@
+/*
+ * File:   poiIndex.cpp
+ * Author: georg157
+ *
+ * Spatial index (2-d tree) over points of interest
+ */
+
+#include "poiIndex.h"
+#include <algorithm>
+
+poiIndex::poiIndex() {
+}
+
+poiIndex::~poiIndex() {
+}
+
+void poiIndex::insert(int poiID, std::pair<double, double> xy){
+    points.push_back({xy.first, xy.second, poiID});
+}
+
+void poiIndex::build(){
+    buildRange(0, points.size(), 0);
+}
+
+void poiIndex::clear(){
+    points.clear();
+}
+
+unsigned poiIndex::size() const{
+    return points.size();
+}
+
+std::vector<int> poiIndex::members() const{
+    std::vector<int> poiIDs;
+    poiIDs.reserve(points.size());
+    for (unsigned i = 0; i < points.size(); i++){
+        poiIDs.push_back(points[i].poiID);
+    }
+    return poiIDs;
+}
+
+//splits on x at even depths and on y at odd depths, median becomes the root of the range
+void poiIndex::buildRange(int begin, int end, int depth){
+    if (end - begin < 2)
+        return;
+
+    int middle = begin + (end - begin) / 2;
+    bool splitOnX = (depth % 2 == 0);
+
+    std::nth_element(points.begin() + begin, points.begin() + middle, points.begin() + end,
+            [splitOnX](const kdPoint& a, const kdPoint& b){
+                return splitOnX ? (a.x < b.x) : (a.y < b.y);
+            });
+
+    buildRange(begin, middle, depth + 1);
+    buildRange(middle + 1, end, depth + 1);
+}
+
+int poiIndex::nearest(std::pair<double, double> xy) const{
+    std::vector<int> closest = kNearest(xy, 1);
+    if (closest.empty())
+        return -1;
+    return closest[0];
+}
+
+std::vector<int> poiIndex::kNearest(std::pair<double, double> xy, unsigned k) const{
+    //max-heap so the furthest of the current k candidates is always on top
+    std::vector<std::pair<double, int>> heap;
+    std::vector<int> poiIDs;
+
+    if (k == 0 || points.empty())
+        return poiIDs;
+
+    heap.reserve(k + 1);
+    searchNearest(0, points.size(), 0, xy.first, xy.second, k, heap);
+
+    std::sort_heap(heap.begin(), heap.end());
+    for (unsigned i = 0; i < heap.size(); i++){
+        poiIDs.push_back(heap[i].second);
+    }
+    return poiIDs;
+}
+
+std::vector<int> poiIndex::withinRadius(std::pair<double, double> xy, double radius) const{
+    std::vector<std::pair<double, int>> found;
+    std::vector<int> poiIDs;
+
+    if (radius < 0 || points.empty())
+        return poiIDs;
+
+    searchRadius(0, points.size(), 0, xy.first, xy.second, radius * radius, found);
+
+    std::sort(found.begin(), found.end());
+    for (unsigned i = 0; i < found.size(); i++){
+        poiIDs.push_back(found[i].second);
+    }
+    return poiIDs;
+}
+
+void poiIndex::searchNearest(int begin, int end, int depth, double x, double y, unsigned k,
+                             std::vector<std::pair<double, int>>& heap) const{
+    if (begin >= end)
+        return;
+
+    int middle = begin + (end - begin) / 2;
+    const kdPoint& root = points[middle];
+
+    double dx = root.x - x;
+    double dy = root.y - y;
+    double distanceSquared = dx * dx + dy * dy;
+
+    if (heap.size() < k){
+        heap.push_back(std::make_pair(distanceSquared, root.poiID));
+        std::push_heap(heap.begin(), heap.end());
+    }
+    else if (distanceSquared < heap.front().first){
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = std::make_pair(distanceSquared, root.poiID);
+        std::push_heap(heap.begin(), heap.end());
+    }
+
+    //distance from query to the splitting line
+    double split = (depth % 2 == 0) ? (x - root.x) : (y - root.y);
+
+    //search the side containing the query first, the other side only if it can still hold a closer point
+    if (split < 0){
+        searchNearest(begin, middle, depth + 1, x, y, k, heap);
+        if (heap.size() < k || split * split < heap.front().first)
+            searchNearest(middle + 1, end, depth + 1, x, y, k, heap);
+    }
+    else{
+        searchNearest(middle + 1, end, depth + 1, x, y, k, heap);
+        if (heap.size() < k || split * split < heap.front().first)
+            searchNearest(begin, middle, depth + 1, x, y, k, heap);
+    }
+}
+
+void poiIndex::searchRadius(int begin, int end, int depth, double x, double y, double radiusSquared,
+                            std::vector<std::pair<double, int>>& found) const{
+    if (begin >= end)
+        return;
+
+    int middle = begin + (end - begin) / 2;
+    const kdPoint& root = points[middle];
+
+    double dx = root.x - x;
+    double dy = root.y - y;
+    double distanceSquared = dx * dx + dy * dy;
+
+    if (distanceSquared <= radiusSquared)
+        found.push_back(std::make_pair(distanceSquared, root.poiID));
+
+    double split = (depth % 2 == 0) ? (x - root.x) : (y - root.y);
+
+    //lower half holds values <= root, upper half holds values >= root
+    if (split <= 0 || split * split <= radiusSquared)
+        searchRadius(begin, middle, depth + 1, x, y, radiusSquared, found);
+    if (split >= 0 || split * split <= radiusSquared)
+        searchRadius(middle + 1, end, depth + 1, x, y, radiusSquared, found);
+}
@@ -0,0 +1,64 @@
+/*
+ * File:   poiIndex.h
+ * Author: georg157
+ *
+ * Spatial index (2-d tree) over points of interest
+ * Points are stored in (x,y) metres, using the projection of populatePOIIndex()
+ */
+
+#ifndef POIINDEX_H
+#define POIINDEX_H
+
+#include <vector>
+#include <utility>
+
+class poiIndex{
+    public:
+        poiIndex();
+
+        ~poiIndex();
+
+        //adds a point of interest, build() must be called once all points are added
+        void insert(int poiID, std::pair<double, double> xy);
+
+        //arranges inserted points into a balanced 2-d tree
+        void build();
+
+        void clear();
+
+        //Returns: poiID closest to xy (-1 if index is empty)
+        int nearest(std::pair<double, double> xy) const;
+
+        //Returns: up to k poiIDs, sorted from closest to furthest
+        std::vector<int> kNearest(std::pair<double, double> xy, unsigned k) const;
+
+        //Returns: all poiIDs within radius (metres) of xy, sorted from closest to furthest
+        std::vector<int> withinRadius(std::pair<double, double> xy, double radius) const;
+
+        //Returns: all poiIDs in the index (in tree order)
+        std::vector<int> members() const;
+
+        unsigned size() const;
+
+    private:
+        struct kdPoint{
+            double x;
+            double y;
+            int poiID;
+        };
+
+        //points are ordered so that the median of every range [begin, end) is its root
+        std::vector<kdPoint> points;
+
+        void buildRange(int begin, int end, int depth);
+
+        //collects the k closest points into a max-heap of (squared distance, poiID)
+        void searchNearest(int begin, int end, int depth, double x, double y, unsigned k,
+                           std::vector<std::pair<double, int>>& heap) const;
+
+        void searchRadius(int begin, int end, int depth, double x, double y, double radiusSquared,
+                          std::vector<std::pair<double, int>>& found) const;
+};
+
+#endif /* POIINDEX_H */
+
@@ -0,0 +1,96 @@
+/*
+ * File:   polylineSimplify.cpp
+ * Author: georg157
+ *
+ * Douglas-Peucker simplification, used to precompute levels of detail for streets and features
+ */
+
+#include "polylineSimplify.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+//squared distance from p to the line segment a-b (distance to a if a and b are the same point)
+static double distanceToSegmentSquared(const ezgl::point2d& p, const ezgl::point2d& a, const ezgl::point2d& b){
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double lengthSquared = dx * dx + dy * dy;
+
+    double t = 0;
+    if (lengthSquared > 0){
+        t = ((p.x - a.x) * dx + (p.y - a.y) * dy) / lengthSquared;
+        t = std::max(0.0, std::min(1.0, t));
+    }
+
+    double closestX = a.x + t * dx - p.x;
+    double closestY = a.y + t * dy - p.y;
+    return closestX * closestX + closestY * closestY;
+}
+
+void simplifyPolyline(const ezgl::point2d* points, int numPoints, double tolerance, std::vector<ezgl::point2d>& simplified){
+    if (numPoints <= 2 || tolerance <= 0){
+        simplified.insert(simplified.end(), points, points + numPoints);
+        return;
+    }
+
+    double toleranceSquared = tolerance * tolerance;
+    std::vector<bool> keep(numPoints, false);
+    keep[0] = true;
+    keep[numPoints - 1] = true;
+
+    //ranges (first, last) still to be checked, instead of recursion
+    std::vector<std::pair<int, int>> ranges;
+    ranges.push_back(std::make_pair(0, numPoints - 1));
+
+    while (!ranges.empty()){
+        int first = ranges.back().first;
+        int last = ranges.back().second;
+        ranges.pop_back();
+
+        //find the point furthest from the line first-last
+        double maxDistance = -1;
+        int furthest = -1;
+        for (int i = first + 1; i < last; i++){
+            double distance = distanceToSegmentSquared(points[i], points[first], points[last]);
+            if (distance > maxDistance){
+                maxDistance = distance;
+                furthest = i;
+            }
+        }
+
+        //keep it and split there if it is outside the tolerance
+        if (furthest != -1 && maxDistance > toleranceSquared){
+            keep[furthest] = true;
+            ranges.push_back(std::make_pair(first, furthest));
+            ranges.push_back(std::make_pair(furthest, last));
+        }
+    }
+
+    for (int i = 0; i < numPoints; i++){
+        if (keep[i])
+            simplified.push_back(points[i]);
+    }
+}
+
+std::vector<ezgl::point2d> simplifyPolygon(const std::vector<ezgl::point2d>& ring, double tolerance){
+    if (ring.size() <= 3 || tolerance <= 0)
+        return ring;
+
+    //close the ring so the first point is both ends of the polyline, then drop the closing point again
+    std::vector<ezgl::point2d> closedRing(ring);
+    closedRing.push_back(ring[0]);
+
+    std::vector<ezgl::point2d> simplified;
+    simplifyPolyline(closedRing.data(), closedRing.size(), tolerance, simplified);
+    simplified.pop_back();
+
+    //ring is smaller than the tolerance, a triangle of evenly spaced points is enough
+    if (simplified.size() < 3){
+        simplified.clear();
+        simplified.push_back(ring[0]);
+        simplified.push_back(ring[ring.size() / 3]);
+        simplified.push_back(ring[2 * ring.size() / 3]);
+    }
+
+    return simplified;
+}
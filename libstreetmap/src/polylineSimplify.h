@@ -0,0 +1,23 @@
+/*
+ * File:   polylineSimplify.h
+ * Author: georg157
+ *
+ * Douglas-Peucker simplification, used to precompute levels of detail for streets and features
+ */
+
+#ifndef POLYLINESIMPLIFY_H
+#define POLYLINESIMPLIFY_H
+
+#include "ezgl/point.hpp"
+#include <vector>
+
+//Appends to simplified the points of [points, points + numPoints) that are kept when no removed point
+//is further than tolerance from the simplified line. First and last points are always kept.
+void simplifyPolyline(const ezgl::point2d* points, int numPoints, double tolerance, std::vector<ezgl::point2d>& simplified);
+
+//Same as simplifyPolyline, for a closed ring stored without its closing point
+//Always keeps at least 3 points (a ring smaller than the tolerance becomes a triangle)
+std::vector<ezgl::point2d> simplifyPolygon(const std::vector<ezgl::point2d>& ring, double tolerance);
+
+#endif /* POLYLINESIMPLIFY_H */
+
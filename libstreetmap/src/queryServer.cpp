@@ -0,0 +1,614 @@
+/*
+ * File:   queryServer.cpp
+ * Author: georg157
+ *
+ * Headless query server: answers line-delimited routing requests with a pool of worker threads
+ */
+
+#include "queryServer.h"
+#include "m1.h"
+#include "m3.h"
+#include "m3A.h"
+#include "m4.h"
+#include "courierFleet.h"
+#include "StreetsDatabaseAPI.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//Returns: path as comma separated segment IDs, "-" if empty
+static std::string path_text(const std::vector<int>& path){
+    if (path.empty())
+        return "-";
+
+    std::ostringstream text;
+    for (unsigned i = 0; i < path.size(); i++){
+        if (i > 0)
+            text << ',';
+        text << path[i];
+    }
+    return text.str();
+}
+
+static bool valid_intersection(int intersectionID){
+    return intersectionID >= 0 && intersectionID < getNumIntersections();
+}
+
+//Splits text on separator (empty pieces are dropped)
+static std::vector<std::string> split_text(const std::string& text, char separator){
+    std::vector<std::string> pieces;
+    std::istringstream stream(text);
+    std::string piece;
+    while (std::getline(stream, piece, separator)){
+        if (!piece.empty())
+            pieces.push_back(piece);
+    }
+    return pieces;
+}
+
+//Parses "<depot,...>" and "<pickup:dropoff:weight,...>" of the courier commands
+//Returns: false (with the error in result) if an intersection is invalid, or there is no depot or no delivery
+static bool parse_courier_input(const std::string& depotsText, const std::string& deliveriesText,
+                                std::vector<int>& depots, std::vector<DeliveryInfo>& deliveries, std::string& result){
+    std::vector<std::string> depotPieces = split_text(depotsText, ',');
+    for (unsigned i = 0; i < depotPieces.size(); i++){
+        depots.push_back(std::atoi(depotPieces[i].c_str()));
+        if (!valid_intersection(depots.back())){
+            result = "invalid depot " + depotPieces[i];
+            return false;
+        }
+    }
+
+    std::vector<std::string> deliveryPieces = split_text(deliveriesText, ',');
+    for (unsigned i = 0; i < deliveryPieces.size(); i++){
+        std::vector<std::string> fields = split_text(deliveryPieces[i], ':');
+        if (fields.size() != 3){
+            result = "invalid delivery " + deliveryPieces[i];
+            return false;
+        }
+        deliveries.push_back(DeliveryInfo(std::atoi(fields[0].c_str()), std::atoi(fields[1].c_str()), std::atof(fields[2].c_str())));
+        if (!valid_intersection(deliveries.back().pickUp) || !valid_intersection(deliveries.back().dropOff)){
+            result = "invalid delivery " + deliveryPieces[i];
+            return false;
+        }
+    }
+
+    if (depots.empty() || deliveries.empty()){
+        result = "courier needs at least one depot and one delivery";
+        return false;
+    }
+    return true;
+}
+
+queryServer::queryConnection::queryConnection(int fd, bool owns) {
+    outFd = fd;
+    ownsFd = owns;
+    inFlight = 0;
+}
+
+queryServer::queryConnection::~queryConnection() {
+    if (ownsFd)
+        close(outFd);
+}
+
+queryServer::queryServer(unsigned numThreads) : quitRequested(false) {
+    stopping = false;
+    listenFd = -1;
+
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::min(numThreads, (unsigned) MAX_QUERY_THREADS);
+
+    for (unsigned i = 0; i < numThreads; i++){
+        workers.push_back(std::thread(&queryServer::workerLoop, this));
+    }
+}
+
+queryServer::~queryServer() {
+    stopWorkers();
+}
+
+void queryServer::stopWorkers(){
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        jobs.clear();
+    }
+    jobQueued.notify_all();
+    jobTaken.notify_all();
+
+    for (unsigned i = 0; i < workers.size(); i++){
+        if (workers[i].joinable())
+            workers[i].join();
+    }
+    workers.clear();
+}
+
+void queryServer::serveStream(int inFd, int outFd){
+    //a reader that goes away must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::shared_ptr<queryConnection> connection = std::make_shared<queryConnection>(outFd, false);
+    readRequests(inFd, connection);
+}
+
+bool queryServer::serveSocket(const std::string& socketPath){
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)){
+        std::cerr << "Socket path too long: " << socketPath << "\n";
+        return false;
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0){
+        std::cerr << "Could not create socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    unlink(socketPath.c_str());
+    if (bind(listenFd, (sockaddr*) &address, sizeof(address)) < 0 || listen(listenFd, QUERY_SOCKET_BACKLOG) < 0){
+        std::cerr << "Could not listen on " << socketPath << ": " << std::strerror(errno) << "\n";
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    std::cerr << "Listening on " << socketPath << " with " << workers.size() << " worker threads\n";
+
+    while (!quitRequested){
+        int clientFd = accept(listenFd, nullptr, nullptr);
+        if (clientFd < 0){
+            if (errno == EINTR)
+                continue;
+            break; //listening socket shut down by quit
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            clientFds.insert(clientFd);
+        }
+
+        //detached, so a server running for days keeps no thread per client gone (clientFds counts the readers left)
+        std::thread([this, clientFd]{
+            //the connection closes clientFd once its last response is written
+            std::shared_ptr<queryConnection> connection = std::make_shared<queryConnection>(clientFd, true);
+
+            if (readRequests(clientFd, connection)){
+                quitRequested = true;
+
+                //wakes accept and every other client's read
+                std::lock_guard<std::mutex> guard(lock);
+                shutdown(listenFd, SHUT_RDWR);
+                for (std::set<int>::iterator it = clientFds.begin(); it != clientFds.end(); ++it){
+                    shutdown(*it, SHUT_RD);
+                }
+            }
+
+            std::lock_guard<std::mutex> guard(lock);
+            clientFds.erase(clientFd);
+            clientLeft.notify_all();
+        }).detach();
+    }
+
+    //every reader is done with this server before it returns
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        clientLeft.wait(guard, [this]{ return clientFds.empty(); });
+    }
+
+    close(listenFd);
+    listenFd = -1;
+    unlink(socketPath.c_str());
+    return true;
+}
+
+bool queryServer::readRequests(int inFd, std::shared_ptr<queryConnection> connection){
+    std::string buffer;
+    char chunk[65536];
+    bool quit = false;
+
+    //true while the rest of a line longer than MAX_QUERY_LINE is dropped (up to its '\n')
+    bool discarding = false;
+
+    while (!quit){
+        ssize_t numRead = read(inFd, chunk, sizeof(chunk));
+        if (numRead < 0 && errno == EINTR)
+            continue;
+        if (numRead <= 0)
+            break;
+        buffer.append(chunk, numRead);
+
+        if (discarding){
+            std::string::size_type lineEnd = buffer.find('\n');
+            if (lineEnd == std::string::npos){
+                buffer.clear();
+                continue;
+            }
+            buffer.erase(0, lineEnd + 1);
+            discarding = false;
+        }
+
+        //queue every complete line, the received time is taken as soon as the line is read
+        std::string::size_type lineStart = 0, lineEnd;
+        while (!quit && (lineEnd = buffer.find('\n', lineStart)) != std::string::npos){
+            std::string line = buffer.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 1;
+
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.find_first_not_of(" \t") == std::string::npos)
+                continue;
+
+            std::istringstream words(line);
+            std::string id, command;
+            words >> id >> command;
+            if (command == "quit" || (command.empty() && id == "quit")){
+                quit = true;
+                break;
+            }
+
+            submit({line, std::chrono::steady_clock::now(), connection});
+        }
+        buffer.erase(0, lineStart);
+
+        if (buffer.size() > MAX_QUERY_LINE){
+            respond(*connection, "- error 0 request longer than " + std::to_string(MAX_QUERY_LINE) + " bytes\n");
+            buffer.clear();
+            discarding = true;
+        }
+    }
+
+    //every request read is answered before the reader returns
+    std::unique_lock<std::mutex> guard(connection->writeLock);
+    connection->idle.wait(guard, [&connection]{ return connection->inFlight == 0; });
+
+    return quit;
+}
+
+void queryServer::submit(queryJob job){
+    {
+        std::lock_guard<std::mutex> guard(job.connection->writeLock);
+        job.connection->inFlight++;
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    jobTaken.wait(guard, [this]{ return stopping || jobs.size() < QUERY_QUEUE_LIMIT; });
+    if (stopping){
+        guard.unlock();
+        std::lock_guard<std::mutex> connectionGuard(job.connection->writeLock);
+        job.connection->inFlight--;
+        job.connection->idle.notify_all();
+        return;
+    }
+
+    jobs.push_back(std::move(job));
+    jobQueued.notify_one();
+}
+
+void queryServer::workerLoop(){
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (true){
+        jobQueued.wait(guard, [this]{ return stopping || !jobs.empty(); });
+        if (stopping)
+            return;
+
+        queryJob job = std::move(jobs.front());
+        jobs.pop_front();
+        jobTaken.notify_one();
+
+        //answering happens outside the lock, so the other workers answer at the same time
+        guard.unlock();
+
+        std::istringstream words(job.line);
+        std::string id, command, result;
+        words >> id >> command;
+        bool valid = answer(command, words, result);
+
+        long latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - job.received).count();
+        respond(*job.connection, id + (valid ? " ok " : " error ") + std::to_string(latency) + " " + result + "\n");
+
+        {
+            std::lock_guard<std::mutex> connectionGuard(job.connection->writeLock);
+            job.connection->inFlight--;
+            job.connection->idle.notify_all();
+        }
+        job.connection.reset();
+
+        guard.lock();
+    }
+}
+
+void queryServer::respond(queryConnection& connection, const std::string& response){
+    std::lock_guard<std::mutex> guard(connection.writeLock);
+
+    std::string::size_type written = 0;
+    while (written < response.size()){
+        ssize_t numWritten = write(connection.outFd, response.data() + written, response.size() - written);
+        if (numWritten < 0 && errno == EINTR)
+            continue;
+        if (numWritten <= 0)
+            return; //reader went away, the response is dropped
+        written += numWritten;
+    }
+}
+
+bool queryServer::answer(const std::string& command, std::istringstream& arguments, std::string& result){
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(3);
+
+    if (command == "route"){
+        int start, end;
+        double turnPenalty;
+        if (!(arguments >> start >> end >> turnPenalty) || !valid_intersection(start) || !valid_intersection(end)){
+            result = "usage: route <start> <end> <turn_penalty>";
+            return false;
+        }
+
+        //repeated routes are answered from RouteCache
+        double travelTime;
+        std::vector<StreetSegmentIndex> path = find_path_and_travel_time(start, end, turnPenalty, travelTime);
+        if (path.empty() && start != end){
+            result = "no path";
+            return false;
+        }
+
+        text << travelTime << " " << path_text(path);
+    }
+    else if (command == "routeat"){
+        int start, end;
+        double turnPenalty, departureTime;
+        if (!(arguments >> start >> end >> turnPenalty >> departureTime) || !valid_intersection(start) || !valid_intersection(end)){
+            result = "usage: routeat <start> <end> <turn_penalty> <departure_s>";
+            return false;
+        }
+
+        //times depend on the departure, so these are never cached
+        double travelTime;
+        std::vector<StreetSegmentIndex> path = find_path_at_departure_time(start, end, turnPenalty, departureTime, travelTime);
+        if (path.empty() && start != end){
+            result = "no path";
+            return false;
+        }
+
+        text << travelTime << " " << path_text(path);
+    }
+    else if (command == "routelive"){
+        int start, end;
+        if (!(arguments >> start >> end) || !valid_intersection(start) || !valid_intersection(end)){
+            result = "usage: routelive <start> <end>";
+            return false;
+        }
+
+        double travelTime;
+        std::vector<StreetSegmentIndex> path = TrafficRouter.findPath(start, end, travelTime);
+        if (path.empty() && start != end){
+            result = "no path";
+            return false;
+        }
+
+        text << travelTime << " " << path_text(path);
+    }
+    else if (command == "traffic"){
+        std::string updatesText;
+        if (!(arguments >> updatesText)){
+            result = "usage: traffic <segment:seconds,...>";
+            return false;
+        }
+
+        std::vector<std::pair<int, double>> updates;
+        std::vector<std::string> updatePieces = split_text(updatesText, ',');
+        for (unsigned i = 0; i < updatePieces.size(); i++){
+            std::vector<std::string> fields = split_text(updatePieces[i], ':');
+            if (fields.size() != 2){
+                result = "invalid update " + updatePieces[i];
+                return false;
+            }
+            updates.push_back(std::make_pair(std::atoi(fields[0].c_str()), std::atof(fields[1].c_str())));
+        }
+
+        //applied, then the version of the travel times now used
+        unsigned applied = TrafficRouter.updateTravelTimes(updates);
+        text << applied << " " << TrafficRouter.snapshot()->version;
+    }
+    else if (command == "routeavoid"){
+        int start, end;
+        double turnPenalty;
+        std::string segmentsText;
+        if (!(arguments >> start >> end >> turnPenalty >> segmentsText) || !valid_intersection(start) || !valid_intersection(end)){
+            result = "usage: routeavoid <start> <end> <turn_penalty> <segment,...>";
+            return false;
+        }
+
+        std::vector<int> closedSegments;
+        std::vector<std::string> segmentPieces = split_text(segmentsText, ',');
+        for (unsigned i = 0; i < segmentPieces.size(); i++){
+            closedSegments.push_back(std::atoi(segmentPieces[i].c_str()));
+        }
+
+        double travelTime;
+        std::vector<StreetSegmentIndex> path = find_path_avoiding(start, end, turnPenalty, closedSegments, travelTime);
+        if (path.empty() && start != end){
+            result = "no path";
+            return false;
+        }
+
+        text << travelTime << " " << path_text(path);
+    }
+    else if (command == "block" || command == "unblock"){
+        std::string segmentsText;
+        if (!(arguments >> segmentsText)){
+            result = "usage: " + command + " <segment,...>";
+            return false;
+        }
+
+        if (command == "unblock" && segmentsText == "all"){
+            SegmentClosures.clear();
+        }
+        else{
+            std::vector<int> segmentIDs;
+            std::vector<std::string> segmentPieces = split_text(segmentsText, ',');
+            for (unsigned i = 0; i < segmentPieces.size(); i++){
+                segmentIDs.push_back(std::atoi(segmentPieces[i].c_str()));
+            }
+
+            if (command == "block")
+                SegmentClosures.block(segmentIDs);
+            else
+                SegmentClosures.unblock(segmentIDs);
+        }
+
+        //segments now closed
+        std::shared_ptr<const blockedSegments> closed = SegmentClosures.snapshot();
+        text << (closed ? closed->size() : 0);
+    }
+    else if (command == "alternatives"){
+        int start, end;
+        double turnPenalty;
+        unsigned k;
+        if (!(arguments >> start >> end >> turnPenalty >> k) || !valid_intersection(start) || !valid_intersection(end) || k == 0){
+            result = "usage: alternatives <start> <end> <turn_penalty> <k>";
+            return false;
+        }
+
+        std::vector<alternativePath> alternatives = find_alternative_paths(start, end, turnPenalty, k);
+        if (alternatives.empty()){
+            result = "no path";
+            return false;
+        }
+
+        //number of paths, then time and path of each, fastest first
+        text << alternatives.size();
+        for (unsigned i = 0; i < alternatives.size(); i++){
+            text << " " << alternatives[i].travelTime << " " << path_text(alternatives[i].path);
+        }
+    }
+    else if (command == "walk"){
+        int start, end;
+        double turnPenalty, walkingSpeed, walkingTimeLimit;
+        if (!(arguments >> start >> end >> turnPenalty >> walkingSpeed >> walkingTimeLimit) ||
+            !valid_intersection(start) || !valid_intersection(end) || walkingSpeed <= 0){
+            result = "usage: walk <start> <end> <turn_penalty> <walking_speed> <walking_time_limit>";
+            return false;
+        }
+
+        std::pair<std::vector<StreetSegmentIndex>, std::vector<StreetSegmentIndex>> paths = find_path_with_walk_to_pick_up(
+                start, end, turnPenalty, walkingSpeed, walkingTimeLimit);
+        if (paths.first.empty() && paths.second.empty() && start != end){
+            result = "no path";
+            return false;
+        }
+
+        text << compute_path_walking_time(paths.first, walkingSpeed, turnPenalty) << " "
+             << compute_path_travel_time(paths.second, turnPenalty) << " "
+             << path_text(paths.first) << " " << path_text(paths.second);
+    }
+    else if (command == "closest"){
+        double lat, lon;
+        if (!(arguments >> lat >> lon)){
+            result = "usage: closest <lat> <lon>";
+            return false;
+        }
+
+        text << find_closest_intersection(LatLon(lat, lon));
+    }
+    else if (command == "streets"){
+        std::string prefix;
+        std::getline(arguments, prefix);
+        prefix.erase(0, std::min(prefix.size(), prefix.find_first_not_of(" \t")));
+        if (prefix.empty()){
+            result = "usage: streets <prefix>";
+            return false;
+        }
+
+        text << path_text(find_street_ids_from_partial_street_name(prefix));
+    }
+    else if (command == "courier"){
+        double turnPenalty, truckCapacity;
+        std::string depotsText, deliveriesText;
+        if (!(arguments >> turnPenalty >> truckCapacity >> depotsText >> deliveriesText)){
+            result = "usage: courier <turn_penalty> <truck_capacity> <depot,...> <pickup:dropoff:weight,...>";
+            return false;
+        }
+
+        std::vector<int> depots;
+        std::vector<DeliveryInfo> deliveries;
+        if (!parse_courier_input(depotsText, deliveriesText, depots, deliveries, result))
+            return false;
+
+        std::vector<CourierSubpath> route = traveling_courier(deliveries, depots, turnPenalty, truckCapacity);
+        if (route.empty()){
+            result = "no route";
+            return false;
+        }
+
+        //total time, then start>end:path of each subpath
+        text << compute_courier_route_travel_time(route, turnPenalty);
+        for (unsigned i = 0; i < route.size(); i++){
+            text << " " << route[i].start_intersection << ">" << route[i].end_intersection << ":" << path_text(route[i].subpath);
+        }
+    }
+    else if (command == "fleet"){
+        double turnPenalty, truckCapacity;
+        unsigned numTrucks;
+        std::string objectiveText, depotsText, deliveriesText;
+        if (!(arguments >> turnPenalty >> truckCapacity >> numTrucks >> objectiveText >> depotsText >> deliveriesText) ||
+            numTrucks == 0 || (objectiveText != "total" && objectiveText != "makespan")){
+            result = "usage: fleet <turn_penalty> <truck_capacity> <trucks> <total|makespan> <depot,...> <pickup:dropoff:weight,...>";
+            return false;
+        }
+
+        std::vector<int> depots;
+        std::vector<DeliveryInfo> deliveries;
+        if (!parse_courier_input(depotsText, deliveriesText, depots, deliveries, result))
+            return false;
+
+        std::vector<std::vector<CourierSubpath>> routes = traveling_courier_fleet(deliveries, depots, numTrucks, turnPenalty, truckCapacity,
+                                                                                  objectiveText == "makespan" ? makespanObjective : totalTimeObjective);
+        if (routes.empty()){
+            result = "no route";
+            return false;
+        }
+
+        //total time and makespan, then per truck: "|", its time, and start>end:path of each subpath
+        std::vector<double> truckTimes(routes.size());
+        double totalTime = 0, makespan = 0;
+        for (unsigned truck = 0; truck < routes.size(); truck++){
+            truckTimes[truck] = compute_courier_route_travel_time(routes[truck], turnPenalty);
+            totalTime += truckTimes[truck];
+            makespan = std::max(makespan, truckTimes[truck]);
+        }
+
+        text << totalTime << " " << makespan;
+        for (unsigned truck = 0; truck < routes.size(); truck++){
+            text << " | " << truckTimes[truck];
+            for (unsigned i = 0; i < routes[truck].size(); i++){
+                text << " " << routes[truck][i].start_intersection << ">" << routes[truck][i].end_intersection << ":" << path_text(routes[truck][i].subpath);
+            }
+        }
+    }
+    else if (command == "stats"){
+        routeCacheStats cache = RouteCache.stats();
+        text << "route_cache hits " << cache.hits << " misses " << cache.misses
+             << " entries " << cache.entries;
+    }
+    else{
+        result = "unknown command '" + command + "'";
+        return false;
+    }
+
+    result = text.str();
+    return true;
+}
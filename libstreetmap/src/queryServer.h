@@ -0,0 +1,130 @@
+/*
+ * File:   queryServer.h
+ * Author: georg157
+ *
+ * Headless query server: answers line-delimited routing requests against the map loaded once by load_map
+ * Requests come from a stream (stdin) or the clients of a Unix domain socket, and are answered by a pool of
+ * worker threads, so a client can pipeline requests (responses come back as they finish, tagged with the request ID)
+ *
+ * Request:  <id> <command> <arguments>
+ *   route <start> <end> <turn_penalty>                                        driving path (m3)
+ *   routeat <start> <end> <turn_penalty> <departure_s>                        driving path leaving at a time of day (speed profiles)
+ *   routelive <start> <end>                                                   driving path on live traffic times (no turn penalty)
+ *   traffic <segment:seconds,...>                                             replaces live traffic times of segments
+ *   routeavoid <start> <end> <turn_penalty> <segment,...>                     driving path that also avoids the segments given
+ *   block <segment,...> / unblock <segment,...> / unblock all                 closes or reopens segments for every query
+ *   alternatives <start> <end> <turn_penalty> <k>                             fastest path and up to k - 1 alternatives
+ *   walk <start> <end> <turn_penalty> <walking_speed> <walking_time_limit>   walk to pick up, then drive (m3)
+ *   closest <lat> <lon>                                                       closest intersection (m1)
+ *   streets <prefix>                                                          street IDs by name prefix (m1)
+ *   courier <turn_penalty> <truck_capacity> <depot,...> <pickup:dropoff:weight,...>   courier route (m4)
+ *   fleet <turn_penalty> <truck_capacity> <trucks> <total|makespan> <depot,...> <pickup:dropoff:weight,...>
+ *                                                                             routes of several trucks (courierFleet.h)
+ *   stats                                                                     route cache hit and miss counters
+ *   quit                                                                      stops reading (and the server, on a socket)
+ * Response: <id> ok <latency_us> <result>   or   <id> error <latency_us> <message>
+ *   latency_us: microseconds from reading the request to answering it (time queued included)
+ *   paths are comma separated segment IDs, "-" when empty
+ */
+
+#ifndef QUERYSERVER_H
+#define QUERYSERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define QUERY_QUEUE_LIMIT 4096 //requests queued before readers wait for the workers (back pressure)
+#define MAX_QUERY_LINE 1048576 //longest request accepted, bytes
+#define QUERY_SOCKET_BACKLOG 16 //clients waiting to be accepted
+#define MAX_QUERY_THREADS 256 //worker threads at most
+
+class queryServer{
+    public:
+        //numThreads: worker threads answering requests (0: one per core, at most MAX_QUERY_THREADS)
+        queryServer(unsigned numThreads = 0);
+
+        //stops the workers (requests still queued are dropped)
+        ~queryServer();
+
+        //Answers the requests read from inFd on outFd, until end of input or "quit"
+        //Returns once every request read has been answered
+        void serveStream(int inFd, int outFd);
+
+        //Listens on a Unix domain socket at socketPath (replacing a stale socket file), each client is read on its own thread
+        //Runs until a client sends "quit"
+        //Returns: false if the socket could not be created
+        bool serveSocket(const std::string& socketPath);
+
+    private:
+        //where a client's responses are written, shared by the requests in flight
+        struct queryConnection{
+            int outFd;
+            bool ownsFd; //close outFd once the last request is answered
+            std::mutex writeLock;
+
+            //requests read but not yet answered
+            unsigned inFlight;
+            std::condition_variable idle;
+
+            queryConnection(int fd, bool owns);
+            ~queryConnection();
+        };
+
+        struct queryJob{
+            std::string line;
+            std::chrono::steady_clock::time_point received;
+            std::shared_ptr<queryConnection> connection;
+        };
+
+        //Reads lines from inFd and queues them until end of input or "quit"
+        //Returns: true if "quit" was read
+        bool readRequests(int inFd, std::shared_ptr<queryConnection> connection);
+
+        //Queues a request (waits while QUERY_QUEUE_LIMIT requests are queued)
+        void submit(queryJob job);
+
+        //Computes the result of one request
+        //Returns: false if the request is invalid (result is then the error message)
+        bool answer(const std::string& command, std::istringstream& arguments, std::string& result);
+
+        //Writes one whole response line (responses of the workers never interleave)
+        void respond(queryConnection& connection, const std::string& response);
+
+        void workerLoop();
+
+        void stopWorkers();
+
+        std::vector<std::thread> workers;
+
+        std::mutex lock;
+
+        //signalled when a request is queued or the workers must stop
+        std::condition_variable jobQueued;
+
+        //signalled when a request is taken off the queue
+        std::condition_variable jobTaken;
+
+        std::deque<queryJob> jobs;
+
+        bool stopping;
+
+        //socket mode: set by "quit", the listening socket and the clients connected (shut down on quit)
+        std::atomic<bool> quitRequested;
+        int listenFd;
+        std::set<int> clientFds;
+
+        //signalled when a client's reader is done (its fd is off clientFds)
+        std::condition_variable clientLeft;
+};
+
+#endif /* QUERYSERVER_H */
+
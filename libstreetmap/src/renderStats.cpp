@@ -0,0 +1,187 @@
+/*
+ * File:   renderStats.cpp
+ * Author: georg157
+ *
+ * Render instrumentation: time and primitives drawn per map layer, and a rolling histogram of frame times
+ */
+
+#include "renderStats.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+//names shown in the overlay and the dump, in renderLayer order
+const char* const RenderLayerNames[NUM_RENDER_LAYERS] = {"features (tile)", "streets (tile)", "intersections",
+                                                         "street names", "feature names", "POIs", "label placement", "path overlay"};
+
+//upper limit (ms) of each histogram bucket, the last one takes every slower frame
+const double FrameBucketLimits[NUM_FRAME_BUCKETS] = {4, 8, 16, 33, 50, 100, 250, 1e300};
+const char* const FrameBucketNames[NUM_FRAME_BUCKETS] = {"<4", "<8", "<16", "<33", "<50", "<100", "<250", "250+"};
+
+#define OVERLAY_MARGIN 10 //pixels between the overlay and the screen edges
+#define OVERLAY_LINE_HEIGHT 14 //pixels per line of text
+#define OVERLAY_BAR_WIDTH 30 //pixels per histogram bar
+#define OVERLAY_BAR_HEIGHT 50 //pixels of the tallest histogram bar
+
+renderStats::renderStats() {
+    reset();
+}
+
+renderStats::~renderStats() {
+}
+
+void renderStats::record(renderLayer layer, std::chrono::steady_clock::time_point start, int primitives){
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::lock_guard<std::mutex> guard(lock);
+    layerStats& stats = layers[layer];
+    stats.runs++;
+    stats.totalSeconds += elapsed.count();
+    stats.lastSeconds = elapsed.count();
+    stats.maxSeconds = std::max(stats.maxSeconds, elapsed.count());
+    stats.totalPrimitives += primitives;
+    stats.lastPrimitives = primitives;
+}
+
+void renderStats::recordFrame(std::chrono::steady_clock::time_point start){
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (frameTimes.size() < FRAME_HISTORY)
+        frameTimes.push_back(elapsed.count());
+    else
+        frameTimes[numFrames % FRAME_HISTORY] = elapsed.count();
+    numFrames++;
+}
+
+void renderStats::reset(){
+    std::lock_guard<std::mutex> guard(lock);
+    for (int layer = 0; layer < NUM_RENDER_LAYERS; layer++){
+        layers[layer] = {0, 0, 0, 0, 0, 0};
+    }
+    frameTimes.clear();
+    numFrames = 0;
+}
+
+std::vector<std::string> renderStats::report(){
+    std::vector<std::string> lines;
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(2);
+
+    line << std::left << std::setw(16) << "layer" << std::right << std::setw(9) << "last ms" << std::setw(9) << "avg ms"
+         << std::setw(9) << "max ms" << std::setw(9) << "drawn" << std::setw(8) << "runs";
+    lines.push_back(line.str());
+
+    for (int layer = 0; layer < NUM_RENDER_LAYERS; layer++){
+        const layerStats& stats = layers[layer];
+        double average = (stats.runs == 0) ? 0 : stats.totalSeconds / stats.runs;
+
+        line.str("");
+        line << std::left << std::setw(16) << RenderLayerNames[layer] << std::right
+             << std::setw(9) << stats.lastSeconds * 1000 << std::setw(9) << average * 1000
+             << std::setw(9) << stats.maxSeconds * 1000 << std::setw(9) << stats.lastPrimitives << std::setw(8) << stats.runs;
+        lines.push_back(line.str());
+    }
+
+    //median and 95th percentile of the recent frames
+    std::vector<double> sorted(frameTimes);
+    std::sort(sorted.begin(), sorted.end());
+    double last = frameTimes.empty() ? 0 : frameTimes[(numFrames - 1) % FRAME_HISTORY];
+    double median = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+    double slow = sorted.empty() ? 0 : sorted[(sorted.size() * 95) / 100];
+
+    line.str("");
+    line << "frame: last " << last * 1000 << " ms, p50 " << median * 1000 << " ms, p95 " << slow * 1000
+         << " ms (" << frameTimes.size() << " of " << numFrames << " frames)";
+    lines.push_back(line.str());
+
+    return lines;
+}
+
+std::vector<int> renderStats::histogram() const{
+    std::vector<int> counts(NUM_FRAME_BUCKETS, 0);
+    for (unsigned i = 0; i < frameTimes.size(); i++){
+        int bucket = 0;
+        while (frameTimes[i] * 1000 >= FrameBucketLimits[bucket])
+            bucket++;
+        counts[bucket]++;
+    }
+    return counts;
+}
+
+void renderStats::drawOverlay(ezgl::renderer* g){
+    std::vector<std::string> lines;
+    std::vector<int> counts;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        lines = report();
+        counts = histogram();
+    }
+
+    g->set_coordinate_system(ezgl::SCREEN);
+    g->format_font("monospace", ezgl::font_slant::normal, ezgl::font_weight::normal, 11);
+    g->set_text_rotation(0);
+
+    double width = NUM_FRAME_BUCKETS * OVERLAY_BAR_WIDTH;
+    for (unsigned i = 0; i < lines.size(); i++){
+        width = std::max(width, g->get_text_size(lines[i]).x);
+    }
+    double textHeight = lines.size() * OVERLAY_LINE_HEIGHT;
+    double height = textHeight + OVERLAY_BAR_HEIGHT + 2 * OVERLAY_LINE_HEIGHT;
+
+    g->set_color(0, 0, 0, 190);
+    g->fill_rectangle({OVERLAY_MARGIN, OVERLAY_MARGIN}, width + OVERLAY_MARGIN, height + OVERLAY_MARGIN);
+
+    //draw_text centres the text, so each line is moved right by half its width
+    double left = 1.5 * OVERLAY_MARGIN;
+    double y = 1.5 * OVERLAY_MARGIN + OVERLAY_LINE_HEIGHT / 2;
+    g->set_color(255, 255, 255, 255);
+    for (unsigned i = 0; i < lines.size(); i++){
+        g->draw_text({left + g->get_text_size(lines[i]).x / 2, y}, lines[i]);
+        y += OVERLAY_LINE_HEIGHT;
+    }
+
+    //frame time histogram, bars scaled to the fullest bucket
+    int fullest = std::max(1, *std::max_element(counts.begin(), counts.end()));
+    double barsBottom = y + OVERLAY_BAR_HEIGHT;
+    for (int bucket = 0; bucket < NUM_FRAME_BUCKETS; bucket++){
+        double barLeft = left + bucket * OVERLAY_BAR_WIDTH;
+        double barHeight = (double) OVERLAY_BAR_HEIGHT * counts[bucket] / fullest;
+
+        //frames slower than 33 ms (under 30 frames per second) are drawn red
+        g->set_color(FrameBucketLimits[bucket] <= 33 ? ezgl::color(80, 200, 120, 255) : ezgl::color(230, 80, 80, 255));
+        g->fill_rectangle({barLeft + 2, barsBottom - barHeight}, {barLeft + OVERLAY_BAR_WIDTH - 2, barsBottom});
+
+        g->set_color(255, 255, 255, 255);
+        g->draw_text({barLeft + OVERLAY_BAR_WIDTH / 2, barsBottom + OVERLAY_LINE_HEIGHT / 2 + 2}, FrameBucketNames[bucket]);
+    }
+
+    g->set_coordinate_system(ezgl::WORLD);
+}
+
+bool renderStats::dump(const std::string& fileName, const std::string& title){
+    std::vector<std::string> lines;
+    std::vector<int> counts;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        lines = report();
+        counts = histogram();
+    }
+
+    std::ofstream file(fileName, std::ios::app);
+    if (!file)
+        return false;
+
+    file << "=== " << title << " ===\n";
+    for (unsigned i = 0; i < lines.size(); i++){
+        file << lines[i] << "\n";
+    }
+    file << "frame time histogram (ms: frames)\n";
+    for (int bucket = 0; bucket < NUM_FRAME_BUCKETS; bucket++){
+        file << "  " << std::setw(5) << FrameBucketNames[bucket] << ": " << counts[bucket] << "\n";
+    }
+    file << "\n";
+
+    return (bool) file;
+}
@@ -0,0 +1,86 @@
+/*
+ * File:   renderStats.h
+ * Author: georg157
+ *
+ * Render instrumentation: time and primitives drawn per map layer, and a rolling histogram of frame times
+ * Shown as an overlay on the canvas and dumped to a file to compare maps and catch render regressions
+ */
+
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include "ezgl/graphics.hpp"
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define FRAME_HISTORY 240 //frames kept for the frame time histogram
+#define NUM_FRAME_BUCKETS 8 //bars of the histogram, see FrameBucketLimits
+
+//layers drawn by draw_main_canvas (features and streets are drawn per map tile, on the worker threads)
+enum renderLayer {
+    featuresLayer = 0,
+    streetsLayer,
+    intersectionsLayer,
+    streetNamesLayer,
+    featureNamesLayer,
+    poiLayer,
+    labelPlacementLayer,
+    overlayLayer,
+    NUM_RENDER_LAYERS
+};
+
+class renderStats{
+    public:
+        renderStats();
+
+        ~renderStats();
+
+        //Records one run of a layer that began at start (now is its end)
+        //primitives: shapes, lines or labels the run drew
+        //Thread safe: map tiles record their layers from the worker threads
+        void record(renderLayer layer, std::chrono::steady_clock::time_point start, int primitives);
+
+        //Records a whole frame (one draw_main_canvas) that began at start
+        void recordFrame(std::chrono::steady_clock::time_point start);
+
+        //Forgets every run and frame recorded
+        void reset();
+
+        //Draws the per-layer timers and the frame time histogram in the top left corner of the screen
+        void drawOverlay(ezgl::renderer* g);
+
+        //Appends the per-layer timers and the frame time histogram to fileName, under a title line
+        //Returns: false if the file could not be written
+        bool dump(const std::string& fileName, const std::string& title);
+
+    private:
+        struct layerStats{
+            unsigned long runs;
+            double totalSeconds;
+            double lastSeconds;
+            double maxSeconds;
+            unsigned long totalPrimitives;
+            int lastPrimitives;
+        };
+
+        //Return: one line per layer (name, last and average time, primitives) and the frame time summary
+        std::vector<std::string> report();
+
+        //Return: number of recent frames falling in each bucket of FrameBucketLimits
+        std::vector<int> histogram() const;
+
+        std::mutex lock;
+
+        layerStats layers[NUM_RENDER_LAYERS];
+
+        //Vector --> key: [frame number % FRAME_HISTORY] value: [frame time in seconds]
+        std::vector<double> frameTimes;
+
+        //frames recorded since the last reset
+        unsigned long numFrames;
+};
+
+#endif /* RENDERSTATS_H */
+
@@ -0,0 +1,88 @@
+/*
+ * File:   routeCache.cpp
+ * Author: georg157
+ *
+ * Bounded, thread safe LRU cache of driving paths, keyed by (start, end, turn penalty)
+ */
+
+#include "routeCache.h"
+#include <algorithm>
+#include <cstring>
+
+bool routeCache::routeKey::operator==(const routeKey& other) const{
+    return start == other.start && end == other.end && penaltyBits == other.penaltyBits;
+}
+
+std::size_t routeCache::routeKeyHash::operator()(const routeKey& key) const{
+    std::uint64_t hash = ((std::uint64_t) (unsigned) key.start << 32) ^ (unsigned) key.end;
+    hash ^= key.penaltyBits + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return (std::size_t) (hash * 0xff51afd7ed558ccdULL);
+}
+
+routeCache::routeCache(unsigned maxRoutes) : hits(0), misses(0) {
+    capacity = std::max(1u, maxRoutes);
+}
+
+routeCache::~routeCache() {
+}
+
+routeCache::routeKey routeCache::makeKey(int start, int end, double turnPenalty){
+    routeKey key;
+    key.start = start;
+    key.end = end;
+    std::memcpy(&key.penaltyBits, &turnPenalty, sizeof(key.penaltyBits));
+    return key;
+}
+
+bool routeCache::find(int start, int end, double turnPenalty, std::vector<int>& path, double& travelTime){
+    std::lock_guard<std::mutex> guard(lock);
+
+    std::unordered_map<routeKey, routeIterator, routeKeyHash>::iterator cached = byKey.find(makeKey(start, end, turnPenalty));
+    if (cached == byKey.end()){
+        misses++;
+        return false;
+    }
+
+    path = cached->second->path;
+    travelTime = cached->second->travelTime;
+    touch(cached->second);
+    hits++;
+    return true;
+}
+
+void routeCache::insert(int start, int end, double turnPenalty, const std::vector<int>& path, double travelTime){
+    routeKey key = makeKey(start, end, turnPenalty);
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    std::unordered_map<routeKey, routeIterator, routeKeyHash>::iterator cached = byKey.find(key);
+    if (cached != byKey.end()){
+        touch(cached->second);
+        return;
+    }
+
+    if (routes.size() >= capacity){
+        byKey.erase(routes.back().key);
+        routes.pop_back();
+    }
+
+    routes.push_front({key, path, travelTime});
+    byKey.insert(std::make_pair(key, routes.begin()));
+}
+
+void routeCache::touch(routeIterator route){
+    routes.splice(routes.begin(), routes, route);
+}
+
+void routeCache::clear(){
+    std::lock_guard<std::mutex> guard(lock);
+    routes.clear();
+    byKey.clear();
+    hits = 0;
+    misses = 0;
+}
+
+routeCacheStats routeCache::stats(){
+    std::lock_guard<std::mutex> guard(lock);
+    return {hits, misses, (unsigned) routes.size()};
+}
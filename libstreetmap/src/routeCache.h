@@ -0,0 +1,88 @@
+/*
+ * File:   routeCache.h
+ * Author: georg157
+ *
+ * Bounded, thread safe LRU cache of driving paths, keyed by (start, end, turn penalty)
+ * Paths are only given whole, for the same query: find_path_between_intersections is a heuristic search, so neither
+ * its paths nor their parts are guaranteed shortest, and a part would answer a query differently than the search does
+ */
+
+#ifndef ROUTECACHE_H
+#define ROUTECACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#define ROUTE_CACHE_CAPACITY 4096 //paths kept, the least recently used is evicted past this
+
+struct routeCacheStats{
+    unsigned long hits;
+    unsigned long misses;
+    unsigned entries;
+};
+
+class routeCache{
+    public:
+        routeCache(unsigned capacity = ROUTE_CACHE_CAPACITY);
+
+        ~routeCache();
+
+        //Looks up the path cached from start to end
+        //Returns: true if found, path and travelTime (seconds) are then set (an empty path with start != end: no path exists)
+        bool find(int start, int end, double turnPenalty, std::vector<int>& path, double& travelTime);
+
+        //Caches the path found from start to end (empty if none exists), evicting the least recently used if full
+        void insert(int start, int end, double turnPenalty, const std::vector<int>& path, double travelTime);
+
+        //Forgets every path (the map was closed or another one loaded)
+        void clear();
+
+        //Returns: hit and miss counters since the last clear, and the number of paths cached
+        routeCacheStats stats();
+
+    private:
+        struct routeKey{
+            int start;
+            int end;
+            std::uint64_t penaltyBits; //turn penalty compared bit for bit
+
+            bool operator==(const routeKey& other) const;
+        };
+
+        struct routeKeyHash{
+            std::size_t operator()(const routeKey& key) const;
+        };
+
+        struct cachedRoute{
+            routeKey key;
+            std::vector<int> path;
+            double travelTime;
+        };
+
+        typedef std::list<cachedRoute>::iterator routeIterator;
+
+        static routeKey makeKey(int start, int end, double turnPenalty);
+
+        //Moves the route to the most recently used end
+        void touch(routeIterator route);
+
+        unsigned capacity;
+
+        std::mutex lock;
+
+        //most recently used first
+        std::list<cachedRoute> routes;
+
+        //Hashtable --> key: [start, end, turn penalty] value: [cached route]
+        std::unordered_map<routeKey, routeIterator, routeKeyHash> byKey;
+
+        std::atomic<unsigned long> hits;
+        std::atomic<unsigned long> misses;
+};
+
+#endif /* ROUTECACHE_H */
+
@@ -0,0 +1,132 @@
+/*
+ * File:   routeWorker.cpp
+ * Author: georg157
+ *
+ * Computes routes (m3) on a worker thread, so the GTK thread never waits for a path search
+ */
+
+#include "routeWorker.h"
+#include "m3A.h"
+
+routeWorker::routeWorker() {
+    stopping = false;
+    hasPending = false;
+    busy = false;
+    latestID = 0;
+}
+
+routeWorker::~routeWorker() {
+    stop();
+}
+
+void routeWorker::start(routeResultFn onResult){
+    stop();
+
+    resultReady = onResult;
+    worker = std::thread(&routeWorker::workerLoop, this);
+}
+
+void routeWorker::stop(){
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        cancelLocked();
+    }
+    jobQueued.notify_all();
+
+    if (worker.joinable())
+        worker.join();
+    stopping = false;
+}
+
+unsigned routeWorker::submit(const routeRequest& request){
+    std::lock_guard<std::mutex> guard(lock);
+    cancelLocked();
+
+    pending = request;
+    hasPending = true;
+    jobQueued.notify_all();
+
+    return latestID;
+}
+
+void routeWorker::cancel(){
+    std::lock_guard<std::mutex> guard(lock);
+    cancelLocked();
+}
+
+void routeWorker::clear(){
+    std::unique_lock<std::mutex> guard(lock);
+    cancelLocked();
+
+    jobDone.wait(guard, [this]{ return !busy; });
+}
+
+unsigned routeWorker::latestRequest(){
+    std::lock_guard<std::mutex> guard(lock);
+    return latestID;
+}
+
+void routeWorker::cancelLocked(){
+    latestID++;
+    hasPending = false;
+
+    //the search polls the flag, then returns no path
+    if (busy)
+        context.cancel();
+}
+
+std::shared_ptr<routeResult> routeWorker::computeRoute(unsigned requestID, const routeRequest& request){
+    std::shared_ptr<routeResult> result = std::make_shared<routeResult>();
+    result->requestID = requestID;
+    result->request = request;
+
+    if (!request.walkToPickUp){
+        result->drivingPath = context.find_path_between_intersections(request.startID, request.destID, request.turnPenalty);
+        result->directions = context.drivingDirections();
+    }
+    else{
+        std::pair<std::vector<StreetSegmentIndex>, std::vector<StreetSegmentIndex>> paths = context.find_path_with_walk_to_pick_up(
+                request.startID, request.destID, request.turnPenalty, request.walkingSpeed, request.walkingTimeLimit);
+        result->walkingPath = paths.first;
+        result->drivingPath = paths.second;
+        result->directions = context.walkingDirections() + "\n\n" + context.drivingDirections();
+        
+        if (!context.cancelled())
+            result->walkingArea = context.find_walking_isochrone(request.startID, request.turnPenalty, request.walkingSpeed, 
+                                                                 request.walkingTimeLimit, true).hull;
+    }
+
+    return result;
+}
+
+void routeWorker::workerLoop(){
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (true){
+        jobQueued.wait(guard, [this]{ return stopping || hasPending; });
+        if (stopping)
+            return;
+
+        routeRequest request = pending;
+        unsigned requestID = latestID;
+        hasPending = false;
+        busy = true;
+        context.clearCancel();
+
+        //searching happens outside the lock, so a new request can cancel it
+        guard.unlock();
+        std::shared_ptr<routeResult> result = computeRoute(requestID, request);
+        guard.lock();
+
+        busy = false;
+        bool current = (requestID == latestID);
+        jobDone.notify_all();
+
+        if (current && resultReady){
+            guard.unlock();
+            resultReady(result);
+            guard.lock();
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * File:   routeWorker.h
+ * Author: georg157
+ *
+ * Computes routes (m3) on a worker thread, so the GTK thread never waits for a path search
+ * A new request supersedes the one before it: the running search is cancelled and its result dropped
+ */
+
+#ifndef ROUTEWORKER_H
+#define ROUTEWORKER_H
+
+#include "ezgl/point.hpp"
+#include "routingContext.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct routeRequest{
+    int startID;
+    int destID;
+    double turnPenalty;
+    
+    //walk to a pick up intersection first (find_path_with_walk_to_pick_up), otherwise drive only
+    bool walkToPickUp;
+    double walkingSpeed;
+    double walkingTimeLimit; //minutes
+};
+
+struct routeResult{
+    unsigned requestID; //returned by submit
+    routeRequest request;
+    
+    std::vector<int> walkingPath; //empty when driving only
+    std::vector<int> drivingPath;
+    
+    //walking then driving directions, built on the worker thread
+    std::string directions;
+    
+    //outline (convex hull, (x,y)) of the area within walking distance of the start, empty when driving only
+    std::vector<ezgl::point2d> walkingArea;
+};
+
+//Called on the worker thread with each result that was not superseded or cancelled
+typedef std::function<void(std::shared_ptr<const routeResult>)> routeResultFn;
+
+class routeWorker{
+    public:
+        routeWorker();
+
+        //stops the worker thread
+        ~routeWorker();
+
+        //Starts the worker thread, onResult is called (on the worker thread) with each route found
+        void start(routeResultFn onResult);
+
+        //Cancels any search and stops the worker thread
+        void stop();
+
+        //Queues a route, replacing the request still queued and cancelling the search running
+        //Returns: ID of the request (see latestRequest)
+        unsigned submit(const routeRequest& request);
+
+        //Drops the queued request and cancels the search running, without waiting for it
+        void cancel();
+
+        //Cancels like cancel, then waits until no search runs (call before closing the map)
+        void clear();
+
+        //Returns: ID of the last request submitted, results of any other request are stale
+        //(cancel and clear also make every earlier result stale)
+        unsigned latestRequest();
+
+    private:
+        //Runs on the worker thread: computes the path(s) and directions of one request
+        std::shared_ptr<routeResult> computeRoute(unsigned requestID, const routeRequest& request);
+
+        //Drops the queued request and cancels the running search, lock must be held
+        void cancelLocked();
+
+        void workerLoop();
+
+        std::mutex lock;
+
+        //signalled when a request is queued or the worker must stop
+        std::condition_variable jobQueued;
+
+        //signalled when a search finishes
+        std::condition_variable jobDone;
+
+        std::thread worker;
+
+        bool stopping;
+
+        routeResultFn resultReady;
+
+        //request waiting for the worker (only the latest one is kept)
+        routeRequest pending;
+        bool hasPending;
+
+        //true while the worker searches
+        bool busy;
+
+        unsigned latestID;
+
+        //search state of the worker thread (cancel may be called on it from any thread)
+        routingContext context;
+};
+
+#endif /* ROUTEWORKER_H */
+
@@ -0,0 +1,149 @@
+/*
+ * File:   routingContext.cpp
+ * Author: georg157
+ *
+ * Per-query state of the path searches; the searches themselves are in m3.cpp
+ */
+
+#include "routingContext.h"
+#include "m3A.h"
+
+routingContext::routingContext() : cancelRequested(false) {
+    bestPathTravelTime = 0;
+    find_path_djikstra_bool = false;
+    targetReached = std::make_pair(-1, std::string());
+}
+
+routingContext::~routingContext() {
+    clearNodesEncountered();
+}
+
+const std::vector<maneuver>& routingContext::drivingManeuvers(){
+    return drivingRoute.getManeuvers();
+}
+
+const std::vector<maneuver>& routingContext::walkingManeuvers(){
+    return walkingRoute.getManeuvers();
+}
+
+const std::string& routingContext::drivingDirections(){
+    return drivingRoute.getText("Driving Directions:\n\n", "You will arrive at your destination. \n", "Estimated time: ");
+}
+
+const std::string& routingContext::walkingDirections(){
+    return walkingRoute.getText("Walking Directions:\n\n", "You will arrive at the pickup spot. \n", "Estimated walking time: ");
+}
+
+double routingContext::lastPathTravelTime() const{
+    return bestPathTravelTime;
+}
+
+bool routingContext::djikstraPathFound() const{
+    return find_path_djikstra_bool;
+}
+
+const std::pair<int, std::string>& routingContext::lastTargetReached() const{
+    return targetReached;
+}
+
+void routingContext::setQueryClosures(std::shared_ptr<const blockedSegments> closed){
+    queryClosures = closed;
+    closures.query = queryClosures.get();
+}
+
+void routingContext::refreshClosures(){
+    globalClosures = SegmentClosures.snapshot();
+    closures.global = globalClosures.get();
+    closures.query = queryClosures.get();
+}
+
+bool routingContext::closuresActive() const{
+    return closures.any();
+}
+
+bool routingContext::pathClosed(const std::vector<StreetSegmentIndex>& path) const{
+    if (!closures.any())
+        return false;
+    for (std::vector<StreetSegmentIndex>::const_iterator it = path.begin(); it != path.end(); ++it){
+        if (closures.closed(*it))
+            return true;
+    }
+    return false;
+}
+
+void routingContext::cancel(){
+    cancelRequested = true;
+}
+
+void routingContext::clearCancel(){
+    cancelRequested = false;
+}
+
+bool routingContext::cancelled() const{
+    return cancelRequested;
+}
+
+routingContext::describedPath::describedPath() {
+    clear();
+}
+
+void routingContext::describedPath::clear(){
+    searched = false;
+    found = false;
+    startID = -1;
+    path.clear();
+    travelTime = 0;
+    hasManeuvers = false;
+    maneuvers.clear();
+    hasText = false;
+    text.clear();
+}
+
+void routingContext::describedPath::set(bool pathFound, int start, const std::vector<StreetSegmentIndex>& pathFrom, double time){
+    clear();
+    searched = true;
+    found = pathFound;
+    startID = start;
+    path = pathFrom;
+    travelTime = time;
+}
+
+const std::vector<maneuver>& routingContext::describedPath::getManeuvers(){
+    if (!hasManeuvers){
+        maneuvers = path_maneuvers(startID, path);
+        hasManeuvers = true;
+    }
+    return maneuvers;
+}
+
+const std::string& routingContext::describedPath::getText(const std::string& title, const std::string& arrival, const std::string& timeLabel){
+    if (!hasText){
+        if (!searched)
+            text = "";
+        else if (!found)
+            text = "No path found";
+        else
+            text = title + maneuvers_text(getManeuvers()) + arrival + timeLabel + printTime(travelTime/60); //seconds to minutes
+        hasText = true;
+    }
+    return text;
+}
+
+routingContext::searchSpace::searchSpace() {
+    run = 0;
+}
+
+void routingContext::searchSpace::prepare(unsigned numIntersections){
+    if (stamp.size() != numIntersections || run == 0xFFFFFFFF){
+        time.assign(numIntersections, 0);
+        edge.assign(numIntersections, -1);
+        stamp.assign(numIntersections, 0);
+        run = 0;
+    }
+    run++;
+    settledIDs.clear();
+}
+
+bool routingContext::searchSpace::settled(int intersectionID) const{
+    return stamp[intersectionID] == run;
+}
@@ -0,0 +1,235 @@
+/*
+ * File:   routingContext.h
+ * Author: georg157
+ *
+ * Everything one path query writes (search workspaces, the last paths found and their directions), so that several threads
+ * can each run queries with their own context against the one read-only map loaded by load_map
+ * The m3/m4 free functions run on the calling thread's context (see thread_routing_context)
+ */
+
+#ifndef ROUTINGCONTEXT_H
+#define ROUTINGCONTEXT_H
+
+#include "StreetsDatabaseAPI.h"
+#include "ezgl/point.hpp"
+#include "Node.h"
+#include "blockedSegments.h"
+#include "maneuver.h"
+#include "walkingSearch.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define ALTERNATIVE_MAX_STRETCH 0.25 //an alternative takes at most 25% longer than the fastest path
+#define ALTERNATIVE_MAX_OVERLAP 0.6 //at most 60% of an alternative's time is shared with any path already chosen
+#define ALTERNATIVE_MAX_CANDIDATES 64 //via intersections tried, best first, per query
+
+//A path and its travel time (seconds), see find_alternative_paths
+struct alternativePath{
+    std::vector<StreetSegmentIndex> path;
+    double travelTime;
+};
+
+//Every intersection within walking distance of a start (see find_walking_isochrone)
+struct walkingIsochrone{
+    //Vector --> (intersection ID, walking time in seconds) of every reachable intersection, nearest first
+    std::vector<std::pair<int, double>> reached;
+
+    //Vector --> convex hull of the reachable intersections' (x,y) positions, counter-clockwise (empty unless asked for)
+    std::vector<ezgl::point2d> hull;
+};
+
+class routingContext{
+    public:
+        routingContext();
+
+        //frees the nodes of an unfinished search
+        ~routingContext();
+
+        //m3 queries, same contract as the free functions of m3.h (the path found is kept, see drivingManeuvers)
+        std::vector<StreetSegmentIndex> find_path_between_intersections(const IntersectionIndex intersect_id_start,
+                                                                        const IntersectionIndex intersect_id_end,
+                                                                        const double turn_penalty);
+
+        std::pair<std::vector<StreetSegmentIndex>, std::vector<StreetSegmentIndex>> find_path_with_walk_to_pick_up(const IntersectionIndex start_intersection,
+                                                                                                                   const IntersectionIndex end_intersection,
+                                                                                                                   const double turn_penalty,
+                                                                                                                   const double walking_speed,
+                                                                                                                   const double walking_time_limit);
+
+        walkingIsochrone find_walking_isochrone(const IntersectionIndex start_intersection, const double turn_penalty,
+                                                const double walking_speed, const double walking_time_limit, bool withHull = false);
+
+        //Path from intersect_id_start to whichever of pickUpDropOffNodes is reached first (m4)
+        //The target reached is given by lastTargetReached
+        std::vector<StreetSegmentIndex> find_path_djikstra(const IntersectionIndex intersect_id_start,
+                                                           const std::vector<std::pair<int, std::string>>& pickUpDropOffNodes,
+                                                           const double turn_penalty);
+
+        //Up to k driving paths from start to end, the fastest first, then meaningfully different alternatives:
+        //each within ALTERNATIVE_MAX_STRETCH of the fastest, without loops, overlapping every path before it by at most
+        //ALTERNATIVE_MAX_OVERLAP (of its time). Alternatives go through a via intersection, picked from one forward search
+        //(from start) and one backward search (to end), both bounded by the stretch
+        //Returns: fewer than k paths if there aren't enough alternatives, none if end can't be reached
+        std::vector<alternativePath> find_alternative_paths(const IntersectionIndex intersect_id_start,
+                                                            const IntersectionIndex intersect_id_end,
+                                                            const double turn_penalty,
+                                                            const unsigned k);
+
+        //Driving path leaving at departure_time (seconds since midnight), on the time of day travel times of
+        //SegmentSpeedProfiles (speed limits where no profile is loaded); its travel time is given by lastPathTravelTime
+        std::vector<StreetSegmentIndex> find_path_time_dependent(const IntersectionIndex intersect_id_start,
+                                                                 const IntersectionIndex intersect_id_end,
+                                                                 const double turn_penalty,
+                                                                 const double departure_time);
+
+        //Returns: maneuvers of the last driving path searched for (m3), built on the first call
+        const std::vector<maneuver>& drivingManeuvers();
+
+        //Returns: maneuvers of the walking part of the last find_path_with_walk_to_pick_up, built on the first call
+        const std::vector<maneuver>& walkingManeuvers();
+
+        //Returns: directions of the last driving path searched for ("No path found" if none), formatted on the first call
+        const std::string& drivingDirections();
+
+        //Returns: directions of the walking part of the last find_path_with_walk_to_pick_up ("" if no walking)
+        const std::string& walkingDirections();
+
+        //Returns: driving time (seconds) of the last path found
+        double lastPathTravelTime() const;
+
+        //Returns: true if the last find_path_djikstra found a path
+        //corner case: if source == target the path is empty, but a path was found
+        bool djikstraPathFound() const;
+
+        //Returns: the target (intersection ID, pick up / drop off) the last find_path_djikstra reached
+        const std::pair<int, std::string>& lastTargetReached() const;
+
+        //Closes segments for this context's queries only, on top of the global closures (null: none)
+        //Stays set until replaced
+        void setQueryClosures(std::shared_ptr<const blockedSegments> closed);
+
+        //Takes the current global closures (SegmentClosures), every query does this when it starts
+        void refreshClosures();
+
+        //Returns: true if the closures taken last close any segment
+        bool closuresActive() const;
+
+        //Returns: true if path uses a segment closed by the closures taken last
+        bool pathClosed(const std::vector<StreetSegmentIndex>& path) const;
+
+        //Stops the search running on this context (from any thread), it then returns no path
+        //Stays set (every later search returns no path) until clearCancel
+        void cancel();
+
+        void clearCancel();
+
+        bool cancelled() const;
+
+    private:
+        //A path found by the last query, its maneuvers and directions are only built when asked for
+        struct describedPath{
+            bool searched;
+            bool found;
+            int startID;
+            std::vector<StreetSegmentIndex> path;
+            double travelTime; //seconds
+
+            bool hasManeuvers;
+            std::vector<maneuver> maneuvers;
+            bool hasText;
+            std::string text;
+
+            describedPath();
+
+            //Forgets the path (no search)
+            void clear();
+
+            void set(bool pathFound, int start, const std::vector<StreetSegmentIndex>& pathFrom, double time);
+
+            const std::vector<maneuver>& getManeuvers();
+
+            //Returns: title, maneuvers, then arrival and estimated time
+            const std::string& getText(const std::string& title, const std::string& arrival, const std::string& timeLabel);
+        };
+
+        //Driving path helper functions
+        bool breadthFirstSearch(int startID, int destID, const double turn_penalty);
+        std::vector<StreetSegmentIndex> bfsTraceBack(int destID);
+        Node* getNodeByID(int intersectionID);
+        void clearNodesEncountered();
+
+        //Walking path helper functions
+        bool walkingPathBFS(int startID, int destID, const double turn_penalty, const double walking_speed, const double walking_time_limit);
+        int pickUpDrivingSearch(int destID, const double turn_penalty);
+        std::vector<StreetSegmentIndex> walkBFSTraceBack(int pickupIntersectID);
+
+        //M4 path finding helper functions
+        bool djikstraBFS(int sourceID, const std::vector<std::pair<int, std::string>>& pickUpDropOffNodes, const double turn_penalty);
+        std::vector<StreetSegmentIndex> djikstraBFSTraceBack(int destID);
+
+        //search space of a node-labelled search (find_path_djikstra, find_path_time_dependent, find_alternative_paths),
+        //only slots with stamp == run belong to the last search
+        struct searchSpace{
+            //Vector --> key: [intersection ID] value: [best time from (forward) or to (backward) the source, seconds /
+            //segment towards the source on the best path]
+            std::vector<double> time;
+            std::vector<int> edge;
+            std::vector<unsigned> stamp;
+            unsigned run;
+
+            //intersections settled by the last search, in order
+            std::vector<int> settledIDs;
+
+            searchSpace();
+
+            //Starts a new search (resizing the workspace to numIntersections)
+            void prepare(unsigned numIntersections);
+
+            bool settled(int intersectionID) const;
+        };
+
+        //Alternative paths helper functions
+        bool boundedSearch(int sourceID, int stopID, bool backward, const double turn_penalty, double& bound, searchSpace& space);
+        std::vector<StreetSegmentIndex> searchSpacePath(int viaID, bool backward, const searchSpace& space) const;
+
+        //Time-dependent path finding helper function (shares djikstraSpace, its times are arrival clocks)
+        bool timeDependentSearch(int sourceID, int destID, const double turn_penalty, const double departure_time);
+
+        //Hashtable --> key: [intersection ID] value: [node of the search running] (breadthFirstSearch, pickUpDrivingSearch)
+        std::unordered_map<int, Node*> nodesEncountered;
+
+        //intersections within walking distance of the start, for find_path_with_walk_to_pick_up
+        walkingSearch walkableSearch;
+
+        //workspace of find_walking_isochrone (kept apart, so it never overwrites a pick up search)
+        walkingSearch isochroneSearch;
+
+        //find_path_djikstra workspace (find_path_time_dependent shares it, its times are arrival clocks)
+        searchSpace djikstraSpace;
+
+        //find_alternative_paths workspaces
+        searchSpace forwardSpace;
+        searchSpace backwardSpace;
+
+        double bestPathTravelTime;
+
+        describedPath drivingRoute;
+        describedPath walkingRoute;
+
+        bool find_path_djikstra_bool;
+        std::pair<int, std::string> targetReached;
+
+        std::atomic<bool> cancelRequested;
+
+        //closures the searches honour (global snapshot taken by refreshClosures, and this context's own)
+        std::shared_ptr<const blockedSegments> globalClosures;
+        std::shared_ptr<const blockedSegments> queryClosures;
+        closureView closures;
+};
+
+#endif /* ROUTINGCONTEXT_H */
+
@@ -0,0 +1,158 @@
+/*
+ * File:   segmentGrid.cpp
+ * Author: georg157
+ *
+ * Uniform grid over street segment bounding boxes, each cell split into buckets (road types)
+ */
+
+#include "segmentGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+segmentGrid::segmentGrid() {
+    clear();
+}
+
+segmentGrid::~segmentGrid() {
+}
+
+void segmentGrid::clear(){
+    minX = 0;
+    minY = 0;
+    cellSize = 1;
+    numCols = 0;
+    numRows = 0;
+    numBuckets = 0;
+    cellStart.clear();
+    cellSegments.clear();
+    segmentBounds.clear();
+    firstCol.clear();
+    firstRow.clear();
+}
+
+int segmentGrid::colOf(double x) const{
+    int col = (int) std::floor((x - minX) / cellSize);
+    return std::max(0, std::min(numCols - 1, col));
+}
+
+int segmentGrid::rowOf(double y) const{
+    int row = (int) std::floor((y - minY) / cellSize);
+    return std::max(0, std::min(numRows - 1, row));
+}
+
+void segmentGrid::build(const std::vector<ezgl::point2d>& pointsXY, const std::vector<int>& pointOffsets,
+                        const std::vector<unsigned char>& segmentBucket, int buckets){
+    clear();
+
+    int numSegments = segmentBucket.size();
+    numBuckets = buckets;
+
+    if (numSegments == 0 || numBuckets <= 0)
+        return;
+
+    //bounding box of each segment and of the whole map
+    double maxX = -std::numeric_limits<double>::max();
+    double maxY = -std::numeric_limits<double>::max();
+    minX = std::numeric_limits<double>::max();
+    minY = std::numeric_limits<double>::max();
+
+    segmentBounds.reserve(numSegments);
+    for (int id = 0; id < numSegments; id++){
+        ezgl::point2d low = pointsXY[pointOffsets[id]];
+        ezgl::point2d high = low;
+        for (int point = pointOffsets[id] + 1; point < pointOffsets[id + 1]; point++){
+            low.x = std::min(low.x, pointsXY[point].x);
+            low.y = std::min(low.y, pointsXY[point].y);
+            high.x = std::max(high.x, pointsXY[point].x);
+            high.y = std::max(high.y, pointsXY[point].y);
+        }
+        segmentBounds.push_back(ezgl::rectangle(low, high));
+
+        minX = std::min(minX, low.x);
+        minY = std::min(minY, low.y);
+        maxX = std::max(maxX, high.x);
+        maxY = std::max(maxY, high.y);
+    }
+
+    //roughly 4 segments per cell on a square grid, at most 1024 cells per side
+    double width = std::max(maxX - minX, 1.0);
+    double height = std::max(maxY - minY, 1.0);
+    double targetCells = std::max(1.0, numSegments / 4.0);
+    cellSize = std::sqrt(width * height / targetCells);
+    cellSize = std::max(cellSize, std::max(width, height) / 1024);
+    numCols = std::max(1, (int) std::ceil(width / cellSize));
+    numRows = std::max(1, (int) std::ceil(height / cellSize));
+
+    //count entries per (cell, bucket), then fill (counting sort)
+    int numSlots = numCols * numRows * numBuckets;
+    cellStart.assign(numSlots + 1, 0);
+    firstCol.resize(numSegments);
+    firstRow.resize(numSegments);
+
+    for (int id = 0; id < numSegments; id++){
+        firstCol[id] = colOf(segmentBounds[id].left());
+        firstRow[id] = rowOf(segmentBounds[id].bottom());
+        int lastCol = colOf(segmentBounds[id].right());
+        int lastRow = rowOf(segmentBounds[id].top());
+        for (int row = firstRow[id]; row <= lastRow; row++){
+            for (int col = firstCol[id]; col <= lastCol; col++){
+                cellStart[(row * numCols + col) * numBuckets + segmentBucket[id] + 1]++;
+            }
+        }
+    }
+    for (int slot = 0; slot < numSlots; slot++){
+        cellStart[slot + 1] += cellStart[slot];
+    }
+
+    cellSegments.resize(cellStart[numSlots]);
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (int id = 0; id < numSegments; id++){
+        int lastCol = colOf(segmentBounds[id].right());
+        int lastRow = rowOf(segmentBounds[id].top());
+        for (int row = firstRow[id]; row <= lastRow; row++){
+            for (int col = firstCol[id]; col <= lastCol; col++){
+                cellSegments[fill[(row * numCols + col) * numBuckets + segmentBucket[id]]++] = id;
+            }
+        }
+    }
+}
+
+void segmentGrid::query(const ezgl::rectangle& area, std::vector<std::vector<int>>& segmentsByBucket,
+                        const std::vector<bool>& bucketMask) const{
+    if (numBuckets == 0)
+        return;
+
+    segmentsByBucket.resize(numBuckets);
+
+    int colLow = colOf(area.left());
+    int colHigh = colOf(area.right());
+    int rowLow = rowOf(area.bottom());
+    int rowHigh = rowOf(area.top());
+
+    for (int row = rowLow; row <= rowHigh; row++){
+        for (int col = colLow; col <= colHigh; col++){
+            int cell = row * numCols + col;
+            for (int bucket = 0; bucket < numBuckets; bucket++){
+                if (!bucketMask.empty() && (bucket >= (int) bucketMask.size() || !bucketMask[bucket]))
+                    continue;
+
+                int slot = cell * numBuckets + bucket;
+                for (int entry = cellStart[slot]; entry < cellStart[slot + 1]; entry++){
+                    int id = cellSegments[entry];
+
+                    //a segment spanning several cells is only reported from the first of them inside the query
+                    if (std::max(firstCol[id], colLow) != col || std::max(firstRow[id], rowLow) != row)
+                        continue;
+
+                    const ezgl::rectangle& bounds = segmentBounds[id];
+                    if (bounds.right() < area.left() || bounds.left() > area.right() ||
+                        bounds.top() < area.bottom() || bounds.bottom() > area.top())
+                        continue;
+
+                    segmentsByBucket[bucket].push_back(id);
+                }
+            }
+        }
+    }
+}
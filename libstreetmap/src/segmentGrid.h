@@ -0,0 +1,62 @@
+/*
+ * File:   segmentGrid.h
+ * Author: georg157
+ *
+ * Uniform grid over street segment bounding boxes, each cell split into buckets (road types)
+ * Used by draw_streets to visit only segments inside the visible world
+ */
+
+#ifndef SEGMENTGRID_H
+#define SEGMENTGRID_H
+
+#include "ezgl/point.hpp"
+#include "ezgl/rectangle.hpp"
+#include <vector>
+
+class segmentGrid{
+    public:
+        segmentGrid();
+
+        ~segmentGrid();
+
+        //pointsXY/pointOffsets: every segment's polyline, points of segment s are [pointOffsets[s], pointOffsets[s+1])
+        //segmentBucket: key [segment ID] value: [bucket in range 0 to numBuckets-1]
+        void build(const std::vector<ezgl::point2d>& pointsXY, const std::vector<int>& pointOffsets,
+                   const std::vector<unsigned char>& segmentBucket, int numBuckets);
+
+        void clear();
+
+        //segmentsByBucket[bucket] is filled with every segment of that bucket whose bounding box overlaps area
+        //bucketMask: key [bucket] value: [true if wanted], buckets not wanted are never walked (empty: every bucket)
+        //each segment is reported once, results are only appended (caller clears)
+        //Only reads the grid, so several threads may query at the same time
+        void query(const ezgl::rectangle& area, std::vector<std::vector<int>>& segmentsByBucket,
+                   const std::vector<bool>& bucketMask = std::vector<bool>()) const;
+
+    private:
+        double minX;
+        double minY;
+        double cellSize;
+        int numCols;
+        int numRows;
+        int numBuckets;
+
+        //Vector --> key: [(cell * numBuckets) + bucket] value: [index of first entry in cellSegments] (size + 1 entries)
+        std::vector<int> cellStart;
+
+        //Vector --> segment IDs of every (cell, bucket) back to back
+        std::vector<int> cellSegments;
+
+        //Vector --> key: [segment ID] value: [bounding box]
+        std::vector<ezgl::rectangle> segmentBounds;
+
+        //Vector --> key: [segment ID] value: [lowest column and row the segment is stored in]
+        std::vector<int> firstCol;
+        std::vector<int> firstRow;
+
+        int colOf(double x) const;
+        int rowOf(double y) const;
+};
+
+#endif /* SEGMENTGRID_H */
+
@@ -0,0 +1,231 @@
+/*
+ * File:   speedProfiles.cpp
+ * Author: georg157
+ *
+ * Time of day speed profiles of street segments (see speedProfiles.h)
+ */
+
+#include "speedProfiles.h"
+#include "globals.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+//one breakpoint of the CSV, before it is laid out per segment
+struct profileBreakpoint{
+    int segmentID;
+    float time;
+    float speed; //km/h
+};
+
+//Returns: seconds since midnight of "SSSSS" or "HH:MM[:SS]", -1 if neither
+static double parse_time_of_day(const std::string& text){
+    const char* begin = text.c_str();
+    char* end;
+    double seconds = std::strtod(begin, &end);
+    if (end == begin)
+        return -1;
+    if (*end != ':')
+        return (*end == '\0') ? seconds : -1;
+
+    //HH:MM[:SS]
+    double hours = seconds;
+    begin = end + 1;
+    double minutes = std::strtod(begin, &end);
+    if (end == begin)
+        return -1;
+    seconds = 0;
+    if (*end == ':'){
+        begin = end + 1;
+        seconds = std::strtod(begin, &end);
+        if (end == begin)
+            return -1;
+    }
+    if (*end != '\0')
+        return -1;
+    return hours*3600 + minutes*60 + seconds;
+}
+
+//Returns: true if line is "<segment ID>,<time of day>,<speed km/h>" (spaces allowed), breakpoint is then set
+static bool parse_breakpoint(std::string line, profileBreakpoint& breakpoint){
+    line.erase(std::remove(line.begin(), line.end(), ' '), line.end());
+    line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
+
+    std::string::size_type firstComma = line.find(',');
+    std::string::size_type secondComma = (firstComma == std::string::npos) ? std::string::npos : line.find(',', firstComma + 1);
+    if (secondComma == std::string::npos)
+        return false;
+
+    std::string segmentText = line.substr(0, firstComma);
+    std::string timeText = line.substr(firstComma + 1, secondComma - firstComma - 1);
+    std::string speedText = line.substr(secondComma + 1);
+
+    char* end;
+    long segmentID = std::strtol(segmentText.c_str(), &end, 10);
+    if (segmentText.empty() || *end != '\0' || segmentID < 0 || segmentID >= getNumStreetSegments())
+        return false;
+
+    double time = parse_time_of_day(timeText);
+    if (time < 0 || time > SECONDS_PER_DAY)
+        return false;
+
+    double speed = std::strtod(speedText.c_str(), &end);
+    if (speedText.empty() || *end != '\0' || !(speed > 0))
+        return false;
+
+    breakpoint.segmentID = (int) segmentID;
+    breakpoint.time = (float) std::fmod(time, SECONDS_PER_DAY); //24:00 is midnight
+    breakpoint.speed = (float) speed;
+    return true;
+}
+
+speedProfiles::speedProfiles() {
+    clear();
+}
+
+speedProfiles::~speedProfiles() {
+}
+
+bool speedProfiles::load(const std::string& csvPath){
+    clear();
+
+    std::ifstream csv(csvPath.c_str());
+    if (!csv)
+        return false;
+
+    std::vector<profileBreakpoint> breakpoints;
+    std::string line;
+    while (std::getline(csv, line)){
+        std::string::size_type start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+
+        profileBreakpoint breakpoint;
+        if (parse_breakpoint(line, breakpoint))
+            breakpoints.push_back(breakpoint);
+        else
+            skipped++;
+    }
+    if (breakpoints.empty())
+        return true;
+
+    //group by segment, in time order (the last line wins if a time is given twice)
+    std::stable_sort(breakpoints.begin(), breakpoints.end(), [](const profileBreakpoint& a, const profileBreakpoint& b){
+        return a.segmentID < b.segmentID || (a.segmentID == b.segmentID && a.time < b.time);
+    });
+
+    unsigned numSegments = getNumStreetSegments();
+    offsets.assign(numSegments + 1, 0);
+    breakpointTimes.reserve(breakpoints.size());
+    breakpointTravelTimes.reserve(breakpoints.size());
+
+    unsigned next = 0;
+    for (unsigned segmentID = 0; segmentID < numSegments; segmentID++){
+        offsets[segmentID] = breakpointTimes.size();
+        int first = breakpointTimes.size();
+
+        for (; next < breakpoints.size() && breakpoints[next].segmentID == (int) segmentID; next++){
+            double speed_metersPerSec = 1000.0*breakpoints[next].speed / 3600.0;
+            float segmentTravelTime = (float) (SegmentLengths[segmentID] / speed_metersPerSec);
+
+            if ((int) breakpointTimes.size() > first && breakpointTimes.back() == breakpoints[next].time){
+                breakpointTravelTimes.back() = segmentTravelTime;
+                continue;
+            }
+            breakpointTimes.push_back(breakpoints[next].time);
+            breakpointTravelTimes.push_back(segmentTravelTime);
+        }
+
+        if ((int) breakpointTimes.size() > first){
+            makeFIFO(first, breakpointTimes.size());
+            profiled++;
+        }
+    }
+    offsets[numSegments] = breakpointTimes.size();
+
+    //search lower bounds must hold for every segment, profiled or not
+    fastest = 1000.0*MaxSpeedLimit / 3600.0;
+    for (unsigned segmentID = 0; segmentID < numSegments; segmentID++){
+        for (int i = offsets[segmentID]; i < offsets[segmentID + 1]; i++){
+            if (breakpointTravelTimes[i] > 0)
+                fastest = std::max(fastest, SegmentLengths[segmentID] / breakpointTravelTimes[i]);
+        }
+    }
+    return true;
+}
+
+void speedProfiles::makeFIFO(int first, int last){
+    //leaving at t_i + tt_i must not be later than leaving at t_(i+1) + tt_(i+1), the last breakpoint is followed by the
+    //first of the next day; lowering one breakpoint can lower the one before it, so the day is walked back twice
+    for (int pass = 0; pass < 2; pass++){
+        for (int i = last - 1; i >= first; i--){
+            int following = (i + 1 < last) ? i + 1 : first;
+            double gap = breakpointTimes[following] - breakpointTimes[i];
+            if (gap <= 0)
+                gap += SECONDS_PER_DAY;
+            breakpointTravelTimes[i] = (float) std::min((double) breakpointTravelTimes[i], gap + breakpointTravelTimes[following]);
+        }
+    }
+}
+
+void speedProfiles::clear(){
+    offsets.clear();
+    breakpointTimes.clear();
+    breakpointTravelTimes.clear();
+    fastest = 0;
+    profiled = 0;
+    skipped = 0;
+}
+
+double speedProfiles::travelTime(int segmentID, double departureTime) const{
+    if (offsets.empty())
+        return SegmentTravelTime[segmentID];
+
+    int first = offsets[segmentID];
+    int last = offsets[segmentID + 1];
+    if (first == last)
+        return SegmentTravelTime[segmentID];
+
+    double timeOfDay = std::fmod(departureTime, SECONDS_PER_DAY);
+    if (timeOfDay < 0)
+        timeOfDay += SECONDS_PER_DAY;
+
+    //breakpoints around timeOfDay, wrapping around midnight (profiles only have a few breakpoints)
+    int following = std::upper_bound(breakpointTimes.begin() + first, breakpointTimes.begin() + last, (float) timeOfDay)
+                  - breakpointTimes.begin();
+    int previous;
+    double previousTime, followingTime;
+    if (following == first){
+        previous = last - 1;
+        previousTime = breakpointTimes[previous] - SECONDS_PER_DAY;
+        followingTime = breakpointTimes[following];
+    }
+    else if (following == last){
+        previous = last - 1;
+        following = first;
+        previousTime = breakpointTimes[previous];
+        followingTime = breakpointTimes[following] + SECONDS_PER_DAY;
+    }
+    else{
+        previous = following - 1;
+        previousTime = breakpointTimes[previous];
+        followingTime = breakpointTimes[following];
+    }
+
+    double fraction = (timeOfDay - previousTime) / (followingTime - previousTime);
+    return breakpointTravelTimes[previous] + fraction*(breakpointTravelTimes[following] - breakpointTravelTimes[previous]);
+}
+
+double speedProfiles::fastestSpeed() const{
+    if (offsets.empty())
+        return 1000.0*MaxSpeedLimit / 3600.0;
+    return fastest;
+}
+
+unsigned speedProfiles::numProfiled() const{
+    return profiled;
+}
+
+unsigned speedProfiles::numSkippedLines() const{
+    return skipped;
+}
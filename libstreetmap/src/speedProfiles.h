@@ -0,0 +1,69 @@
+/*
+ * File:   speedProfiles.h
+ * Author: georg157
+ *
+ * Optional time of day speed profiles of street segments, read from a CSV file after load_map
+ * A segment's profile is a piecewise-linear travel time over the day (24 h, wrapping around midnight), stored as
+ * breakpoints back to back (one offset per segment, same layout as SegmentPointOffsets)
+ * Segments without a profile keep their speed limit travel time (SegmentTravelTime)
+ *
+ * CSV: one breakpoint per line, "<segment ID>,<time of day>,<speed km/h>", time of day is seconds since midnight or HH:MM[:SS]
+ * Lines that are empty, start with '#', or don't parse (e.g. a header) are skipped
+ */
+
+#ifndef SPEEDPROFILES_H
+#define SPEEDPROFILES_H
+
+#include <string>
+#include <vector>
+
+#define SECONDS_PER_DAY 86400.0
+
+class speedProfiles{
+    public:
+        speedProfiles();
+
+        ~speedProfiles();
+
+        //Reads the profiles of csvPath, replacing any loaded before (the map must be loaded)
+        //Not thread safe: load before running queries, every lookup after that is read-only
+        //Returns: false if the file can't be read
+        bool load(const std::string& csvPath);
+
+        //Forgets every profile (all segments back to their speed limit travel time)
+        void clear();
+
+        //Returns: travel time (seconds) of the segment when entered at departureTime (seconds since midnight, any day)
+        double travelTime(int segmentID, double departureTime) const;
+
+        //Returns: highest speed (m/s) of any segment at any time, for search lower bounds
+        double fastestSpeed() const;
+
+        //Returns: number of segments with a profile
+        unsigned numProfiled() const;
+
+        //Returns: lines of the last load that were skipped
+        unsigned numSkippedLines() const;
+
+    private:
+        //Lowers breakpoints so that entering the segment later never means leaving it earlier (FIFO), which the
+        //time-dependent search relies on
+        void makeFIFO(int first, int last);
+
+        //Vector --> key: [segment ID] value: [index of segment's first breakpoint]
+        //size is number of segments + 1 (empty if nothing is loaded), breakpoints of segment s are [offsets[s], offsets[s+1])
+        std::vector<int> offsets;
+
+        //Vector --> key: [breakpoint] value: [time of day (seconds), ascending within a segment]
+        std::vector<float> breakpointTimes;
+
+        //Vector --> key: [breakpoint] value: [travel time (seconds) when entering at that time of day]
+        std::vector<float> breakpointTravelTimes;
+
+        double fastest;
+        unsigned profiled;
+        unsigned skipped;
+};
+
+#endif /* SPEEDPROFILES_H */
+
@@ -0,0 +1,249 @@
+/*
+ * File:   tileCache.cpp
+ * Author: georg157
+ *
+ * Pyramid of prerendered map tiles (cairo image surfaces) keyed by zoom level and tile coordinates
+ */
+
+#include "tileCache.h"
+#include "ezgl/canvas.hpp"
+#include <algorithm>
+#include <cmath>
+
+tileCache::tileCache() : area({0, 0}, {0, 0}) {
+    stopping = false;
+    generation = 0;
+    busyWorkers = 0;
+    frame = 0;
+}
+
+tileCache::~tileCache() {
+    stop();
+    dropTiles();
+}
+
+std::uint64_t tileCache::keyOf(tileKey key){
+    //zoom <= MAX_TILE_ZOOM, so x and y fit in 28 bits each
+    return ((std::uint64_t) key.zoom << 56) | ((std::uint64_t) key.x << 28) | (std::uint64_t) key.y;
+}
+
+ezgl::rectangle tileCache::tileArea(tileKey key) const{
+    double size = std::ldexp(area.width(), -key.zoom);
+    return ezgl::rectangle({area.left() + key.x * size, area.bottom() + key.y * size}, size, size);
+}
+
+int tileCache::zoomFor(double worldPerPixel) const{
+    //a zoom 0 tile spreads the whole area over TILE_PIXELS, every level halves that
+    double zoom = std::round(std::log2(area.width() / (TILE_PIXELS * worldPerPixel)));
+    return (int) std::max(0.0, std::min((double) MAX_TILE_ZOOM, zoom));
+}
+
+void tileCache::start(unsigned numWorkers, std::function<void()> onTileReady){
+    stop();
+
+    tileReady = onTileReady;
+    for (unsigned i = 0; i < std::max(1u, numWorkers); i++){
+        workers.push_back(std::thread(&tileCache::workerLoop, this));
+    }
+}
+
+void tileCache::stop(){
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        requests.clear();
+    }
+    jobQueued.notify_all();
+
+    for (unsigned i = 0; i < workers.size(); i++){
+        workers[i].join();
+    }
+    workers.clear();
+    stopping = false;
+}
+
+void tileCache::clear(){
+    std::unique_lock<std::mutex> guard(lock);
+    generation++;
+    dropTiles();
+    requests.clear();
+    inProgress.clear();
+    drawTile = nullptr;
+
+    jobDone.wait(guard, [this]{ return busyWorkers == 0; });
+}
+
+void tileCache::invalidate(ezgl::rectangle mapArea, tileDrawFn newDrawTile){
+    std::lock_guard<std::mutex> guard(lock);
+    generation++;
+    dropTiles();
+    requests.clear();
+    inProgress.clear();
+
+    //tiles are square, so the area is widened to a square over the map
+    double side = std::max(mapArea.width(), mapArea.height());
+    area = ezgl::rectangle(mapArea.bottom_left(), side, side);
+    drawTile = newDrawTile;
+}
+
+void tileCache::dropTiles(){
+    for (auto it = tiles.begin(); it != tiles.end(); ++it){
+        ezgl::renderer::free_surface(it->second.surface);
+    }
+    tiles.clear();
+}
+
+int tileCache::draw(ezgl::renderer* g){
+    std::lock_guard<std::mutex> guard(lock);
+
+    ezgl::rectangle visible = g->get_visible_world();
+    ezgl::rectangle screen = g->get_visible_screen();
+
+    if (!drawTile || area.width() <= 0 || screen.width() <= 0)
+        return 0;
+
+    frame++;
+
+    int zoom = zoomFor(visible.width() / screen.width());
+    int tilesPerSide = 1 << zoom;
+    double tileSize = std::ldexp(area.width(), -zoom);
+
+    //visible range of tiles (nothing outside the map area is drawn)
+    int xLow = (int) std::floor((visible.left() - area.left()) / tileSize);
+    int xHigh = (int) std::floor((visible.right() - area.left()) / tileSize);
+    int yLow = (int) std::floor((visible.bottom() - area.bottom()) / tileSize);
+    int yHigh = (int) std::floor((visible.top() - area.bottom()) / tileSize);
+
+    xLow = std::max(xLow, 0);
+    yLow = std::max(yLow, 0);
+    xHigh = std::min(xHigh, tilesPerSide - 1);
+    yHigh = std::min(yHigh, tilesPerSide - 1);
+
+    std::vector<tileKey> cached;
+    std::vector<tileKey> missing;
+
+    for (int y = yLow; y <= yHigh; y++){
+        for (int x = xLow; x <= xHigh; x++){
+            tileKey key = {zoom, x, y};
+            auto it = tiles.find(keyOf(key));
+            if (it != tiles.end()){
+                it->second.lastDrawn = frame;
+                cached.push_back(key);
+            }
+            else{
+                missing.push_back(key);
+            }
+        }
+    }
+
+    //a missing tile is covered by its closest cached ancestor (coarser, scaled up) until it is drawn
+    std::vector<tileKey> standIns;
+    std::unordered_set<std::uint64_t> standInKeys;
+    for (unsigned i = 0; i < missing.size(); i++){
+        tileKey ancestor = missing[i];
+        while (ancestor.zoom > 0){
+            ancestor = {ancestor.zoom - 1, ancestor.x / 2, ancestor.y / 2};
+            auto it = tiles.find(keyOf(ancestor));
+            if (it != tiles.end()){
+                it->second.lastDrawn = frame;
+                if (standInKeys.insert(keyOf(ancestor)).second)
+                    standIns.push_back(ancestor);
+                break;
+            }
+        }
+    }
+
+    //coarsest first, so the finer tiles end up on top
+    std::sort(standIns.begin(), standIns.end(), [](const tileKey& a, const tileKey& b){
+        return a.zoom < b.zoom;
+    });
+    for (unsigned i = 0; i < standIns.size(); i++){
+        g->draw_surface(tiles[keyOf(standIns[i])].surface, tileArea(standIns[i]));
+    }
+    for (unsigned i = 0; i < cached.size(); i++){
+        g->draw_surface(tiles[keyOf(cached[i])].surface, tileArea(cached[i]));
+    }
+
+    //request the missing tiles closest to the centre of the screen first
+    //requests left over from earlier frames are no longer visible, so they are dropped
+    double centreX = (visible.center_x() - area.left()) / tileSize - 0.5;
+    double centreY = (visible.center_y() - area.bottom()) / tileSize - 0.5;
+    std::sort(missing.begin(), missing.end(), [centreX, centreY](const tileKey& a, const tileKey& b){
+        return (a.x - centreX) * (a.x - centreX) + (a.y - centreY) * (a.y - centreY) <
+               (b.x - centreX) * (b.x - centreX) + (b.y - centreY) * (b.y - centreY);
+    });
+
+    requests.clear();
+    for (unsigned i = 0; i < missing.size(); i++){
+        if (inProgress.count(keyOf(missing[i])) == 0)
+            requests.push_back({missing[i], generation});
+    }
+    jobQueued.notify_all();
+
+    evict();
+
+    return missing.size();
+}
+
+void tileCache::evict(){
+    if (tiles.size() <= MAX_CACHED_TILES)
+        return;
+
+    //(frame last drawn, packed key) of every tile not drawn this frame, oldest first
+    std::vector<std::pair<unsigned long, std::uint64_t>> candidates;
+    for (auto it = tiles.begin(); it != tiles.end(); ++it){
+        if (it->second.lastDrawn != frame)
+            candidates.push_back(std::make_pair(it->second.lastDrawn, it->first));
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (unsigned i = 0; i < candidates.size() && tiles.size() > MAX_CACHED_TILES; i++){
+        auto it = tiles.find(candidates[i].second);
+        ezgl::renderer::free_surface(it->second.surface);
+        tiles.erase(it);
+    }
+}
+
+void tileCache::workerLoop(){
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (true){
+        jobQueued.wait(guard, [this]{ return stopping || !requests.empty(); });
+        if (stopping)
+            return;
+
+        tileJob job = requests.front();
+        requests.pop_front();
+
+        std::uint64_t packed = keyOf(job.key);
+        ezgl::rectangle world = tileArea(job.key);
+        tileDrawFn drawFn = drawTile;
+        inProgress.insert(packed);
+        busyWorkers++;
+
+        //drawing happens outside the lock, the GTK thread keeps compositing meanwhile
+        guard.unlock();
+        ezgl::surface* surface = ezgl::canvas::render_offscreen(world, TILE_PIXELS, TILE_PIXELS, drawFn);
+        guard.lock();
+
+        busyWorkers--;
+        bool kept = false;
+        if (job.generation == generation){
+            inProgress.erase(packed);
+            if (surface != nullptr && tiles.count(packed) == 0){
+                tiles[packed] = {surface, frame};
+                kept = true;
+            }
+        }
+        if (!kept && surface != nullptr)
+            ezgl::renderer::free_surface(surface);
+
+        jobDone.notify_all();
+
+        if (kept && tileReady){
+            guard.unlock();
+            tileReady();
+            guard.lock();
+        }
+    }
+}
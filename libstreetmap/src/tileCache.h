@@ -0,0 +1,126 @@
+/*
+ * File:   tileCache.h
+ * Author: georg157
+ *
+ * Pyramid of prerendered map tiles (cairo image surfaces) keyed by zoom level and tile coordinates
+ * Tiles are drawn on worker threads and composited onto the canvas on the GTK thread
+ */
+
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include "ezgl/graphics.hpp"
+#include "ezgl/rectangle.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#define TILE_PIXELS 256 //width and height of a tile
+#define MAX_TILE_ZOOM 20 //at zoom z the map is split into 2^z by 2^z tiles
+#define MAX_CACHED_TILES 256 //least recently drawn tiles are dropped past this (256 KB each)
+
+//Draws the content of one tile, the renderer's visible world is the tile's area
+typedef std::function<void(ezgl::renderer*)> tileDrawFn;
+
+class tileCache{
+    public:
+        tileCache();
+
+        //stops the worker threads
+        ~tileCache();
+
+        //Starts numWorkers threads, onTileReady is called (on a worker thread) each time a tile is finished
+        void start(unsigned numWorkers, std::function<void()> onTileReady);
+
+        //Stops the worker threads, waiting for the tiles being drawn
+        void stop();
+
+        //Drops every tile and waits for the tiles being drawn, nothing is drawn until the next invalidate
+        //Call before changing data that drawTile reads (e.g. before closing the map)
+        void clear();
+
+        //Drops every tile, tiles from now on cover mapArea and are drawn by drawTile
+        //Tiles still being drawn with the old function are thrown away when they finish
+        void invalidate(ezgl::rectangle mapArea, tileDrawFn drawTile);
+
+        //Draws the cached tiles covering g's visible world, at the zoom level closest to g's scale
+        //Missing tiles are requested from the workers and a coarser cached tile stands in meanwhile
+        //Returns: number of visible tiles that are not drawn yet
+        int draw(ezgl::renderer* g);
+
+    private:
+        struct tileKey{
+            int zoom;
+            int x;
+            int y;
+        };
+
+        struct tile{
+            ezgl::surface* surface;
+            unsigned long lastDrawn; //frame the tile was last drawn in
+        };
+
+        struct tileJob{
+            tileKey key;
+            unsigned generation;
+        };
+
+        static std::uint64_t keyOf(tileKey key);
+
+        //Return: area of the map covered by a tile
+        ezgl::rectangle tileArea(tileKey key) const;
+
+        //Return: zoom level whose tiles are closest to worldPerPixel (world units per screen pixel)
+        int zoomFor(double worldPerPixel) const;
+
+        //Drops least recently drawn tiles (not drawn this frame) down to MAX_CACHED_TILES
+        void evict();
+
+        void dropTiles();
+
+        void workerLoop();
+
+        std::mutex lock;
+
+        //signalled when a job is queued or the workers must stop
+        std::condition_variable jobQueued;
+
+        //signalled when a worker finishes a job
+        std::condition_variable jobDone;
+
+        std::vector<std::thread> workers;
+
+        bool stopping;
+
+        std::function<void()> tileReady;
+
+        //map area (square, covered by the single tile of zoom 0) and the drawing function of the current generation
+        ezgl::rectangle area;
+        tileDrawFn drawTile;
+
+        //bumped each time the tiles are dropped, jobs of older generations are thrown away
+        unsigned generation;
+
+        //Hashtable --> key: [packed zoom, x, y] value: [tile]
+        std::unordered_map<std::uint64_t, tile> tiles;
+
+        //tiles requested by the last draw, closest to the centre of the screen first
+        std::deque<tileJob> requests;
+
+        //packed keys of the tiles of the current generation being drawn by a worker
+        std::unordered_set<std::uint64_t> inProgress;
+
+        //workers drawing a tile (of any generation)
+        int busyWorkers;
+
+        unsigned long frame;
+};
+
+#endif /* TILECACHE_H */
+
@@ -0,0 +1,79 @@
+/*
+ * File:   viewLayer.cpp
+ * Author: georg157
+ *
+ * One layer of the map kept as an image of the current view (visible world and screen size)
+ */
+
+#include "viewLayer.h"
+#include "ezgl/canvas.hpp"
+#include <cmath>
+
+viewLayer::viewLayer() {
+    image = nullptr;
+    width = 0;
+    height = 0;
+    imageVersion = 0;
+}
+
+viewLayer::~viewLayer() {
+    clear();
+}
+
+void viewLayer::clear(){
+    if (image != nullptr)
+        ezgl::renderer::free_surface(image);
+    image = nullptr;
+}
+
+bool viewLayer::draw(ezgl::renderer* g, unsigned version, const layerDrawFn& drawLayer){
+    ezgl::rectangle visible = g->get_visible_world();
+    ezgl::rectangle screen = g->get_visible_screen();
+    int screenWidth = (int) std::round(screen.width());
+    int screenHeight = (int) std::round(screen.height());
+
+    //the camera stores the visible world, so an unchanged view compares exactly equal
+    if (image != nullptr && version == imageVersion && screenWidth == width && screenHeight == height &&
+        visible.left() == world.left() && visible.right() == world.right() &&
+        visible.bottom() == world.bottom() && visible.top() == world.top()){
+        paste(g);
+        return true;
+    }
+
+    clear();
+
+    bool complete = true;
+    ezgl::surface* drawn = ezgl::canvas::render_offscreen(visible, screenWidth, screenHeight, 
+            [&complete, &drawLayer](ezgl::renderer* layerG){
+                complete = drawLayer(layerG);
+            });
+
+    //no image could be made (e.g. out of memory): the layer is drawn straight onto g
+    if (drawn == nullptr){
+        drawLayer(g);
+        return false;
+    }
+
+    image = drawn;
+    paste(g);
+
+    //an incomplete image is pasted once, then drawn again next time
+    if (complete){
+        world = visible;
+        width = screenWidth;
+        height = screenHeight;
+        imageVersion = version;
+    }
+    else{
+        clear();
+    }
+
+    return false;
+}
+
+void viewLayer::paste(ezgl::renderer* g){
+    //the image has the screen's size, so it is pasted pixel for pixel
+    g->set_coordinate_system(ezgl::SCREEN);
+    g->draw_surface(image, ezgl::point2d(0, 0));
+    g->set_coordinate_system(ezgl::WORLD);
+}
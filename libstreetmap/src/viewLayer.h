@@ -0,0 +1,49 @@
+/*
+ * File:   viewLayer.h
+ * Author: georg157
+ *
+ * One layer of the map kept as an image of the current view (visible world and screen size)
+ * The layer is only drawn again when the view or its version changes, otherwise the image is pasted
+ */
+
+#ifndef VIEWLAYER_H
+#define VIEWLAYER_H
+
+#include "ezgl/graphics.hpp"
+#include "ezgl/rectangle.hpp"
+#include <functional>
+
+//Draws the content of a layer (the renderer's visible world is the view)
+//Returns: false if what was drawn is incomplete (e.g. map tiles still missing), so the image is not kept
+typedef std::function<bool(ezgl::renderer*)> layerDrawFn;
+
+class viewLayer{
+    public:
+        viewLayer();
+
+        //frees the image
+        ~viewLayer();
+
+        //Pastes the kept image onto g if it was drawn for g's view and version
+        //Otherwise the layer is drawn again (with drawLayer, onto a transparent image) first
+        //Returns: true if the kept image was reused
+        bool draw(ezgl::renderer* g, unsigned version, const layerDrawFn& drawLayer);
+
+        //Frees the image, the next draw always draws the layer
+        void clear();
+
+    private:
+        //Pastes image over the whole screen of g
+        void paste(ezgl::renderer* g);
+
+        ezgl::surface* image;
+
+        //view and version the image was drawn for
+        ezgl::rectangle world;
+        int width;
+        int height;
+        unsigned imageVersion;
+};
+
+#endif /* VIEWLAYER_H */
+
@@ -0,0 +1,122 @@
+/*
+ * File:   walkingSearch.cpp
+ * Author: georg157
+ *
+ * Time-bounded Dijkstra search on foot, over a flat workspace (one slot per intersection)
+ */
+
+#include "walkingSearch.h"
+#include "globals.h"
+#include "StreetsDatabaseAPI.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+walkingSearch::walkingSearch() {
+    runStamp = 0;
+}
+
+walkingSearch::~walkingSearch() {
+}
+
+bool walkingSearch::run(int startID, double walkingSpeed, double timeLimit, double turnPenalty, int stopID, const closureView& closures,
+                        const std::atomic<bool>* cancelled){
+    //the workspace follows the loaded map
+    unsigned numIntersections = getNumIntersections();
+    if (visitStamp.size() != numIntersections || runStamp == 0xFFFFFFFF){
+        bestTime.assign(numIntersections, 0);
+        bestEdge.assign(numIntersections, -1);
+        visitStamp.assign(numIntersections, 0);
+        runStamp = 0;
+    }
+    runStamp++;
+    reachedIDs.clear();
+
+    //(walking time, intersection ID), smallest time first
+    typedef std::pair<double, int> walkWave;
+    std::priority_queue<walkWave, std::vector<walkWave>, std::greater<walkWave>> waveQueue;
+
+    bestTime[startID] = 0;
+    bestEdge[startID] = -1;
+    visitStamp[startID] = runStamp;
+    reachedIDs.push_back(startID);
+    waveQueue.push(std::make_pair(0.0, startID));
+
+    while (!waveQueue.empty()){
+        //a newer request superseded this search
+        if (cancelled != nullptr && *cancelled)
+            return false;
+
+        double currentTime = waveQueue.top().first;
+        int currentID = waveQueue.top().second;
+        waveQueue.pop();
+
+        //a faster way here was found after this wave was queued
+        if (currentTime > bestTime[currentID])
+            continue;
+
+        if (currentID == stopID)
+            return true;
+
+        //walking time used up at this intersection
+        if (currentTime >= timeLimit)
+            continue;
+
+        int currentEdge = bestEdge[currentID];
+        int currentStreet = (currentEdge == -1) ? -1 : getInfoStreetSegment(currentEdge).streetID;
+
+        const std::vector<int>& edges = IntersectionStreetSegments[currentID];
+        for (std::vector<int>::const_iterator it = edges.begin(); it != edges.end(); ++it){
+            if (closures.closed(*it))
+                continue;
+            InfoStreetSegment segStruct = getInfoStreetSegment(*it);
+            int outerID;
+            if (segStruct.from == currentID){
+                if (segStruct.oneWay)
+                    continue;
+                outerID = segStruct.to;
+            }
+            else{
+                outerID = segStruct.from;
+            }
+
+            double newTime = currentTime + SegmentLengths[*it] / walkingSpeed;
+            if (currentStreet != -1 && currentStreet != segStruct.streetID)
+                newTime += turnPenalty;
+
+            if (newTime > timeLimit)
+                continue;
+
+            if (visitStamp[outerID] != runStamp){
+                visitStamp[outerID] = runStamp;
+                reachedIDs.push_back(outerID);
+            }
+            else if (bestTime[outerID] <= newTime){
+                continue;
+            }
+
+            bestTime[outerID] = newTime;
+            bestEdge[outerID] = *it;
+            waveQueue.push(std::make_pair(newTime, outerID));
+        }
+    }
+
+    return false;
+}
+
+bool walkingSearch::reached(int intersectionID) const{
+    return intersectionID >= 0 && (unsigned) intersectionID < visitStamp.size() && visitStamp[intersectionID] == runStamp;
+}
+
+double walkingSearch::arrivalTime(int intersectionID) const{
+    return bestTime[intersectionID];
+}
+
+int walkingSearch::reachingEdge(int intersectionID) const{
+    return bestEdge[intersectionID];
+}
+
+const std::vector<int>& walkingSearch::reachedIntersections() const{
+    return reachedIDs;
+}
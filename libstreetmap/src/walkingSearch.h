@@ -0,0 +1,58 @@
+/*
+ * File:   walkingSearch.h
+ * Author: georg157
+ *
+ * Time-bounded Dijkstra search on foot, over a flat workspace (one slot per intersection)
+ * The workspace is kept between searches and reset only where the last search went
+ */
+
+#ifndef WALKINGSEARCH_H
+#define WALKINGSEARCH_H
+
+#include "blockedSegments.h"
+#include <atomic>
+#include <vector>
+
+class walkingSearch{
+    public:
+        walkingSearch();
+
+        ~walkingSearch();
+
+        //Walks from startID for at most timeLimit seconds (same rules as the driving search: one-ways are respected,
+        //turn_penalty seconds are added whenever the street changes)
+        //Intersections reached at exactly timeLimit are kept, but not walked on from
+        //stopID: the search ends once this intersection's arrival time is final (-1: walk everywhere within the limit)
+        //closed segments (see blockedSegments.h) are not walked on
+        //cancelled (if given) is polled on every intersection settled, the search stops once it is set
+        //Returns: true if stopID was reached (false if cancelled)
+        bool run(int startID, double walkingSpeed, double timeLimit, double turnPenalty, int stopID = -1,
+                 const closureView& closures = closureView(), const std::atomic<bool>* cancelled = nullptr);
+
+        //Returns: true if the last run reached the intersection
+        bool reached(int intersectionID) const;
+
+        //Returns: walking time (seconds) from the start of the last run, the intersection must be reached
+        double arrivalTime(int intersectionID) const;
+
+        //Returns: segment the intersection is reached by (-1 for the start), the intersection must be reached
+        int reachingEdge(int intersectionID) const;
+
+        //Returns: intersections reached by the last run (start first), in no particular order after it
+        const std::vector<int>& reachedIntersections() const;
+
+    private:
+        //Vector --> key: [intersection ID] value: [best walking time found / segment reaching it]
+        //only valid where visitStamp matches runStamp
+        std::vector<double> bestTime;
+        std::vector<int> bestEdge;
+        std::vector<unsigned> visitStamp;
+
+        //bumped by each run, so the workspace needs no clearing
+        unsigned runStamp;
+
+        std::vector<int> reachedIDs;
+};
+
+#endif /* WALKINGSEARCH_H */
+
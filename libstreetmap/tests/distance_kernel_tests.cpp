@@ -0,0 +1,169 @@
+/*
+ * File:   distance_kernel_tests.cpp
+ * Author: georg157
+ *
+ * Batch distance kernels (scalar, SSE2, AVX2, whichever the CPU has) checked against find_distance_between_two_points
+ */
+
+#include <unittest++/UnitTest++.h>
+
+#include "distanceKernel.h"
+#include "m1.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+//batch sizes around the vector widths (2 and 4) and their tails
+const std::vector<unsigned> BatchSizes = {0, 1, 3, 4, 7, 8, 1025};
+
+//Returns: true if a batch distance agrees with the scalar one (1e-9 relative, or a micrometre)
+bool closeDistance(double expected, double found){
+    return std::fabs(expected - found) <= std::max(1e-6, 1e-9 * std::fabs(expected));
+}
+
+//numPoints random positions; edge cases first: both sides of the antimeridian, the poles, the equator
+std::vector<LatLon> batchPoints(unsigned numPoints, unsigned seed){
+    const std::vector<LatLon> edgeCases = {LatLon(43.66, 179.999), LatLon(43.66, -179.999), LatLon(90, 0), LatLon(-90, 45),
+                                           LatLon(89.999, -120), LatLon(-89.999, 60), LatLon(0, 0), LatLon(0, 180)};
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> latitude(-90, 90);
+    std::uniform_real_distribution<double> longitude(-180, 180);
+    std::uniform_real_distribution<double> nearby(-0.05, 0.05);
+
+    std::vector<LatLon> points;
+    for (unsigned i = 0; i < numPoints; i++){
+        if (i < edgeCases.size() && seed % 2 == 0)
+            points.push_back(edgeCases[i]);
+        else if (i % 3 == 0)
+            points.push_back(LatLon(latitude(rng), longitude(rng)));
+        else //city sized batches, as in a loaded map
+            points.push_back(LatLon(43.7 + nearby(rng), -79.4 + nearby(rng)));
+    }
+    return points;
+}
+
+latLonArrays toArrays(const std::vector<LatLon>& points){
+    latLonArrays arrays;
+    arrays.reserve(points.size());
+    for (unsigned i = 0; i < points.size(); i++){
+        arrays.push_back(points[i]);
+    }
+    return arrays;
+}
+
+//every kernel the CPU can run (the scalar kernel always)
+std::vector<distanceKernelLevel> availableKernels(){
+    std::vector<distanceKernelLevel> kernels;
+    const std::vector<distanceKernelLevel> levels = {scalarKernel, sse2Kernel, avx2Kernel};
+    for (unsigned i = 0; i < levels.size(); i++){
+        setDistanceKernelLimit(levels[i]);
+        if (activeDistanceKernel() == levels[i])
+            kernels.push_back(levels[i]);
+    }
+    setDistanceKernelLimit(avx2Kernel);
+    return kernels;
+}
+
+}
+
+SUITE(distance_kernel_tests){
+
+    TEST(kernel_limit){
+        setDistanceKernelLimit(scalarKernel);
+        CHECK_EQUAL(scalarKernel, activeDistanceKernel());
+
+        setDistanceKernelLimit(avx2Kernel);
+        std::vector<distanceKernelLevel> kernels = availableKernels();
+        CHECK(!kernels.empty() && kernels[0] == scalarKernel);
+        CHECK_EQUAL(kernels.back(), activeDistanceKernel());
+    }
+
+    TEST(consecutive_distances){
+        std::vector<distanceKernelLevel> kernels = availableKernels();
+
+        for (unsigned k = 0; k < kernels.size(); k++){
+            setDistanceKernelLimit(kernels[k]);
+            for (unsigned s = 0; s < BatchSizes.size(); s++){
+                for (unsigned seed = 0; seed < 2; seed++){
+                    std::vector<LatLon> points = batchPoints(BatchSizes[s], 100 * s + seed);
+                    latLonArrays arrays = toArrays(points);
+
+                    std::vector<double> distances(3, -1); //resized by the kernel
+                    distancesBetweenConsecutivePoints(arrays, distances);
+                    CHECK_EQUAL(points.empty() ? 0 : points.size() - 1, distances.size());
+
+                    for (unsigned i = 0; i + 1 < points.size() && i < distances.size(); i++){
+                        double expected = find_distance_between_two_points(std::make_pair(points[i], points[i + 1]));
+                        CHECK(closeDistance(expected, distances[i]));
+                        CHECK(closeDistance(expected, distanceBetweenPoints(arrays, i, i + 1)));
+                    }
+                }
+            }
+        }
+        setDistanceKernelLimit(avx2Kernel);
+    }
+
+    TEST(distances_to_point){
+        std::vector<distanceKernelLevel> kernels = availableKernels();
+        const std::vector<LatLon> positions = {LatLon(43.7, -79.4), LatLon(43.66, 179.9999), LatLon(90, 0), LatLon(-89.9, -10)};
+
+        for (unsigned k = 0; k < kernels.size(); k++){
+            setDistanceKernelLimit(kernels[k]);
+            for (unsigned s = 0; s < BatchSizes.size(); s++){
+                for (unsigned seed = 0; seed < 2; seed++){
+                    std::vector<LatLon> points = batchPoints(BatchSizes[s] + 5, 100 * s + seed);
+                    latLonArrays arrays = toArrays(points);
+
+                    //[begin, end) holds BatchSizes[s] points, starting off the vector alignment
+                    unsigned begin = seed == 0 ? 0 : 5;
+                    unsigned end = begin + BatchSizes[s];
+
+                    for (unsigned p = 0; p < positions.size(); p++){
+                        std::vector<double> distances(BatchSizes[s] + 1, -1);
+                        distancesToPoint(arrays, begin, end, positions[p], distances.data());
+
+                        for (unsigned i = begin; i < end; i++){
+                            double expected = find_distance_between_two_points(std::make_pair(positions[p], points[i]));
+                            CHECK(closeDistance(expected, distances[i - begin]));
+                        }
+                        //nothing written past the batch
+                        CHECK_EQUAL(-1, distances[BatchSizes[s]]);
+                    }
+                }
+            }
+        }
+        setDistanceKernelLimit(avx2Kernel);
+    }
+
+    TEST(nearest_matches_brute_force){
+        std::vector<distanceKernelLevel> kernels = availableKernels();
+        std::vector<LatLon> points = batchPoints(1025, 7);
+        latLonArrays arrays = toArrays(points);
+        std::vector<LatLon> queries = batchPoints(100, 8);
+
+        for (unsigned k = 0; k < kernels.size(); k++){
+            setDistanceKernelLimit(kernels[k]);
+            for (unsigned q = 0; q < queries.size(); q++){
+                std::vector<double> distances(points.size());
+                distancesToPoint(arrays, 0, points.size(), queries[q], distances.data());
+                unsigned nearest = std::min_element(distances.begin(), distances.end()) - distances.begin();
+
+                unsigned expected = 0;
+                double expectedDistance = find_distance_between_two_points(std::make_pair(queries[q], points[0]));
+                for (unsigned i = 1; i < points.size(); i++){
+                    double distance = find_distance_between_two_points(std::make_pair(queries[q], points[i]));
+                    if (distance < expectedDistance){
+                        expected = i;
+                        expectedDistance = distance;
+                    }
+                }
+                CHECK_EQUAL(expected, nearest);
+            }
+        }
+        setDistanceKernelLimit(avx2Kernel);
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ * File:   path_time_batch_tests.cpp
+ * Author: georg157
+ *
+ * Batch path times (compute_path_travel_times, compute_path_walking_times, compute_courier_route_travel_time) checked
+ * against times summed segment by segment from the StreetsDatabaseAPI (street and speed limit of each segment)
+ */
+
+#include <unittest++/UnitTest++.h>
+
+#include "unit_test_util.h"
+#include "m1.h"
+#include "m3.h"
+#include "m3A.h"
+#include "m4.h"
+#include "globals.h"
+#include "StreetsDatabaseAPI.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+struct PathsFixture : ece297test::MapFixture{
+    PathsFixture(){
+        //driving paths between pairs of intersections, empty paths among them
+        const std::vector<std::pair<int, int>> pairs = ece297test::driving_path_pairs();
+        for (unsigned i = 0; i < pairs.size(); i++){
+            paths.push_back(find_path_between_intersections(pairs[i].first, pairs[i].second, 15));
+            if (i % 3 == 0)
+                paths.push_back(std::vector<StreetSegmentIndex>());
+            if (!paths[0].empty())
+                paths.push_back(std::vector<StreetSegmentIndex>(1, paths[0][i % paths[0].size()]));
+        }
+    }
+
+    std::vector<std::vector<StreetSegmentIndex>> paths;
+};
+
+//Returns: time (seconds) to go along path, walking at walkingSpeed (m/s), or driving at the speed limits if walkingSpeed
+//is 0, with turnPenalty wherever the street changes
+double reference_time(const std::vector<StreetSegmentIndex>& path, double turnPenalty, double walkingSpeed){
+    double time = 0;
+    for (unsigned i = 0; i < path.size(); i++){
+        InfoStreetSegment segment = getInfoStreetSegment(path[i]);
+        if (i > 0 && getInfoStreetSegment(path[i - 1]).streetID != segment.streetID)
+            time += turnPenalty;
+
+        double speed = (walkingSpeed > 0) ? walkingSpeed : segment.speedLimit * 1000.0 / 3600.0;
+        time += find_street_segment_length(path[i]) / speed;
+    }
+    return time;
+}
+
+//Returns: true if a batch time agrees with the reference (1e-9 relative, or a nanosecond)
+bool closeTime(double expected, double found){
+    return std::fabs(expected - found) <= std::max(1e-9, 1e-9 * std::fabs(expected));
+}
+
+}
+
+SUITE(path_time_batch_tests){
+
+    //the batch (and scalar) functions read street IDs from SegmentStreetID, not the StreetsDatabaseAPI
+    TEST_FIXTURE(PathsFixture, segment_street_ids_match_database){
+        CHECK_EQUAL((unsigned) getNumStreetSegments(), SegmentStreetID.size());
+        for (int segmentID = 0; segmentID < getNumStreetSegments() && segmentID < (int) SegmentStreetID.size(); segmentID++){
+            CHECK_EQUAL(getInfoStreetSegment(segmentID).streetID, SegmentStreetID[segmentID]);
+        }
+    }
+
+    TEST_FIXTURE(PathsFixture, travel_times_match_reference){
+        const std::vector<double> turnPenalties = {0, 15, 27.5};
+        for (unsigned t = 0; t < turnPenalties.size(); t++){
+            std::vector<double> batch = compute_path_travel_times(paths, turnPenalties[t]);
+
+            CHECK_EQUAL(paths.size(), batch.size());
+            for (unsigned i = 0; i < paths.size() && i < batch.size(); i++){
+                CHECK(closeTime(reference_time(paths[i], turnPenalties[t], 0), batch[i]));
+            }
+        }
+    }
+
+    TEST_FIXTURE(PathsFixture, walking_times_match_reference){
+        const std::vector<std::pair<double, double>> speedsAndPenalties = {{1.4, 0}, {1.4, 15}, {3.75, 41}};
+        for (unsigned s = 0; s < speedsAndPenalties.size(); s++){
+            double walkingSpeed = speedsAndPenalties[s].first;
+            double turnPenalty = speedsAndPenalties[s].second;
+            std::vector<double> batch = compute_path_walking_times(paths, walkingSpeed, turnPenalty);
+
+            CHECK_EQUAL(paths.size(), batch.size());
+            for (unsigned i = 0; i < paths.size() && i < batch.size(); i++){
+                CHECK(closeTime(reference_time(paths[i], turnPenalty, walkingSpeed), batch[i]));
+            }
+        }
+    }
+
+    TEST_FIXTURE(PathsFixture, courier_route_matches_reference){
+        std::vector<CourierSubpath> route;
+        for (unsigned i = 0; i < paths.size(); i++){
+            CourierSubpath subpath;
+            subpath.subpath = paths[i];
+            route.push_back(subpath);
+        }
+
+        //no turn penalty between subpaths, each is timed on its own
+        double expected = 0;
+        for (unsigned i = 0; i < route.size(); i++){
+            expected += reference_time(route[i].subpath, 15, 0);
+        }
+        CHECK(closeTime(expected, compute_courier_route_travel_time(route, 15)));
+    }
+
+    TEST_FIXTURE(PathsFixture, empty_input){
+        CHECK(compute_path_travel_times(std::vector<std::vector<StreetSegmentIndex>>(), 15).empty());
+        CHECK(compute_path_walking_times(std::vector<std::vector<StreetSegmentIndex>>(), 1.4, 15).empty());
+        CHECK_EQUAL(0, compute_courier_route_travel_time(std::vector<CourierSubpath>(), 15));
+
+        //empty paths only
+        std::vector<std::vector<StreetSegmentIndex>> emptyPaths(5);
+        std::vector<double> travelTimes = compute_path_travel_times(emptyPaths, 15);
+        std::vector<double> walkingTimes = compute_path_walking_times(emptyPaths, 1.4, 15);
+        CHECK_EQUAL(5u, travelTimes.size());
+        CHECK_EQUAL(5u, walkingTimes.size());
+        for (unsigned i = 0; i < travelTimes.size() && i < walkingTimes.size(); i++){
+            CHECK_EQUAL(0, travelTimes[i]);
+            CHECK_EQUAL(0, walkingTimes[i]);
+        }
+    }
+}
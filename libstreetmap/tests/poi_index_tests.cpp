@@ -0,0 +1,154 @@
+/*
+ * File:   poi_index_tests.cpp
+ * Author: georg157
+ *
+ * poiIndex (2-d tree) queries checked against a brute force scan of the same points
+ */
+
+#include <unittest++/UnitTest++.h>
+
+#include "poiIndex.h"
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct poiPoints{
+    //Vector --> key: [poiID] value: [(x,y) metres]
+    std::vector<std::pair<double, double>> xy;
+    poiIndex index;
+
+    //numPoints random points in a 10 km square, some of them repeated (same place, different poiID)
+    poiPoints(unsigned numPoints, unsigned seed){
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> coordinate(-5000, 5000);
+        for (unsigned poiID = 0; poiID < numPoints; poiID++){
+            if (poiID % 10 == 9)
+                xy.push_back(xy[poiID / 2]);
+            else
+                xy.push_back(std::make_pair(coordinate(rng), coordinate(rng)));
+            index.insert(poiID, xy.back());
+        }
+        index.build();
+    }
+
+    double distanceSquared(int poiID, std::pair<double, double> query) const{
+        double dx = xy[poiID].first - query.first;
+        double dy = xy[poiID].second - query.second;
+        return dx * dx + dy * dy;
+    }
+
+    //Returns: squared distances from query to every point, closest first
+    std::vector<double> sortedDistances(std::pair<double, double> query) const{
+        std::vector<double> distances;
+        for (unsigned poiID = 0; poiID < xy.size(); poiID++){
+            distances.push_back(distanceSquared(poiID, query));
+        }
+        std::sort(distances.begin(), distances.end());
+        return distances;
+    }
+};
+
+//queries inside, on the edge of and outside the points' square
+std::vector<std::pair<double, double>> queryPoints(unsigned seed){
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coordinate(-7000, 7000);
+    std::vector<std::pair<double, double>> queries = {{0, 0}, {5000, 5000}, {-20000, 300}};
+    for (unsigned i = 0; i < 200; i++){
+        queries.push_back(std::make_pair(coordinate(rng), coordinate(rng)));
+    }
+    return queries;
+}
+
+}
+
+SUITE(poi_index_tests){
+
+    TEST(empty_index){
+        poiIndex index;
+        index.build();
+
+        CHECK_EQUAL(0u, index.size());
+        CHECK_EQUAL(-1, index.nearest(std::make_pair(0.0, 0.0)));
+        CHECK(index.kNearest(std::make_pair(0.0, 0.0), 5).empty());
+        CHECK(index.withinRadius(std::make_pair(0.0, 0.0), 1000).empty());
+    }
+
+    TEST(nearest_matches_brute_force){
+        poiPoints points(1000, 297);
+        std::vector<std::pair<double, double>> queries = queryPoints(1);
+
+        for (unsigned q = 0; q < queries.size(); q++){
+            int found = points.index.nearest(queries[q]);
+            CHECK(found >= 0 && found < (int) points.xy.size());
+            if (found < 0)
+                continue;
+
+            //ties may give either point, the distance must be the smallest
+            CHECK_EQUAL(points.sortedDistances(queries[q])[0], points.distanceSquared(found, queries[q]));
+        }
+    }
+
+    TEST(k_nearest_matches_brute_force){
+        poiPoints points(1000, 298);
+        std::vector<std::pair<double, double>> queries = queryPoints(2);
+        const std::vector<unsigned> ks = {1, 2, 7, 50, 999, 1000, 1500};
+
+        for (unsigned q = 0; q < queries.size(); q++){
+            std::vector<double> expected = points.sortedDistances(queries[q]);
+
+            for (unsigned i = 0; i < ks.size(); i++){
+                std::vector<int> found = points.index.kNearest(queries[q], ks[i]);
+                CHECK_EQUAL(std::min<std::size_t>(ks[i], points.xy.size()), found.size());
+
+                //closest first, and no point given twice
+                std::vector<int> unique = found;
+                std::sort(unique.begin(), unique.end());
+                CHECK(std::adjacent_find(unique.begin(), unique.end()) == unique.end());
+                for (unsigned j = 0; j < found.size() && j < expected.size(); j++){
+                    CHECK_EQUAL(expected[j], points.distanceSquared(found[j], queries[q]));
+                }
+            }
+        }
+    }
+
+    TEST(radius_matches_brute_force){
+        poiPoints points(1000, 299);
+        std::vector<std::pair<double, double>> queries = queryPoints(3);
+        const std::vector<double> radii = {0, 50, 400, 2500, 20000};
+
+        for (unsigned q = 0; q < queries.size(); q++){
+            for (unsigned i = 0; i < radii.size(); i++){
+                std::vector<int> expected;
+                for (unsigned poiID = 0; poiID < points.xy.size(); poiID++){
+                    if (points.distanceSquared(poiID, queries[q]) <= radii[i] * radii[i])
+                        expected.push_back(poiID);
+                }
+
+                std::vector<int> found = points.index.withinRadius(queries[q], radii[i]);
+                for (unsigned j = 1; j < found.size(); j++){
+                    CHECK(points.distanceSquared(found[j - 1], queries[q]) <= points.distanceSquared(found[j], queries[q]));
+                }
+
+                std::sort(found.begin(), found.end());
+                CHECK(expected == found);
+            }
+        }
+    }
+
+    TEST(radius_on_a_point){
+        poiIndex index;
+        index.insert(0, std::make_pair(0.0, 0.0));
+        index.insert(1, std::make_pair(30.0, 40.0));
+        index.insert(2, std::make_pair(100.0, 0.0));
+        index.build();
+
+        //a point exactly at the radius is inside
+        std::vector<int> found = index.withinRadius(std::make_pair(0.0, 0.0), 50);
+        CHECK(found == std::vector<int>({0, 1}));
+
+        CHECK(index.withinRadius(std::make_pair(0.0, 0.0), -1).empty());
+    }
+}
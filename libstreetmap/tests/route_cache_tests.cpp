@@ -0,0 +1,138 @@
+/*
+ * File:   route_cache_tests.cpp
+ * Author: georg157
+ *
+ * routeCache: LRU eviction, hit and miss counters, and paths only given whole (never parts of a longer path)
+ */
+
+#include <unittest++/UnitTest++.h>
+
+#include "unit_test_util.h"
+#include "routeCache.h"
+#include "m1.h"
+#include "m3.h"
+#include <vector>
+
+namespace {
+
+struct RouteFixture : ece297test::MapFixture{
+    RouteFixture(){
+        //a long path
+        start = ece297test::driving_path_pairs()[0].first;
+        end = ece297test::driving_path_pairs()[0].second;
+        path = find_path_between_intersections(start, end, turnPenalty);
+        travelTime = compute_path_travel_time(path, turnPenalty);
+        intersections = ece297test::path_intersections(start, path);
+    }
+
+    const double turnPenalty = 15;
+    int start;
+    int end;
+    std::vector<int> path;
+    double travelTime;
+
+    //Vector --> key: [segments before the intersection] value: [intersection ID]
+    std::vector<int> intersections;
+};
+
+}
+
+SUITE(route_cache_tests){
+
+    TEST(least_recently_used_is_evicted){
+        routeCache cache(3);
+        std::vector<int> path;
+        double travelTime;
+
+        //empty paths: no path exists
+        cache.insert(1, 2, 0, std::vector<int>(), 0);
+        cache.insert(3, 4, 0, std::vector<int>(), 0);
+        cache.insert(5, 6, 0, std::vector<int>(), 0);
+        CHECK_EQUAL(3u, cache.stats().entries);
+
+        //(1,2) is used, so (3,4) is now the oldest
+        CHECK(cache.find(1, 2, 0, path, travelTime));
+        cache.insert(7, 8, 0, std::vector<int>(), 0);
+
+        CHECK_EQUAL(3u, cache.stats().entries);
+        CHECK(!cache.find(3, 4, 0, path, travelTime));
+        CHECK(cache.find(1, 2, 0, path, travelTime));
+        CHECK(cache.find(5, 6, 0, path, travelTime));
+        CHECK(cache.find(7, 8, 0, path, travelTime));
+
+        //inserting a cached key again only makes it the newest
+        cache.insert(1, 2, 0, std::vector<int>(), 0);
+        cache.insert(9, 10, 0, std::vector<int>(), 0);
+        CHECK(!cache.find(5, 6, 0, path, travelTime));
+        CHECK(cache.find(1, 2, 0, path, travelTime));
+    }
+
+    TEST(hit_and_miss_counters){
+        routeCache cache(8);
+        std::vector<int> path;
+        double travelTime;
+
+        CHECK(!cache.find(1, 2, 5, path, travelTime));
+        cache.insert(1, 2, 5, std::vector<int>(), 42);
+        CHECK(cache.find(1, 2, 5, path, travelTime));
+        CHECK(path.empty());
+        CHECK_EQUAL(42, travelTime);
+
+        //the turn penalty is part of the key
+        CHECK(!cache.find(1, 2, 5.5, path, travelTime));
+        CHECK(!cache.find(2, 1, 5, path, travelTime));
+
+        routeCacheStats stats = cache.stats();
+        CHECK_EQUAL(1ul, stats.hits);
+        CHECK_EQUAL(3ul, stats.misses);
+        CHECK_EQUAL(1u, stats.entries);
+
+        cache.clear();
+        stats = cache.stats();
+        CHECK_EQUAL(0ul, stats.hits);
+        CHECK_EQUAL(0ul, stats.misses);
+        CHECK_EQUAL(0u, stats.entries);
+        CHECK(!cache.find(1, 2, 5, path, travelTime));
+    }
+
+    TEST_FIXTURE(RouteFixture, path_is_only_given_whole){
+        CHECK(path.size() >= 3);
+
+        routeCache cache;
+        cache.insert(start, end, turnPenalty, path, travelTime);
+
+        std::vector<int> part;
+        double partTime;
+        CHECK(cache.find(start, end, turnPenalty, part, partTime));
+        CHECK(path == part);
+        CHECK_EQUAL(travelTime, partTime);
+
+        //no prefix or suffix of the path answers a query
+        for (unsigned i = 1; i < path.size(); i++){
+            CHECK(!cache.find(start, intersections[i], turnPenalty, part, partTime));
+            CHECK(!cache.find(intersections[i], end, turnPenalty, part, partTime));
+        }
+        CHECK_EQUAL(1ul, cache.stats().hits);
+        CHECK_EQUAL(2ul * (path.size() - 1), cache.stats().misses);
+    }
+
+    TEST_FIXTURE(RouteFixture, evicted_path_is_forgotten){
+        routeCache cache(2);
+        cache.insert(start, end, turnPenalty, path, travelTime);
+        cache.insert(1, 2, turnPenalty, std::vector<int>(), 0);
+        cache.insert(3, 4, turnPenalty, std::vector<int>(), 0);
+        CHECK_EQUAL(2u, cache.stats().entries);
+
+        std::vector<int> found;
+        double foundTime;
+        CHECK(!cache.find(start, end, turnPenalty, found, foundTime));
+
+        //cached again, it is found again (and clear forgets it)
+        cache.insert(start, end, turnPenalty, path, travelTime);
+        CHECK(cache.find(start, end, turnPenalty, found, foundTime));
+        CHECK(path == found);
+
+        cache.clear();
+        CHECK(!cache.find(start, end, turnPenalty, found, foundTime));
+    }
+}
@@ -6,9 +6,12 @@
 #include <cmath>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "m1.h"
 #include "m3.h"
+#include "StreetsDatabaseAPI.h"
 
 #ifndef MAX_VEC_PRINT
 #define MAX_VEC_PRINT 200
@@ -103,6 +106,37 @@ auto sorted(Range&& r) -> decltype(std::forward<Range>(r)) {
     return std::forward<Range>(r);
 }
 
+//map the path tests run on
+const std::string TorontoMapPath = "/cad2/ece297s/public/maps/toronto_canada.streets.bin";
+
+//Loads the Toronto map for the length of a test (fixtures of the path tests derive from it)
+struct MapFixture {
+    MapFixture() {
+        load_map(TorontoMapPath);
+    }
+
+    ~MapFixture() {
+        close_map();
+    }
+};
+
+//Returns: (start, end) intersections of the Toronto map with driving paths between them, across town and short ones;
+//the path of the first pair is long and changes street several times
+inline std::vector<std::pair<int, int>> driving_path_pairs() {
+    return {{13864, 84826}, {50955, 114599}, {9037, 47950}, {108, 115},
+            {56819, 91575}, {70817, 46762}, {128368, 75909}, {7107, 38918}};
+}
+
+//Returns: intersections along path (segment IDs leaving startID), startID first
+inline std::vector<int> path_intersections(int startID, const std::vector<int>& path) {
+    std::vector<int> intersections(1, startID);
+    for (size_t i = 0; i < path.size(); i++) {
+        InfoStreetSegment segment = getInfoStreetSegment(path[i]);
+        intersections.push_back(segment.from == intersections.back() ? segment.to : segment.from);
+    }
+    return intersections;
+}
+
 }
 
 #ifdef ECE297_TIME_CONSTRAINT
@@ -20,13 +20,18 @@
  */
 #include <iostream>
 #include <string>
+#include <cstdlib>
+#include <unistd.h>
 #include "m1.h"
+#include "m1A.h"
 #include "m2.h" //should this be included, since drawMap.cpp must include it too
 #include "drawMap.h"
 #include "globals.h"
 #include "m3.h"
 #include "m3A.h"
 #include "m4.h"
+#include "pngTiles.h"
+#include "queryServer.h"
 
 //Program exit codes
 constexpr int SUCCESS_EXIT_CODE = 0;        //Everyting went OK
@@ -38,8 +43,112 @@ std::string default_map_path = "toronto_canada";
 std::string path_directory = "/cad2/ece297s/public/maps/";
 std::string file_type = ".streets.bin";
 
+//Headless mode: loads a map and writes PNG web map tiles for a box and zoom range (no window needed)
+//Usage: --tiles <map> <output_dir> <south_lat> <west_lon> <north_lat> <east_lon> <min_zoom> <max_zoom>
+static int render_tiles_main(int argc, char** argv) {
+    
+    if (argc != 10) {
+        std::cerr << "Usage: " << argv[0] << " --tiles <map> <output_dir> <south_lat> <west_lon> <north_lat> <east_lon> <min_zoom> <max_zoom>\n";
+        return BAD_ARGUMENTS_EXIT_CODE;
+    }
+    
+    std::string map_path = argv[2];
+    bool load_success = load_map(path_directory + map_path + file_type);
+    if(!load_success) {
+        std::cerr << "Failed to load map '" << path_directory<<map_path<<file_type<< "'\n";
+        return ERROR_EXIT_CODE;
+    }
+    
+    populateDrawingData();
+    
+    int tiles = render_png_tiles(argv[3], LatLon(std::atof(argv[4]), std::atof(argv[5])), 
+                                 LatLon(std::atof(argv[6]), std::atof(argv[7])), std::atoi(argv[8]), std::atoi(argv[9]));
+    
+    close_map();
+    
+    if (tiles < 0) {
+        std::cerr << "Invalid box or zoom range, or output directory could not be created\n";
+        return BAD_ARGUMENTS_EXIT_CODE;
+    }
+    return SUCCESS_EXIT_CODE;
+}
+
+//Headless mode: loads a map once, then answers routing requests (see queryServer.h) until "quit"
+//Requests are read from stdin (responses on stdout), or from the clients of a Unix domain socket
+//Usage: --serve <map> [threads] [socket_path|-] [speed_profiles.csv]   ("-": stdin, threads: 1 to MAX_QUERY_THREADS)
+static int serve_main(int argc, char** argv) {
+    
+    if (argc < 3 || argc > 6) {
+        std::cerr << "Usage: " << argv[0] << " --serve <map> [threads] [socket_path|-] [speed_profiles.csv]\n";
+        return BAD_ARGUMENTS_EXIT_CODE;
+    }
+    
+    //threads not given: one per core
+    unsigned threads = 0;
+    if (argc >= 4) {
+        char* end;
+        long requested = std::strtol(argv[3], &end, 10);
+        if (*argv[3] == '\0' || *end != '\0' || requested < 1 || requested > MAX_QUERY_THREADS) {
+            std::cerr << "Invalid thread count '" << argv[3] << "' (1 to " << MAX_QUERY_THREADS << ")\n";
+            return BAD_ARGUMENTS_EXIT_CODE;
+        }
+        threads = requested;
+    }
+    
+    //with stdin, stdout only carries responses: it is kept on another descriptor, and everything else printed
+    //to stdout (load_map, the m1 functions' messages) goes to stderr
+    bool useStdin = (argc < 5 || std::string(argv[4]) == "-");
+    int responseFd = STDOUT_FILENO;
+    if (useStdin) {
+        std::cout.flush();
+        responseFd = dup(STDOUT_FILENO);
+        if (responseFd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+            std::cerr << "Could not redirect stdout\n";
+            return ERROR_EXIT_CODE;
+        }
+    }
+    
+    std::string map_path = argv[2];
+    bool load_success = load_map(path_directory + map_path + file_type);
+    if(!load_success) {
+        std::cerr << "Failed to load map '" << path_directory<<map_path<<file_type<< "'\n";
+        return ERROR_EXIT_CODE;
+    }
+    std::cerr << "Successfully loaded map '" <<path_directory<<map_path<<file_type<< "'\n";
+    
+    if (argc == 6 && !load_speed_profiles(argv[5])) {
+        close_map();
+        return ERROR_EXIT_CODE;
+    }
+    
+    int exit_code = SUCCESS_EXIT_CODE;
+    {
+        queryServer server(threads);
+        
+        if (!useStdin) {
+            if (!server.serveSocket(argv[4]))
+                exit_code = ERROR_EXIT_CODE;
+        } else {
+            server.serveStream(STDIN_FILENO, responseFd);
+        }
+    }
+    
+    close_map();
+    if (useStdin)
+        close(responseFd);
+    return exit_code;
+}
+
 int main(int argc, char** argv) {
     
+    if(argc >= 2 && std::string(argv[1]) == "--tiles") {
+        return render_tiles_main(argc, argv);
+    }
+    
+    if(argc >= 2 && std::string(argv[1]) == "--serve") {
+        return serve_main(argc, argv);
+    }
+    
     std::string map_path;   
     if(argc == 1) {
         //Use a default map
@@ -51,6 +160,10 @@ int main(int argc, char** argv) {
         //Invalid arguments
         std::cerr << "Usage: " << argv[0] << " [map_file_path]\n";
         std::cerr << "  If no map_file_path is provided a default map is loaded.\n";
+        std::cerr << "       " << argv[0] << " --tiles <map> <output_dir> <south_lat> <west_lon> <north_lat> <east_lon> <min_zoom> <max_zoom>\n";
+        std::cerr << "  Writes PNG map tiles without opening a window.\n";
+        std::cerr << "       " << argv[0] << " --serve <map> [threads] [socket_path|-] [speed_profiles.csv]\n";
+        std::cerr << "  Answers routing requests from stdin, or a Unix domain socket, without opening a window.\n";
         return BAD_ARGUMENTS_EXIT_CODE;
     }
 